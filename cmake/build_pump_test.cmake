@@ -6,6 +6,8 @@
 #   build_test_project("test_transport")
 #   build_test_project("test_simple")
 #   build_test_project("test_timer")
+#   build_test_project("test_bench")
+#   build_test_project("test_dispatch")
 #
 
 MACRO(build_test_project NAME)
@@ -43,4 +45,6 @@ IF(WITH_TEST)
     build_test_project("test_timer")
     build_test_project("test_http")
     build_test_project("test_ws")
+    build_test_project("test_bench")
+    build_test_project("test_dispatch")
 ENDIF()
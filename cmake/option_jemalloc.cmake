@@ -1,6 +1,7 @@
 #
 # Export variables:
 #   JEMALLOC_LIBRARY - jemalloc library link path
+#   pump_WITH_MEMORY_ACCOUNTING - memory accounting config
 #
 
 IF(WITH_JEMALLOC)
@@ -15,3 +16,10 @@ IF(WITH_JEMALLOC)
 ELSE()
 	SET(pump_WITH_JEMALLOC "WITHOUT_JEMALLOC")
 ENDIF()
+
+IF(WITH_MEMORY_ACCOUNTING)
+	SET(pump_WITH_MEMORY_ACCOUNTING "WITH_MEMORY_ACCOUNTING")
+	MESSAGE(STATUS "Memory accounting: ON")
+ELSE()
+	SET(pump_WITH_MEMORY_ACCOUNTING "WITHOUT_MEMORY_ACCOUNTING")
+ENDIF()
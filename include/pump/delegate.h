@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef pump_delegate_h
+#define pump_delegate_h
+
+#include <utility>
+#include <type_traits>
+
+#include "pump/debug.h"
+#include "pump/memory.h"
+#include "pump/platform.h"
+
+// Default inline capacity of delegate, a member function bound with a smart pointer
+// and two placeholders fits in it.
+#if !defined(PUMP_DELEGATE_INLINE_SIZE)
+#define PUMP_DELEGATE_INLINE_SIZE 48
+#endif
+
+namespace pump {
+
+    /*********************************************************************************
+     * Delegate operations
+     * Every functor type has a static operation table, so delegate needs no RTTI.
+     ********************************************************************************/
+    template <typename R, typename... Args>
+    struct delegate_ops {
+        // Invoke functor
+        R (*invoke)(void *storage, Args&&... args);
+        // Copy functor to empty storage, return false if allocating failed
+        bool (*copy)(void *dst, const void *src);
+        // Move functor to empty storage and destroy source functor
+        void (*move)(void *dst, void *src);
+        // Destroy functor
+        void (*destroy)(void *storage);
+    };
+
+    /*********************************************************************************
+     * Delegate handler
+     * Small functor is stored in delegate storage, others are stored in heap memory
+     * and delegate storage keeps the pointer.
+     ********************************************************************************/
+    template <typename F, bool Inline>
+    struct delegate_handler {
+        PUMP_INLINE static F* get(void *storage) {
+            return (F*)storage;
+        }
+
+        PUMP_INLINE static const F* get(const void *storage) {
+            return (const F*)storage;
+        }
+
+        template <typename Fn>
+        PUMP_INLINE static bool create(void *storage, Fn &&f) {
+            new (storage) F(std::forward<Fn>(f));
+            return true;
+        }
+
+        static void move(void *dst, void *src) {
+            F *f = get(src);
+            new (dst) F(std::move(*f));
+            f->~F();
+        }
+
+        static void destroy(void *storage) {
+            get(storage)->~F();
+        }
+    };
+
+    template <typename F>
+    struct delegate_handler<F, false> {
+        PUMP_INLINE static F* get(void *storage) {
+            return *(F**)storage;
+        }
+
+        PUMP_INLINE static const F* get(const void *storage) {
+            return *(F* const*)storage;
+        }
+
+        template <typename Fn>
+        PUMP_INLINE static bool create(void *storage, Fn &&f) {
+            F *p = (F*)pump_malloc(sizeof(F));
+            if (PUMP_UNLIKELY(p == nullptr)) {
+                return false;
+            }
+            *(F**)storage = new (p) F(std::forward<Fn>(f));
+            return true;
+        }
+
+        static void move(void *dst, void *src) {
+            *(F**)dst = *(F**)src;
+        }
+
+        static void destroy(void *storage) {
+            F *f = get(storage);
+            f->~F();
+            pump_free(f);
+        }
+    };
+
+    template <typename Signature, size_t Capacity = PUMP_DELEGATE_INLINE_SIZE>
+    class delegate;
+
+    /*********************************************************************************
+     * Delegate
+     * It is a callable wrapper like std::function, but it stores functors up to the
+     * capacity without allocating and needs no RTTI. Delegates are copied everywhere,
+     * such as callbacks copied into transports, so functors must be copyable.
+     ********************************************************************************/
+    template <typename R, typename... Args, size_t Capacity>
+    class delegate<R(Args...), Capacity> {
+
+      private:
+        // Operations type
+        typedef delegate_ops<R, Args...> ops_type;
+
+        // Storage type, it keeps pointer alignment, so objects holding delegates are
+        // not over aligned. Over aligned functors are stored in heap memory.
+        typedef typename std::aligned_storage<
+            (Capacity < sizeof(void*) ? sizeof(void*) : Capacity),
+            alignof(void*)>::type storage_type;
+
+        // Functor is stored in delegate storage or not
+        template <typename F>
+        struct is_inline
+          : std::integral_constant<bool,
+                                   sizeof(F) <= sizeof(storage_type) &&
+                                   alignof(F) <= alignof(storage_type) &&
+                                   std::is_nothrow_move_constructible<F>::value> {
+        };
+
+        // Functor type of delegate constructing
+        template <typename Fn>
+        using functor_type = typename std::decay<Fn>::type;
+
+        // Enable constructing from the callable type
+        template <typename Fn>
+        using enable_if_functor = typename std::enable_if<
+            !std::is_same<functor_type<Fn>, delegate>::value &&
+            !std::is_same<functor_type<Fn>, std::nullptr_t>::value>::type;
+
+      public:
+        // Result type
+        typedef R result_type;
+
+      public:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        delegate() noexcept
+          : ops_(nullptr) {
+        }
+        delegate(std::nullptr_t) noexcept
+          : ops_(nullptr) {
+        }
+        template <typename Fn, typename = enable_if_functor<Fn>>
+        delegate(Fn &&f)
+          : ops_(nullptr) {
+            __create(std::forward<Fn>(f));
+        }
+
+        /*********************************************************************************
+         * Copy constructor
+         ********************************************************************************/
+        delegate(const delegate &other)
+          : ops_(nullptr) {
+            __copy(other);
+        }
+
+        /*********************************************************************************
+         * Move constructor
+         ********************************************************************************/
+        delegate(delegate &&other) noexcept
+          : ops_(nullptr) {
+            __move(other);
+        }
+
+        /*********************************************************************************
+         * Deconstructor
+         ********************************************************************************/
+        ~delegate() {
+            __reset();
+        }
+
+        /*********************************************************************************
+         * Assign operator
+         ********************************************************************************/
+        delegate& operator=(const delegate &other) {
+            if (this != &other) {
+                __reset();
+                __copy(other);
+            }
+            return *this;
+        }
+        delegate& operator=(delegate &&other) noexcept {
+            if (this != &other) {
+                __reset();
+                __move(other);
+            }
+            return *this;
+        }
+        delegate& operator=(std::nullptr_t) noexcept {
+            __reset();
+            return *this;
+        }
+        template <typename Fn, typename = enable_if_functor<Fn>>
+        delegate& operator=(Fn &&f) {
+            // Functor may be owned by current delegate, so create a new one first.
+            delegate tmp(std::forward<Fn>(f));
+            __reset();
+            __move(tmp);
+            return *this;
+        }
+
+        /*********************************************************************************
+         * Invoke
+         ********************************************************************************/
+        PUMP_INLINE R operator()(Args... args) const {
+            PUMP_ASSERT(ops_ != nullptr);
+            return ops_->invoke(&storage_, std::forward<Args>(args)...);
+        }
+
+        /*********************************************************************************
+         * Check delegate is empty or not
+         ********************************************************************************/
+        PUMP_INLINE explicit operator bool() const noexcept {
+            return ops_ != nullptr;
+        }
+
+        /*********************************************************************************
+         * Swap
+         ********************************************************************************/
+        void swap(delegate &other) noexcept {
+            delegate tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+      private:
+        /*********************************************************************************
+         * Check functor is null or not
+         ********************************************************************************/
+        template <typename F>
+        PUMP_INLINE static bool __is_null(F *f) {
+            return f == nullptr;
+        }
+        template <typename F, typename C>
+        PUMP_INLINE static bool __is_null(F C::*f) {
+            return f == nullptr;
+        }
+        template <typename F>
+        PUMP_INLINE static bool __is_null(const F &) {
+            return false;
+        }
+
+        /*********************************************************************************
+         * Invoke functor
+         ********************************************************************************/
+        template <typename F>
+        static R __invoke(void *storage, Args&&... args) {
+            typedef delegate_handler<F, is_inline<F>::value> handler;
+            return static_cast<R>((*handler::get(storage))(std::forward<Args>(args)...));
+        }
+
+        /*********************************************************************************
+         * Copy functor
+         ********************************************************************************/
+        template <typename F>
+        static bool __copy_functor(void *dst, const void *src) {
+            typedef delegate_handler<F, is_inline<F>::value> handler;
+            return handler::create(dst, *handler::get(src));
+        }
+
+        /*********************************************************************************
+         * Operations of functor type
+         ********************************************************************************/
+        template <typename F>
+        struct functor_ops {
+            static const ops_type value;
+        };
+
+        /*********************************************************************************
+         * Create functor
+         ********************************************************************************/
+        template <typename Fn>
+        PUMP_INLINE void __create(Fn &&f) {
+            typedef functor_type<Fn> F;
+            static_assert(std::is_copy_constructible<F>::value,
+                          "delegate functor must be copy constructible");
+            if (__is_null(f)) {
+                return;
+            }
+            if (delegate_handler<F, is_inline<F>::value>::create(&storage_, std::forward<Fn>(f))) {
+                ops_ = &functor_ops<F>::value;
+            }
+        }
+
+        /*********************************************************************************
+         * Copy from other delegate
+         * Current delegate keeps empty if allocating failed.
+         ********************************************************************************/
+        PUMP_INLINE void __copy(const delegate &other) {
+            if (other.ops_ == nullptr) {
+                return;
+            }
+            if (PUMP_UNLIKELY(!other.ops_->copy(&storage_, &other.storage_))) {
+                PUMP_WARN_LOG("delegate: copy failed for allocating failed");
+                return;
+            }
+            ops_ = other.ops_;
+        }
+
+        /*********************************************************************************
+         * Move from other delegate
+         ********************************************************************************/
+        PUMP_INLINE void __move(delegate &other) noexcept {
+            if (other.ops_ != nullptr) {
+                other.ops_->move(&storage_, &other.storage_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+
+        /*********************************************************************************
+         * Reset
+         ********************************************************************************/
+        PUMP_INLINE void __reset() noexcept {
+            if (ops_ != nullptr) {
+                ops_->destroy(&storage_);
+                ops_ = nullptr;
+            }
+        }
+
+      private:
+        // Functor storage
+        mutable storage_type storage_;
+        // Functor operations
+        const ops_type *ops_;
+    };
+
+    template <typename R, typename... Args, size_t Capacity>
+    template <typename F>
+    const typename delegate<R(Args...), Capacity>::ops_type
+        delegate<R(Args...), Capacity>::functor_ops<F>::value = {
+            &delegate<R(Args...), Capacity>::template __invoke<F>,
+            &delegate<R(Args...), Capacity>::template __copy_functor<F>,
+            &delegate_handler<F, delegate<R(Args...), Capacity>::template is_inline<F>::value>::move,
+            &delegate_handler<F, delegate<R(Args...), Capacity>::template is_inline<F>::value>::destroy
+        };
+
+}  // namespace pump
+
+#endif
@@ -19,8 +19,10 @@
 
 #include <functional>
 
+#include "pump/delegate.h"
+
 #define pump_bind std::bind
-#define pump_function std::function
+#define pump_function pump::delegate
 
 using namespace std::placeholders;
 
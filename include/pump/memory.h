@@ -26,13 +26,110 @@
 
 // Import "malloc"
 #include <stdlib.h>
+// Import "uint64_t"
+#include <stdint.h>
+
+// Import "std::mutex"
+#include <mutex>
+// Import "std::atomic"
+#include <atomic>
+// Import "std::is_same"
+#include <type_traits>
 
 #if defined(PUMP_HAVE_JEMALLOC)
 #define JEMALLOC_NO_RENAME
 #include <jemalloc/jemalloc.h>
 #endif
 
-#if defined(PUMP_HAVE_JEMALLOC)
+namespace pump {
+
+    /*********************************************************************************
+     * Memory tags
+     * Memory allocated by pump_malloc is accounted to the memory tag of current thread.
+     ********************************************************************************/
+    enum memory_tag {
+        MEMORY_TAG_OTHER = 0,
+        MEMORY_TAG_POLLER,
+        MEMORY_TAG_TRANSPORT,
+        MEMORY_TAG_TLS,
+        MEMORY_TAG_HTTP,
+        MEMORY_TAG_WEBSOCKET,
+        MEMORY_TAG_TIMER,
+        MEMORY_TAG_COUNT
+    };
+
+    /*********************************************************************************
+     * Memory statistics
+     ********************************************************************************/
+    struct memory_stats {
+        // Allocation count
+        uint64_t alloc_count;
+        // Free count
+        uint64_t free_count;
+        // Allocated bytes
+        uint64_t alloc_bytes;
+        // Freed bytes
+        uint64_t free_bytes;
+    };
+
+    /*********************************************************************************
+     * Get memory statistics of the tag
+     * Return false if pump is built without memory accounting.
+     ********************************************************************************/
+    LIB_PUMP bool get_memory_stats(memory_tag tag, memory_stats &stats);
+
+    /*********************************************************************************
+     * Get memory tag name
+     ********************************************************************************/
+    LIB_PUMP const char* get_memory_tag_name(memory_tag tag);
+
+#if defined(PUMP_HAVE_MEMORY_ACCOUNTING)
+    /*********************************************************************************
+     * Set memory tag of current thread
+     * Return the previous memory tag.
+     ********************************************************************************/
+    LIB_PUMP memory_tag set_memory_tag(memory_tag tag);
+
+    /*********************************************************************************
+     * Accounted memory functions
+     * They prepend a header to record size and tag of every allocation, and count it
+     * in lock free counters of current thread.
+     ********************************************************************************/
+    LIB_PUMP void* accounted_malloc(size_t size);
+    LIB_PUMP void* accounted_realloc(void *p, size_t size);
+    LIB_PUMP void accounted_free(void *p);
+
+    /*********************************************************************************
+     * Memory tag scope
+     * It sets memory tag of current thread, and restores the previous tag at leaving.
+     ********************************************************************************/
+    class memory_tag_scope {
+
+      public:
+        memory_tag_scope(memory_tag tag) noexcept
+          : prev_(set_memory_tag(tag)) {
+        }
+
+        ~memory_tag_scope() {
+            set_memory_tag(prev_);
+        }
+
+      private:
+        memory_tag_scope(const memory_tag_scope &) = delete;
+        memory_tag_scope &operator=(const memory_tag_scope &) = delete;
+
+      private:
+        memory_tag prev_;
+    };
+#endif
+
+}  // namespace pump
+
+#if defined(PUMP_HAVE_MEMORY_ACCOUNTING)
+#define pump_free pump::accounted_free
+#define pump_malloc pump::accounted_malloc
+#define pump_realloc pump::accounted_realloc
+#elif defined(PUMP_HAVE_JEMALLOC)
 #define pump_free je_free
 #define pump_malloc je_malloc
 #define pump_realloc je_realloc
@@ -42,9 +139,310 @@
 #define pump_realloc realloc
 #endif
 
+// Account memory allocated in current scope to the tag
+#if defined(PUMP_HAVE_MEMORY_ACCOUNTING)
+#define PUMP_MEMORY_TAG_SCOPE(tag) pump::memory_tag_scope pump_memory_tag_scope(tag)
+#else
+#define PUMP_MEMORY_TAG_SCOPE(tag)
+#endif
+
+namespace pump {
+
+    /*********************************************************************************
+     * Object pool statistics
+     * Counts of thread caches are merged when they move batches or threads exit.
+     ********************************************************************************/
+    struct object_pool_stats {
+        // Allocated object count
+        uint64_t alloc_count;
+        // Freed object count
+        uint64_t free_count;
+        // Object count allocated from system
+        uint64_t system_alloc_count;
+        // Object count freed to system
+        uint64_t system_free_count;
+        // Batch count moved between thread caches and central list
+        uint64_t transfer_count;
+    };
+
+    /*********************************************************************************
+     * Object pool
+     * Every thread caches free objects of the type in a local list. When the local
+     * list is too long, a batch of objects moves to the central list, and when the
+     * local list is empty, it takes a batch from the central list. So objects freed
+     * by one thread can be allocated by another thread. Central list caches limited
+     * batches, more objects are freed to system.
+     ********************************************************************************/
+    template <typename T>
+    class object_pool {
+
+      public:
+        // Object count of one batch
+        constexpr static int32_t BATCH_SIZE = 32;
+        // Max batch count of central list
+        constexpr static int32_t MAX_CENTRAL_BATCHES = 64;
+
+      public:
+        /*********************************************************************************
+         * Allocate memory of an object
+         ********************************************************************************/
+        PUMP_INLINE static void* allocate() {
+            local_cache &cache = __local();
+            free_node *node = cache.head;
+            if (PUMP_LIKELY(node != nullptr)) {
+                cache.head = node->next;
+                cache.count--;
+                cache.alloc_count++;
+                return node;
+            }
+            return __allocate_slow(cache);
+        }
+
+        /*********************************************************************************
+         * Free memory of an object
+         ********************************************************************************/
+        PUMP_INLINE static void deallocate(void *p) {
+            local_cache &cache = __local();
+            free_node *node = (free_node*)p;
+            node->next = cache.head;
+            cache.head = node;
+            cache.free_count++;
+            if (PUMP_UNLIKELY(++cache.count >= BATCH_SIZE * 2)) {
+                __release_batch(cache);
+            }
+        }
+
+        /*********************************************************************************
+         * Get statistics
+         ********************************************************************************/
+        static object_pool_stats get_stats() {
+            central_list &central = __central();
+            object_pool_stats stats;
+            stats.alloc_count = central.alloc_count.load(std::memory_order_relaxed);
+            stats.free_count = central.free_count.load(std::memory_order_relaxed);
+            stats.system_alloc_count = central.system_alloc_count.load(std::memory_order_relaxed);
+            stats.system_free_count = central.system_free_count.load(std::memory_order_relaxed);
+            stats.transfer_count = central.transfer_count.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+      private:
+        // Free node is stored in memory of freed object.
+        struct free_node {
+            free_node *next;
+            free_node *next_batch;
+        };
+
+        // Memory block size of an object
+        constexpr static size_t BLOCK_SIZE =
+            sizeof(T) > sizeof(free_node) ? sizeof(T) : sizeof(free_node);
+
+        // Central list
+        struct central_list {
+            central_list()
+              : batches(nullptr),
+                batch_count(0),
+                alloc_count(0),
+                free_count(0),
+                system_alloc_count(0),
+                system_free_count(0),
+                transfer_count(0) {
+            }
+            std::mutex mx;
+            free_node *batches;
+            int32_t batch_count;
+            std::atomic<uint64_t> alloc_count;
+            std::atomic<uint64_t> free_count;
+            std::atomic<uint64_t> system_alloc_count;
+            std::atomic<uint64_t> system_free_count;
+            std::atomic<uint64_t> transfer_count;
+        };
+
+        // Thread local cache
+        struct local_cache {
+            local_cache()
+              : head(nullptr),
+                count(0),
+                alloc_count(0),
+                free_count(0) {
+            }
+            ~local_cache() {
+                while (count >= BATCH_SIZE) {
+                    __release_batch(*this);
+                }
+                __free_list(head);
+                __flush_stats(*this);
+                // Objects freed later in thread exiting are cached in empty list.
+                head = nullptr;
+                count = 0;
+            }
+            free_node *head;
+            int32_t count;
+            uint64_t alloc_count;
+            uint64_t free_count;
+        };
+
+        /*********************************************************************************
+         * Get central list
+         * Central list is never destructed, so threads exiting late can still use it.
+         ********************************************************************************/
+        PUMP_INLINE static central_list& __central() {
+            static central_list *central = new (pump_malloc(sizeof(central_list))) central_list;
+            return *central;
+        }
+
+        /*********************************************************************************
+         * Get thread local cache
+         ********************************************************************************/
+        PUMP_INLINE static local_cache& __local() {
+            static thread_local local_cache cache;
+            return cache;
+        }
+
+        /*********************************************************************************
+         * Flush statistics of local cache
+         ********************************************************************************/
+        static void __flush_stats(local_cache &cache) {
+            central_list &central = __central();
+            central.alloc_count.fetch_add(cache.alloc_count, std::memory_order_relaxed);
+            central.free_count.fetch_add(cache.free_count, std::memory_order_relaxed);
+            cache.alloc_count = 0;
+            cache.free_count = 0;
+        }
+
+        /*********************************************************************************
+         * Free node list to system
+         ********************************************************************************/
+        static void __free_list(free_node *node) {
+            uint64_t count = 0;
+            while (node != nullptr) {
+                free_node *next = node->next;
+                pump_free(node);
+                node = next;
+                count++;
+            }
+            __central().system_free_count.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        /*********************************************************************************
+         * Allocate when local cache is empty
+         ********************************************************************************/
+        static void* __allocate_slow(local_cache &cache) {
+            central_list &central = __central();
+            __flush_stats(cache);
+            {
+                std::lock_guard<std::mutex> lock(central.mx);
+                free_node *batch = central.batches;
+                if (batch != nullptr) {
+                    central.batches = batch->next_batch;
+                    central.batch_count--;
+                    cache.head = batch->next;
+                    cache.count = BATCH_SIZE - 1;
+                    cache.alloc_count++;
+                    central.transfer_count.fetch_add(1, std::memory_order_relaxed);
+                    return batch;
+                }
+            }
+            void *p = pump_malloc(BLOCK_SIZE);
+            if (PUMP_LIKELY(p != nullptr)) {
+                cache.alloc_count++;
+                central.system_alloc_count.fetch_add(1, std::memory_order_relaxed);
+            }
+            return p;
+        }
+
+        /*********************************************************************************
+         * Move a batch from local cache to central list
+         ********************************************************************************/
+        static void __release_batch(local_cache &cache) {
+            free_node *batch = cache.head;
+            free_node *last = batch;
+            for (int32_t i = 1; i < BATCH_SIZE; i++) {
+                last = last->next;
+            }
+            cache.head = last->next;
+            cache.count -= BATCH_SIZE;
+            last->next = nullptr;
+
+            central_list &central = __central();
+            __flush_stats(cache);
+            {
+                std::lock_guard<std::mutex> lock(central.mx);
+                if (central.batch_count < MAX_CENTRAL_BATCHES) {
+                    batch->next_batch = central.batches;
+                    central.batches = batch;
+                    central.batch_count++;
+                    central.transfer_count.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            __free_list(batch);
+        }
+    };
+
+    template <typename>
+    struct object_pool_void {
+        typedef void type;
+    };
+
+    /*********************************************************************************
+     * Object pool enabled trait
+     * Type enables object pool by PUMP_ENABLE_OBJECT_POOL in its public section. Derived
+     * type does not inherit it. Defining PUMP_WITHOUT_OBJECT_POOL disables all pools,
+     * such as for memory checking tools.
+     ********************************************************************************/
+    template <typename T, typename = void>
+    struct object_pool_enabled
+      : std::false_type {
+    };
+
+#if !defined(PUMP_WITHOUT_OBJECT_POOL)
+    template <typename T>
+    struct object_pool_enabled<T, typename object_pool_void<typename T::pump_object_pool_type>::type>
+      : std::is_same<typename T::pump_object_pool_type, T> {
+    };
+#endif
+
+}  // namespace pump
+
+// Enable object pool of the type, object must be created and deleted as the type.
+#define PUMP_ENABLE_OBJECT_POOL(TYPE) typedef TYPE pump_object_pool_type
+
+template <typename T>
+PUMP_INLINE void *__object_alloc(std::true_type) {
+    return pump::object_pool<T>::allocate();
+}
+
+template <typename T>
+PUMP_INLINE void *__object_alloc(std::false_type) {
+    return pump_malloc(sizeof(T));
+}
+
+template <typename T>
+PUMP_INLINE void __object_free(void *p, std::true_type) {
+    pump::object_pool<T>::deallocate(p);
+}
+
+template <typename T>
+PUMP_INLINE void __object_free(void *p, std::false_type) {
+    pump_free(p);
+}
+
+// Allocate memory of an object, it uses object pool if the type enables.
+template <typename T>
+PUMP_INLINE void *object_alloc() {
+    return __object_alloc<T>(pump::object_pool_enabled<T>());
+}
+
+// Free memory of an object, it uses object pool if the type enables.
+template <typename T>
+PUMP_INLINE void object_free(void *p) {
+    __object_free<T>(p, pump::object_pool_enabled<T>());
+}
+
 template <typename T, typename... ArgTypes>
 PUMP_INLINE T *object_create(ArgTypes... args) {
-    T *p = (T*)pump_malloc(sizeof(T));
+    T *p = (T*)object_alloc<T>();
     if (PUMP_UNLIKELY(p == nullptr)) {
         return nullptr;
     }
@@ -53,7 +451,7 @@ PUMP_INLINE T *object_create(ArgTypes... args) {
 
 // Inline object create
 #define INLINE_OBJECT_CREATE(obj, TYPE, args)      \
-    TYPE *obj = (TYPE*)pump_malloc(sizeof(TYPE)); \
+    TYPE *obj = (TYPE*)object_alloc<TYPE>();        \
     if (PUMP_UNLIKELY(obj != nullptr)) {           \
         new (obj) TYPE args;                       \
     }
@@ -66,14 +464,14 @@ PUMP_INLINE void object_delete(T *obj) {
     // Deconstruct object
     obj->~T();
     // Free memory
-    pump_free(obj);
+    object_free<T>(obj);
 }
 
 // Inline object create
 #define INLINE_OBJECT_DELETE(obj, TYPE) \
     if (PUMP_LIKELY(obj != nullptr)) {  \
         obj->~TYPE();                   \
-        pump_free(obj);                 \
+        object_free<TYPE>(obj);         \
     }
 
 // Try to lock shared pointer and store to raw pointor
@@ -150,6 +150,28 @@ namespace net {
                     struct sockaddr *addr, 
                     int32_t addrlen);
 
+    /*********************************************************************************
+     * Datagram for batch sending
+     ********************************************************************************/
+    struct datagram {
+        // Datagram data
+        const block_t *b;
+        // Datagram data size
+        int32_t size;
+        // Datagram destination address
+        struct sockaddr *addr;
+        // Datagram destination address size
+        int32_t addrlen;
+    };
+
+    /*********************************************************************************
+     * Sendto in batch
+     * On linux all datagrams are sent by one sendmmsg call, other systems fall back
+     * to sending them one by one. Return sent datagram count, -1 if the first datagram
+     * would block or 0 if sending the first datagram failed.
+     ********************************************************************************/
+    int32_t send_to_batch(pump_socket fd, datagram *dgs, int32_t count);
+
     /*********************************************************************************
      * Close the ability of writing
      ********************************************************************************/
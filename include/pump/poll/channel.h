@@ -148,6 +148,9 @@ namespace poll {
       : public toolkit::noncopyable {
 
       public:
+        // Objects are allocated from object pool
+        PUMP_ENABLE_OBJECT_POOL(channel_tracker);
+
         /*********************************************************************************
          * Constructor
          ********************************************************************************/
@@ -57,6 +57,11 @@ namespace poll {
          ********************************************************************************/
         virtual void __poll(int32_t timeout) override;
 
+        /*********************************************************************************
+         * Wakeup polling
+         ********************************************************************************/
+        virtual void __wakeup() override;
+
       private:
         /*********************************************************************************
          * Dispatch pending event
@@ -66,6 +71,9 @@ namespace poll {
       private:
         int32_t fd_;
 
+        // Wakeup eventfd
+        int32_t wakeup_fd_;
+
         void_ptr events_;
         int32_t max_event_count_;
         std::atomic_int32_t cur_event_count_;
@@ -24,7 +24,9 @@
 #include "pump/memory.h"
 #include "pump/net/socket.h"
 #include "pump/poll/channel.h"
+#include "pump/time/timer_queue.h"
 #include "pump/toolkit/freelock_multi_queue.h"
+#include "pump/toolkit/freelock_ring_queue.h"
 
 namespace pump {
 namespace poll {
@@ -34,15 +36,22 @@ namespace poll {
 
       protected:
         struct channel_event {
-            channel_event(std::shared_ptr<channel> &c, int32_t ev) noexcept
-                : ch(c), event(ev) {
+            PUMP_ENABLE_OBJECT_POOL(channel_event);
+            channel_event() noexcept
+                : event(0) {
             }
-            channel_wptr ch;
+            channel_event(channel_sptr &&c, int32_t ev) noexcept
+                : ch(std::move(c)), event(ev) {
+            }
+            // Event keeps the channel until it is handled, so handling the event
+            // needs no weak pointer locking.
+            channel_sptr ch;
             int32_t event;
         };
         DEFINE_RAW_POINTER_TYPE(channel_event);
 
         struct tracker_event {
+            PUMP_ENABLE_OBJECT_POOL(tracker_event);
             tracker_event(channel_tracker_sptr &t, int32_t ev) noexcept
                 : tracker(t), event(ev) {
             }
@@ -72,6 +81,7 @@ namespace poll {
          ********************************************************************************/
         virtual void stop() {
             started_.store(false);
+            timers_->stop();
         }
 
         /*********************************************************************************
@@ -104,7 +114,16 @@ namespace poll {
         /*********************************************************************************
          * Push channel event
          ********************************************************************************/
-        virtual bool push_channel_event(channel_sptr &c, int32_t event);
+        virtual bool push_channel_event(channel_sptr &&c, int32_t event);
+
+        /*********************************************************************************
+         * Start timer
+         * Timer expires in the poller thread, so it has no thread switching and does not
+         * race with io events of the poller.
+         ********************************************************************************/
+        PUMP_INLINE bool start_timer(time::timer_sptr &timer) {
+            return timers_->start_timer(timer);
+        }
 
       protected:
         /*********************************************************************************
@@ -136,17 +155,41 @@ namespace poll {
         virtual void __poll(int32_t timeout) {
         }
 
+        /*********************************************************************************
+         * Wakeup polling
+         * It is called when channel event is pushed while poller thread is waiting.
+         ********************************************************************************/
+        virtual void __wakeup() {
+        }
+
       private:
         /*********************************************************************************
          * Handle channel events
          ********************************************************************************/
         void __handle_channel_events();
 
+        /*********************************************************************************
+         * Clear channel events
+         * Channels kept by pending events are released after the worker is stopped.
+         ********************************************************************************/
+        void __clear_channel_events();
+
         /*********************************************************************************
          * Handle channel tracker events
          ********************************************************************************/
         void __handle_channel_tracker_events();
 
+        /*********************************************************************************
+         * Handle expired timers
+         * Return max polling timeout for next expired timer.
+         ********************************************************************************/
+        int32_t __handle_timers();
+
+        /*********************************************************************************
+         * Handle timeout timer
+         ********************************************************************************/
+        static void __handle_timeout_timer(time::timer_wptr &&wptr);
+
       protected:
         // Started status
         std::atomic_bool started_;
@@ -155,8 +198,14 @@ namespace poll {
         std::shared_ptr<std::thread> worker_;
 
         // Channel event
+        // Channel events are pushed to the ring queue, and they are pushed to the
+        // overflow queue only when the ring queue is full. Channel events just notify
+        // channels to check their states, so they don't need to keep order.
         std::atomic_int32_t cev_cnt_;
-        toolkit::freelock_multi_queue<channel_event_ptr> cevents_;
+        toolkit::freelock_ring_queue<channel_event> cevents_;
+        toolkit::freelock_multi_queue<channel_event_ptr> overflow_cevents_;
+        // Poller thread is waiting in polling
+        std::atomic_bool waiting_;
 
         // Channel tracker event
         std::atomic_int32_t tev_cnt_;
@@ -164,6 +213,9 @@ namespace poll {
 
         // Channel trackers
         std::map<channel_tracker_ptr, channel_tracker_sptr> trackers_;
+
+        // Timer queue observed by poller thread
+        time::timer_queue_sptr timers_;
     };
     DEFINE_SMART_POINTER_TYPE(poller);
 
@@ -17,17 +17,39 @@
 #ifndef pump_service_h
 #define pump_service_h
 
+#include <vector>
+
 #include "pump/poll/poller.h"
 #include "pump/time/timer_queue.h"
 #include "pump/toolkit/freelock_multi_queue.h"
+#include "pump/toolkit/freelock_overflow_queue.h"
 #include "pump/toolkit/freelock_single_queue.h"
 #include "pump/toolkit/freelock_block_queue.h"
+#include "pump/toolkit/handle_table.h"
 
 namespace pump {
 
+    namespace transport {
+        class base_transport;
+    }
+
     const int32_t READ_POLLER = 0;
     const int32_t SEND_POLLER = 1;
 
+    // Transport handle, high 32 bits are generation and low 32 bits are slot index
+    typedef uint64_t transport_handle;
+    // Invalid transport handle
+    const transport_handle INVALID_TRANSPORT_HANDLE = 0;
+
+    struct timer_dispatch_stats {
+        // Dispatched timer count
+        uint64_t count;
+        // Total dispatch lag with us
+        uint64_t total_lag;
+        // Max dispatch lag with us
+        uint64_t max_lag;
+    };
+
     class LIB_PUMP service 
       : public toolkit::noncopyable {
 
@@ -76,20 +98,112 @@ namespace pump {
          * Post channel event
          ********************************************************************************/
         bool post_channel_event(poll::channel_sptr &ch, int32_t event);
+        bool post_channel_event(poll::channel_sptr &&ch, int32_t event);
 
         /*********************************************************************************
          * Post callback task
+         * Tasks overflowing the posted task ring are kept in an unbounded queue, so
+         * posted tasks are never dropped.
+         ********************************************************************************/
+        template <typename PostedTaskType>
+        PUMP_INLINE bool post(PostedTaskType &&task) {
+            return posted_tasks_.enqueue(std::forward<PostedTaskType>(task));
+        }
+
+        /*********************************************************************************
+         * Set crypto worker count
+         * Crypto workers run expensive crypto tasks such as tls handshakes, so pollers
+         * are not stalled by them. This must be set before starting service.
+         ********************************************************************************/
+        bool set_crypto_worker_count(int32_t count);
+
+        /*********************************************************************************
+         * Has crypto worker
+         ********************************************************************************/
+        PUMP_INLINE bool has_crypto_worker() const {
+            return !crypto_workers_.empty();
+        }
+
+        /*********************************************************************************
+         * Post crypto task
+         * If there is no crypto worker, return false and caller should run task inline.
          ********************************************************************************/
         template <typename PostedTaskType>
-        PUMP_INLINE void post(PostedTaskType &&task) {
-            posted_tasks_.enqueue(std::forward<PostedTaskType>(task));
+        PUMP_INLINE bool post_crypto_task(PostedTaskType &&task) {
+            if (crypto_workers_.empty()) {
+                return false;
+            }
+            return crypto_tasks_.enqueue(std::forward<PostedTaskType>(task));
         }
 
+        /*********************************************************************************
+         * Set timer worker count
+         * Timer workers handle expired timers of service timer queue in parallel, so a
+         * slow timer callback does not delay others. A repeated timer is restarted after
+         * its callback returned, so its callbacks are still serial and in order. This
+         * must be set before starting service, default count is 1.
+         ********************************************************************************/
+        bool set_timer_worker_count(int32_t count);
+
+        /*********************************************************************************
+         * Get timer dispatch stats
+         * Dispatch lag is the time from timer expired to its callback starting.
+         ********************************************************************************/
+        timer_dispatch_stats get_timer_dispatch_stats() const;
+
         /*********************************************************************************
          * Start timer
+         * High resolution timer is started in high resolution timer queue, and it expires
+         * in the timer queue thread, so its callback should be quick.
          ********************************************************************************/
         bool start_timer(time::timer_sptr &timer);
 
+        /*********************************************************************************
+         * Start timer in poller
+         * Timer expires in the poller thread, it is used for connection timeouts which
+         * should be handled in the same thread as io events. If poller is disabled, the
+         * timer is started in service timer queue. High resolution timer is always started
+         * in high resolution timer queue.
+         ********************************************************************************/
+        bool start_timer(time::timer_sptr &timer, int32_t pi);
+
+        /*********************************************************************************
+         * Add transport
+         * Transport is kept in the transport table of service until removing, users can
+         * keep the returned handle instead of transport shared pointer. Return invalid
+         * handle if failed.
+         ********************************************************************************/
+        transport_handle add_transport(const std::shared_ptr<transport::base_transport> &t);
+
+        /*********************************************************************************
+         * Remove transport
+         * Return false if handle is stale.
+         ********************************************************************************/
+        PUMP_INLINE bool remove_transport(transport_handle handle) {
+            return transports_.remove(handle);
+        }
+
+        /*********************************************************************************
+         * Get transport
+         * Return empty pointer if handle is stale.
+         ********************************************************************************/
+        std::shared_ptr<transport::base_transport> get_transport(transport_handle handle);
+
+        /*********************************************************************************
+         * Send with transport handle
+         * It routes to the transport without touching shared pointer, and transport is
+         * kept until sending returned even if it is removed at the same time. Return
+         * transport::ERROR_INVALID if handle is stale.
+         ********************************************************************************/
+        int32_t send(transport_handle handle, const block_t *b, int32_t size);
+
+        /*********************************************************************************
+         * Get transport count in transport table
+         ********************************************************************************/
+        PUMP_INLINE uint32_t get_transport_count() const {
+            return transports_.size();
+        }
+
       private:
         /*********************************************************************************
         * Post pending timer
@@ -98,15 +212,32 @@ namespace pump {
             pending_timers_.enqueue(std::move(timer));
         }
 
+        /*********************************************************************************
+         * Handle high resolution timer
+         * It is handled in the timer queue thread, as posting it to another thread would
+         * add more latency than the timer resolution.
+         ********************************************************************************/
+        void __handle_high_resolution_timer(time::timer_wptr &&wptr);
+
+        /*********************************************************************************
+         * Dispatch expired timer
+         ********************************************************************************/
+        void __dispatch_timer(time::timer_sptr &timer);
+
         /*********************************************************************************
          * Start posted task worker
          ********************************************************************************/
         void __start_posted_task_worker();
 
         /*********************************************************************************
-         * Start timeout timer worker
+         * Start timeout timer workers
          ********************************************************************************/
-        void __start_timeout_timer_worker();
+        void __start_timeout_timer_workers();
+
+        /*********************************************************************************
+         * Start crypto workers
+         ********************************************************************************/
+        void __start_crypto_workers();
 
       private:
         // Running status
@@ -119,15 +250,32 @@ namespace pump {
         std::shared_ptr<std::thread> posted_task_worker_;
         typedef pump_function<void()> posted_task_type;
         typedef toolkit::freelock_multi_queue<posted_task_type> task_impl_queue;
-        toolkit::freelock_block_queue<task_impl_queue> posted_tasks_;
+        typedef toolkit::freelock_overflow_queue<posted_task_type> task_overflow_queue;
+        toolkit::freelock_block_queue<task_overflow_queue> posted_tasks_;
+
+        // Crypto workers
+        int32_t crypto_worker_count_;
+        std::vector<std::shared_ptr<std::thread>> crypto_workers_;
+        toolkit::freelock_block_queue<task_impl_queue> crypto_tasks_;
 
         // Timer queue
         time::timer_queue_sptr timers_;
+        // High resolution timer queue
+        time::timer_queue_sptr hr_timers_;
 
-        // Timeout timer worker
-        std::shared_ptr<std::thread> pending_timer_worker_;
-        typedef toolkit::freelock_single_queue<time::timer_wptr> timer_impl_queue;
+        // Timeout timer workers
+        int32_t timer_worker_count_;
+        std::vector<std::shared_ptr<std::thread>> pending_timer_workers_;
+        typedef toolkit::freelock_multi_queue<time::timer_wptr> timer_impl_queue;
         toolkit::freelock_block_queue<timer_impl_queue> pending_timers_;
+
+        // Timer dispatch stats
+        std::atomic<uint64_t> timer_dispatch_count_;
+        std::atomic<uint64_t> timer_dispatch_lag_;
+        std::atomic<uint64_t> timer_dispatch_max_lag_;
+
+        // Transport table
+        toolkit::handle_table<transport::base_transport> transports_;
     };
     DEFINE_ALL_POINTER_TYPE(service);
 
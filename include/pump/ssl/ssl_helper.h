@@ -20,6 +20,7 @@
 #include <string>
 
 #include "pump/types.h"
+#include "pump/ssl/tls_session_cache.h"
 
 namespace pump {
 namespace ssl {
@@ -43,6 +44,37 @@ namespace ssl {
                                               const std::string &cert,
                                               const std::string &key);
 
+    /*********************************************************************************
+     * Enable tls kernel offload.
+     * Sessions created with the certificate will try to use kernel TLS after handshake,
+     * then application data is encrypted and decrypted by kernel. It only works with
+     * OpenSSL built with ktls support, GnuTLS enables it by system config instead.
+     * Return false if not supported.
+     ********************************************************************************/
+    bool enable_tls_kernel_offload(void_ptr xcred);
+
+    /*********************************************************************************
+     * Set tls server session cache.
+     * Server stores sessions in the cache by session id, so clients can resume them.
+     * With OpenSSL, session ticket takes precedence over session cache if enabled.
+     ********************************************************************************/
+    bool set_tls_session_cache(void_ptr xcred, tls_session_cache_sptr &cache);
+
+    /*********************************************************************************
+     * Enable tls server session ticket.
+     * Ticket keys are rotated every interval milliseconds, and tickets encrypted by the
+     * previous key are still accepted for one more interval. GnuTLS rotates its derived
+     * ticket keys by itself, and the interval is used as ticket lifetime.
+     ********************************************************************************/
+    bool enable_tls_session_ticket(void_ptr xcred, int64_t key_rotate_interval);
+
+    /*********************************************************************************
+     * Apply tls certificate options.
+     * This applies session cache and session ticket options of the certificate to a
+     * new server tls session.
+     ********************************************************************************/
+    void apply_tls_certificate_options(void_ptr xcred, void_ptr ssl_ctx);
+
     /*********************************************************************************
      * Destory tls certificate.
      ********************************************************************************/
@@ -19,6 +19,7 @@
 
 // Import "memcpy" function
 #include <string.h>
+#include <string>
 
 #include "pump/types.h"
 #include "pump/toolkit/buffer.h"
@@ -31,18 +32,42 @@ namespace ssl {
     const int32_t TLS_HANDSHAKE_SEND = 2;
     const int32_t TLS_HANDSHAKE_ERROR = 3;
 
+    const int32_t TLS_KTLS_SEND = 0x01;
+    const int32_t TLS_KTLS_RECV = 0x02;
+
+    const int32_t TLS_NET_BUFFER_SIZE = 65536; // 64KB
+
     struct tls_session {
         // SSL Context
         void_ptr ssl_ctx;
+        // Net read buffer, tls library reads ciphertext from it with memory io
+        toolkit::io_buffer_ptr net_read_iob;
+        // Net send buffer, tls library writes ciphertext to it with memory io
+        toolkit::io_buffer_ptr net_send_iob;
     };
     DEFINE_RAW_POINTER_TYPE(tls_session);
 
     /*********************************************************************************
      * Create tls session
-     * This will create ssl context, net read buffer and net send buffer.
+     * This will create ssl context, and tls library does socket io with the fd.
      ********************************************************************************/
     tls_session_ptr create_tls_session(void_ptr xcred, int32_t fd, bool client);
 
+    /*********************************************************************************
+     * Create tls memory session
+     * TLS library of the session does no socket io, it reads ciphertext from the net
+     * read buffer and writes ciphertext to the net send buffer. Caller must move
+     * data between the buffers and socket.
+     ********************************************************************************/
+    tls_session_ptr create_tls_memory_session(void_ptr xcred, bool client);
+
+    /*********************************************************************************
+     * Check memory io session or not
+     ********************************************************************************/
+    PUMP_INLINE bool tls_is_memory_session(tls_session_ptr session) {
+        return session->net_read_iob != nullptr;
+    }
+
     /*********************************************************************************
      * Destory tls session
      * This will destory ssl context, net read buffer and net send buffer.
@@ -59,6 +84,31 @@ namespace ssl {
      ********************************************************************************/
     int32_t tls_handshake(tls_session_ptr session);
 
+    /*********************************************************************************
+     * Set session data
+     * Client session will try to resume the session data when handshaking, and it
+     * must be set before handshake.
+     ********************************************************************************/
+    bool tls_set_session_data(tls_session_ptr session, const std::string &data);
+
+    /*********************************************************************************
+     * Get session data
+     * Return false if there is no resumable session. TLS 1.3 session is resumable
+     * only after the session ticket is received, which arrives after handshake.
+     ********************************************************************************/
+    bool tls_get_session_data(tls_session_ptr session, std::string &data);
+
+    /*********************************************************************************
+     * Check session resumed or not
+     ********************************************************************************/
+    bool tls_is_session_resumed(tls_session_ptr session);
+
+    /*********************************************************************************
+     * Get kernel tls offload state
+     * Return TLS_KTLS_SEND and TLS_KTLS_RECV flags, it should be checked after handshake.
+     ********************************************************************************/
+    int32_t tls_kernel_offload_state(tls_session_ptr session);
+
     /*********************************************************************************
      * Check has unread data or not
      ********************************************************************************/
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_ssl_tls_session_cache_h
+#define pump_ssl_tls_session_cache_h
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "pump/types.h"
+#include "pump/memory.h"
+#include "pump/platform.h"
+#include "pump/toolkit/features.h"
+
+namespace pump {
+namespace ssl {
+
+    #define TLS_SESSION_CACHE_SHARDS 16
+
+    class tls_session_cache;
+    DEFINE_ALL_POINTER_TYPE(tls_session_cache);
+
+    class LIB_PUMP tls_session_cache
+      : public toolkit::noncopyable {
+
+      public:
+        /*********************************************************************************
+         * Create instance
+         * Cache holds max_count sessions at most, and a session expires after timeout
+         * milliseconds. When full, the oldest session is evicted.
+         ********************************************************************************/
+        PUMP_INLINE static tls_session_cache_sptr create(int32_t max_count = 20480,
+                                                         int64_t timeout = 7200000) {
+            INLINE_OBJECT_CREATE(obj, tls_session_cache, (max_count, timeout));
+            return tls_session_cache_sptr(obj, object_delete<tls_session_cache>);
+        }
+
+        /*********************************************************************************
+         * Deconstructor
+         ********************************************************************************/
+        ~tls_session_cache() = default;
+
+        /*********************************************************************************
+         * Put session data
+         ********************************************************************************/
+        void put(const std::string &id, const std::string &data);
+
+        /*********************************************************************************
+         * Get session data
+         * Return false if not found or expired.
+         ********************************************************************************/
+        bool get(const std::string &id, std::string &data);
+
+        /*********************************************************************************
+         * Remove session data
+         ********************************************************************************/
+        void remove(const std::string &id);
+
+        /*********************************************************************************
+         * Get session count
+         ********************************************************************************/
+        int32_t size();
+
+        /*********************************************************************************
+         * Get session timeout
+         ********************************************************************************/
+        PUMP_INLINE int64_t get_timeout() const {
+            return timeout_;
+        }
+
+      private:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        tls_session_cache(int32_t max_count, int64_t timeout) noexcept;
+
+      private:
+        struct cache_entry {
+            // Session data
+            std::string data;
+            // Expired time
+            uint64_t expired;
+            // Position in order list
+            std::list<std::string>::iterator pos;
+        };
+
+        struct cache_shard {
+            // Shard locker
+            std::mutex mx;
+            // Sessions
+            std::unordered_map<std::string, cache_entry> sessions;
+            // Session ids ordered by put time
+            std::list<std::string> order;
+        };
+
+        /*********************************************************************************
+         * Get shard
+         ********************************************************************************/
+        PUMP_INLINE cache_shard &__get_shard(const std::string &id) {
+            return shards_[std::hash<std::string>()(id) % TLS_SESSION_CACHE_SHARDS];
+        }
+
+        /*********************************************************************************
+         * Erase session from shard
+         ********************************************************************************/
+        void __erase(cache_shard &shard,
+                     std::unordered_map<std::string, cache_entry>::iterator it);
+
+      private:
+        // Max session count of every shard
+        int32_t shard_max_count_;
+        // Session timeout
+        int64_t timeout_;
+        // Cache shards
+        cache_shard shards_[TLS_SESSION_CACHE_SHARDS];
+    };
+
+}  // namespace ssl
+}  // namespace pump
+
+#endif
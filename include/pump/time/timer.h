@@ -32,6 +32,9 @@ namespace time {
     class timer_queue;
     DEFINE_ALL_POINTER_TYPE(timer_queue);
 
+    struct timer_wheel_node;
+    DEFINE_RAW_POINTER_TYPE(timer_wheel_node);
+
     typedef pump_function<void()> timer_callback;
 
     constexpr static int32_t TIMER_INIT = 0;
@@ -46,27 +49,43 @@ namespace time {
         friend class timer_queue;
 
       public:
+        // Objects are allocated from object pool
+        PUMP_ENABLE_OBJECT_POOL(timer);
+
         /*********************************************************************************
          * Create instance
          ********************************************************************************/
         PUMP_INLINE static timer_sptr create(uint64_t timeout,
                                              const timer_callback &cb,
                                              bool repeated = false) {
-            INLINE_OBJECT_CREATE(obj, timer, (timeout, cb, repeated));
+            INLINE_OBJECT_CREATE(obj, timer, (timeout, cb, repeated, false));
+            return timer_sptr(obj, object_delete<timer>);
+        }
+
+        /*********************************************************************************
+         * Create high resolution instance
+         * Timeout is with us, and the timer can only be started in high resolution timer
+         * queue.
+         ********************************************************************************/
+        PUMP_INLINE static timer_sptr create_high_resolution(uint64_t timeout,
+                                                             const timer_callback &cb,
+                                                             bool repeated = false) {
+            INLINE_OBJECT_CREATE(obj, timer, (timeout, cb, repeated, true));
             return timer_sptr(obj, object_delete<timer>);
         }
 
         /*********************************************************************************
          * Deconstructor
+         * Started timer is removed from timer queue.
          ********************************************************************************/
-        ~timer() = default;
+        ~timer();
 
         /*********************************************************************************
          * Stop
+         * Timer is removed from timer queue at once, and timer queue does not hold the
+         * timer any more.
          ********************************************************************************/
-        PUMP_INLINE void stop() {
-            __force_set_state(TIMER_STOPPED);
-        }
+        void stop();
 
         /*********************************************************************************
          * Handle timeout
@@ -94,16 +113,38 @@ namespace time {
             return repeated_;
         }
 
+        /*********************************************************************************
+         * Get high resolution status
+         ********************************************************************************/
+        PUMP_INLINE bool is_high_resolution() const {
+            return high_resolution_;
+        }
+
       private:
         /*********************************************************************************
          * Constructor
          ********************************************************************************/
-        timer(uint64_t timeout, const timer_callback &cb, bool repeated) noexcept;
+        timer(uint64_t timeout,
+              const timer_callback &cb,
+              bool repeated,
+              bool high_resolution) noexcept;
+
+        /*********************************************************************************
+         * Get now time with the timer resolution
+         ********************************************************************************/
+        PUMP_INLINE uint64_t __now() const {
+            return high_resolution_ ? get_clock_microseconds() : get_cached_clock_milliseconds();
+        }
 
         /*********************************************************************************
          * Start
          ********************************************************************************/
-        bool __start(timer_queue_ptr queue);
+        bool __start(timer_queue_wptr &&queue);
+
+        /*********************************************************************************
+         * Cancel from timer queue
+         ********************************************************************************/
+        void __cancel();
 
         /*********************************************************************************
          * Set state
@@ -120,17 +161,21 @@ namespace time {
         }
 
       private:
-        // Timer queue
-        timer_queue_ptr queue_;
+        // Timer queue, it is weak as timer queue may be destroyed before the timer
+        timer_queue_wptr queue_;
+        // Timer wheel node, it is guarded by timer queue
+        timer_wheel_node_ptr node_;
         // Timer status
         std::atomic_int32_t status_;
         // Timer callback
         timer_callback cb_;
         // Repeated status
         bool repeated_;
-        // Timeout with ms
+        // High resolution status
+        bool high_resolution_;
+        // Timeout with ms, or with us for high resolution timer
         uint64_t timeout_;
-        // Timeout time with ms
+        // Timeout time with ms, or with us for high resolution timer
         uint64_t overtime_;
     };
 
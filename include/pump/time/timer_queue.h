@@ -17,7 +17,6 @@
 #ifndef pump_timer_queue_h
 #define pump_timer_queue_h
 
-#include <map>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -25,25 +24,39 @@
 
 #include "pump/debug.h"
 #include "pump/time/timer.h"
-#include "pump/toolkit/freelock_multi_queue.h"
-#include "pump/toolkit/freelock_single_queue.h"
-#include "pump/toolkit/freelock_block_queue.h"
+#include "pump/time/timer_wheel.h"
 
 namespace pump {
 namespace time {
 
+    // Default slack of high resolution timer queue with us. Timers expiring in the
+    // same slack are coalesced to one wakeup.
+    constexpr static uint64_t TIMER_HIGH_RESOLUTION_SLACK = 50;
+
     class timer_queue
-      : public toolkit::noncopyable {
+      : public toolkit::noncopyable,
+        public std::enable_shared_from_this<timer_queue> {
 
-      protected:
+      public:
         typedef pump_function<void(timer_wptr&&)> timer_pending_callback;
 
-      public:
           /*********************************************************************************
          * Create instance
          ********************************************************************************/
         PUMP_INLINE static timer_queue_sptr create() {
-            INLINE_OBJECT_CREATE(obj, timer_queue, ());
+            INLINE_OBJECT_CREATE(obj, timer_queue, (false, 1));
+            return timer_queue_sptr(obj, object_delete<timer_queue>);
+        }
+
+        /*********************************************************************************
+         * Create high resolution instance
+         * It only holds high resolution timers. Timers expire at most slack us late, and
+         * timers expiring in the same slack are handled with one wakeup. On linux, the
+         * observer thread waits on a timerfd with absolute monotonic time.
+         ********************************************************************************/
+        PUMP_INLINE static timer_queue_sptr create_high_resolution(
+            uint64_t slack = TIMER_HIGH_RESOLUTION_SLACK) {
+            INLINE_OBJECT_CREATE(obj, timer_queue, (true, slack > 0 ? slack : 1));
             return timer_queue_sptr(obj, object_delete<timer_queue>);
         }
 
@@ -54,16 +67,38 @@ namespace time {
 
         /*********************************************************************************
          * Start
+         * Without observer thread, the queue owner must observe the queue by itself.
          ********************************************************************************/
-        bool start(const timer_pending_callback &cb);
+        bool start(const timer_pending_callback &cb, bool with_observer = true);
 
         /*********************************************************************************
-         * Stop
+         * Observe
+         * Expired timers are handled with pending callback in the calling thread. This
+         * is for the queue owner when there is no observer thread.
          ********************************************************************************/
-        PUMP_INLINE void stop() {
-            started_.store(false);
+        void observe(uint64_t now);
+
+        /*********************************************************************************
+         * Get next observe time
+         * It is with ms, or with us for high resolution queue. It becomes earlier when an
+         * earlier timer is added.
+         ********************************************************************************/
+        PUMP_INLINE uint64_t get_next_observe_time() const {
+            return next_observe_time_.load(std::memory_order_relaxed);
+        }
+
+        /*********************************************************************************
+         * Get high resolution status
+         ********************************************************************************/
+        PUMP_INLINE bool is_high_resolution() const {
+            return high_resolution_;
         }
 
+        /*********************************************************************************
+         * Stop
+         ********************************************************************************/
+        void stop();
+
         /*********************************************************************************
          * Wait stopping
          ********************************************************************************/
@@ -80,6 +115,13 @@ namespace time {
          ********************************************************************************/
         bool restart_timer(timer_sptr &&ptr);
 
+        /*********************************************************************************
+         * Cancel timer
+         * Timer is removed from timer wheel at once. Just timer can call this function,
+         * user code must dont call this.
+         ********************************************************************************/
+        void cancel_timer(timer_ptr ptr);
+
       protected:
         /*********************************************************************************
          * Observe thread
@@ -91,28 +133,66 @@ namespace time {
          ********************************************************************************/
         void __observe(uint64_t now);
 
+        /*********************************************************************************
+         * Update next observe time
+         ********************************************************************************/
+        void __update_next_observe_time(uint64_t now);
+
+        /*********************************************************************************
+         * Wait until next observe time or notified
+         ********************************************************************************/
+        void __wait(std::unique_lock<std::mutex> &lock, uint64_t now);
+
+        /*********************************************************************************
+         * Notify observer thread to observe at the time
+         ********************************************************************************/
+        void __notify(uint64_t time);
+
+        /*********************************************************************************
+         * Get now time with the queue resolution
+         ********************************************************************************/
+        PUMP_INLINE uint64_t __now() const {
+            return high_resolution_ ? get_clock_microseconds() : get_clock_milliseconds();
+        }
+
+        /*********************************************************************************
+         * Add timer to timer wheel
+         ********************************************************************************/
+        bool __add_timer(const timer_sptr &ptr);
+
       private:
         /*********************************************************************************
          * Constructor
          ********************************************************************************/
-        timer_queue() noexcept;
+        timer_queue(bool high_resolution, uint64_t tick) noexcept;
 
       private:
         // Started status
         std::atomic_bool started_;
 
-        // Next observer time
-        uint64_t next_observe_time_;
+        // High resolution status
+        bool high_resolution_;
+        // Time length of one wheel tick, it is the slack for high resolution queue
+        uint64_t tick_;
+        // Observer timer fd, it is only used by high resolution queue on linux
+        int32_t timer_fd_;
 
         // Observer thread
         std::shared_ptr<std::thread> observer_;
 
-        // New timers
-        typedef toolkit::freelock_multi_queue<timer_sptr> timer_impl_queue;
-        toolkit::freelock_block_queue<timer_impl_queue> new_timers_;
+        // Timer wheel mutex
+        std::mutex mx_;
+        // Observer condition, it is notified when a timer expires before next observing
+        std::condition_variable cond_;
+        // Next observe time
+        std::atomic<uint64_t> next_observe_time_;
 
         // Observed Timers
-        std::multimap<uint64_t, timer_wptr> timers_;
+        timer_wheel timers_;
+        // Expired timer nodes
+        std::vector<timer_wheel_node_ptr> expired_nodes_;
+        // Expired timers
+        std::vector<timer_wptr> expired_timers_;
 
         // Timeout callback
         timer_pending_callback pending_cb_;
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef pump_time_timer_wheel_h
+#define pump_time_timer_wheel_h
+
+#include <vector>
+
+#include "pump/time/timer.h"
+
+namespace pump {
+namespace time {
+
+    // Timer wheel has one root level with 256 slots and four levels with 64 slots,
+    // one tick is one millisecond, so it covers about 49 days.
+    constexpr static int32_t TIMER_WHEEL_LEVELS = 5;
+    constexpr static int32_t TIMER_WHEEL_ROOT_BITS = 8;
+    constexpr static int32_t TIMER_WHEEL_LEVEL_BITS = 6;
+    constexpr static int32_t TIMER_WHEEL_ROOT_SIZE = 1 << TIMER_WHEEL_ROOT_BITS;
+    constexpr static int32_t TIMER_WHEEL_LEVEL_SIZE = 1 << TIMER_WHEEL_LEVEL_BITS;
+    constexpr static int32_t TIMER_WHEEL_SLOTS =
+        TIMER_WHEEL_ROOT_SIZE + (TIMER_WHEEL_LEVELS - 1) * TIMER_WHEEL_LEVEL_SIZE;
+
+    // Max cached free node count
+    constexpr static int32_t TIMER_WHEEL_MAX_FREE_NODES = 4096;
+
+    struct timer_wheel_link {
+        // Prev link
+        timer_wheel_link *prev;
+        // Next link
+        timer_wheel_link *next;
+    };
+
+    struct timer_wheel_node
+      : public timer_wheel_link {
+        // Nodes are allocated from object pool
+        PUMP_ENABLE_OBJECT_POOL(timer_wheel_node);
+        // Expire time with ms
+        uint64_t expire;
+        // Timer
+        timer_ptr timer;
+        // Timer weak pointer, it is locked when timer expired
+        timer_wptr timer_ref;
+    };
+
+    class LIB_PUMP timer_wheel
+      : public toolkit::noncopyable {
+
+      public:
+        /*********************************************************************************
+         * Constructor
+         * The now is the time of the first tick with ms.
+         ********************************************************************************/
+        timer_wheel(uint64_t now) noexcept;
+
+        /*********************************************************************************
+         * Deconstructor
+         ********************************************************************************/
+        ~timer_wheel();
+
+        /*********************************************************************************
+         * Add timer
+         * Timer expired before current tick will be expired at the next advancing. Return
+         * the timer node, which can be used to remove the timer.
+         ********************************************************************************/
+        timer_wheel_node_ptr add(const timer_sptr &timer, uint64_t expire);
+
+        /*********************************************************************************
+         * Remove timer node
+         ********************************************************************************/
+        void remove(timer_wheel_node_ptr node);
+
+        /*********************************************************************************
+         * Advance
+         * Advance wheel to the now time, and append expired timer nodes to the list.
+         * Expired nodes are unlinked from wheel, and must be released after handled.
+         ********************************************************************************/
+        void advance(uint64_t now, std::vector<timer_wheel_node_ptr> &expired);
+
+        /*********************************************************************************
+         * Release expired timer node
+         ********************************************************************************/
+        PUMP_INLINE void release(timer_wheel_node_ptr node) {
+            __free_node(node);
+        }
+
+        /*********************************************************************************
+         * Get next advancing time
+         * It is the next expire time if the timer is in root level, else the next time
+         * timers cascading. Return -1 if there is no timer.
+         ********************************************************************************/
+        uint64_t next_advance_time() const;
+
+        /*********************************************************************************
+         * Get timer count
+         ********************************************************************************/
+        PUMP_INLINE size_t size() const {
+            return count_;
+        }
+
+      private:
+        /*********************************************************************************
+         * Link node to slot
+         ********************************************************************************/
+        void __link(timer_wheel_node_ptr node);
+
+        /*********************************************************************************
+         * Unlink node from slot
+         ********************************************************************************/
+        void __unlink(timer_wheel_node_ptr node);
+
+        /*********************************************************************************
+         * Cascade timers of the level slot to lower levels
+         ********************************************************************************/
+        void __cascade(int32_t level, int32_t index);
+
+        /*********************************************************************************
+         * New node
+         ********************************************************************************/
+        timer_wheel_node_ptr __new_node();
+
+        /*********************************************************************************
+         * Free node
+         ********************************************************************************/
+        void __free_node(timer_wheel_node_ptr node);
+
+      private:
+        // Current tick with ms, it is the next tick to advance
+        uint64_t current_;
+        // Timer count
+        size_t count_;
+        // Slot lists, root level slots are the first slots
+        timer_wheel_link slots_[TIMER_WHEEL_SLOTS];
+        // Root level slot bitmap, a bit is set if the slot is not empty
+        uint64_t root_bitmap_[TIMER_WHEEL_ROOT_SIZE / 64];
+        // Free nodes
+        timer_wheel_node_ptr free_nodes_;
+        // Free node count
+        int32_t free_count_;
+    };
+
+}  // namespace time
+}  // namespace pump
+
+#endif
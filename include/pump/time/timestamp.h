@@ -28,6 +28,7 @@ namespace time {
 
     /*********************************************************************************
      * Get clock microseconds, just for calculating time difference
+     * It is monotonic clock, which is the clock of high resolution timers.
      ********************************************************************************/
     LIB_PUMP uint64_t get_clock_microseconds();
 
@@ -36,6 +37,36 @@ namespace time {
      ********************************************************************************/
     LIB_PUMP uint64_t get_clock_milliseconds();
 
+    /*********************************************************************************
+     * Update cached clock milliseconds
+     * It refreshes the cached clock of the calling thread and returns it. Poller
+     * thread updates it once per loop and after waking up with io events.
+     ********************************************************************************/
+    LIB_PUMP uint64_t update_cached_clock_milliseconds();
+
+    /*********************************************************************************
+     * Get cached clock milliseconds
+     * It is the cached clock of the calling thread, which may be behind the clock by
+     * the time of handling one batch of events. If the thread never updates cached
+     * clock, it returns clock milliseconds.
+     ********************************************************************************/
+    LIB_PUMP uint64_t get_cached_clock_milliseconds();
+
+    /*********************************************************************************
+     * Get tsc clock nanoseconds
+     * It reads cpu timestamp counter calibrated against steady clock, so it is much
+     * cheaper than querying os clock and is suitable for instrumentation. It is
+     * calibrated at the first calling, which takes about 10ms. Without invariant tsc,
+     * it falls back to steady clock.
+     ********************************************************************************/
+    LIB_PUMP uint64_t get_tsc_clock_nanoseconds();
+
+    /*********************************************************************************
+     * Check tsc clock supported
+     * Return false if tsc clock falls back to steady clock.
+     ********************************************************************************/
+    LIB_PUMP bool is_tsc_clock_supported();
+
     class LIB_PUMP timestamp {
       public:
         /*********************************************************************************
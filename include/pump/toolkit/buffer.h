@@ -97,6 +97,9 @@ namespace toolkit {
       : public base_buffer {
 
       public:
+        // Objects are allocated from object pool
+        PUMP_ENABLE_OBJECT_POOL(io_buffer);
+
         /*********************************************************************************
          * Create
          ********************************************************************************/
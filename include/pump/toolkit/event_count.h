@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef pump_toolkit_event_count_h
+#define pump_toolkit_event_count_h
+
+#include <atomic>
+#include <chrono>
+
+#include "pump/types.h"
+#include "pump/platform.h"
+#include "pump/toolkit/features.h"
+
+#if defined(OS_LINUX)
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace pump {
+namespace toolkit {
+
+    /*********************************************************************************
+     * Event count
+     * Waiter prepares waiting, checks its condition again, then commits waiting. Notifier
+     * changes condition, then notifies. Notifying claims a prepared waiter and advances
+     * epoch, so notifier only issues a syscall when there is a waiter not claimed yet,
+     * and waiter does not miss notifying between preparing and committing. On linux it
+     * waits on a futex, on other platforms it waits on a condition variable.
+     ********************************************************************************/
+    class LIB_PUMP event_count
+      : public noncopyable {
+
+      public:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        event_count() noexcept
+          : state_(0) {
+        }
+
+        /*********************************************************************************
+         * Prepare waiting
+         * Return the key for committing waiting.
+         ********************************************************************************/
+        PUMP_INLINE uint32_t prepare_wait() {
+            return __epoch(state_.fetch_add(WAITER_ONE, std::memory_order_seq_cst));
+        }
+
+        /*********************************************************************************
+         * Cancel waiting
+         * Waiter finds its condition is satisfied after preparing waiting.
+         ********************************************************************************/
+        PUMP_INLINE void cancel_wait(uint32_t key) {
+            __leave(key);
+        }
+
+        /*********************************************************************************
+         * Commit waiting
+         * Wait until notified after preparing or timeout. Negative timeout means waiting
+         * forever. Return false if not notified.
+         ********************************************************************************/
+        bool commit_wait(uint32_t key, int64_t timeout_usecs = -1) {
+#if defined(OS_LINUX)
+            struct timespec ts;
+            struct timespec *pts = nullptr;
+            if (timeout_usecs >= 0) {
+                ts.tv_sec = time_t(timeout_usecs / 1000000);
+                ts.tv_nsec = long(timeout_usecs % 1000000) * 1000;
+                pts = &ts;
+            }
+            if (__epoch(state_.load(std::memory_order_acquire)) == key) {
+                ::syscall(SYS_futex, __futex(), FUTEX_WAIT_PRIVATE, key, pts, nullptr, 0);
+            }
+#else
+            {
+                std::unique_lock<std::mutex> lock(mx_);
+                auto pred = [&]() {
+                    return __epoch(state_.load(std::memory_order_acquire)) != key;
+                };
+                if (timeout_usecs < 0) {
+                    cond_.wait(lock, pred);
+                } else {
+                    cond_.wait_for(lock, std::chrono::microseconds(timeout_usecs), pred);
+                }
+            }
+#endif
+            return !__leave(key);
+        }
+
+        /*********************************************************************************
+         * Notify one waiter
+         ********************************************************************************/
+        PUMP_INLINE void notify_one() {
+            __notify(false);
+        }
+
+        /*********************************************************************************
+         * Notify all waiters
+         ********************************************************************************/
+        PUMP_INLINE void notify_all() {
+            __notify(true);
+        }
+
+      private:
+        // State has waiter count at high 32 bits and epoch at low 32 bits.
+        constexpr static uint64_t WAITER_ONE = uint64_t(1) << 32;
+
+        /*********************************************************************************
+         * Get epoch of state
+         ********************************************************************************/
+        PUMP_INLINE static uint32_t __epoch(uint64_t state) {
+            return uint32_t(state);
+        }
+
+        /*********************************************************************************
+         * Get futex word
+         * It is the epoch half of state.
+         ********************************************************************************/
+        PUMP_INLINE uint32_t* __futex() {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+            return reinterpret_cast<uint32_t*>(&state_) + 1;
+#else
+            return reinterpret_cast<uint32_t*>(&state_);
+#endif
+        }
+
+        /*********************************************************************************
+         * Leave waiting
+         * If epoch is not advanced, waiter is not claimed by notifier and it removes
+         * itself. Return true if waiter removes itself.
+         ********************************************************************************/
+        PUMP_INLINE bool __leave(uint32_t key) {
+            uint64_t state = state_.load(std::memory_order_relaxed);
+            while (__epoch(state) == key) {
+                if (state_.compare_exchange_weak(state,
+                                                 state - WAITER_ONE,
+                                                 std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /*********************************************************************************
+         * Notify
+         ********************************************************************************/
+        PUMP_INLINE void __notify(bool all) {
+            // Condition changing must be visible before checking waiters.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            uint64_t state = state_.load(std::memory_order_relaxed);
+            uint64_t next_state = 0;
+            do {
+                if (PUMP_LIKELY(state < WAITER_ONE)) {
+                    return;
+                }
+                uint64_t waiters = all ? 0 : (state >> 32) - 1;
+                next_state = (waiters << 32) | uint64_t(__epoch(state) + 1);
+            } while (!state_.compare_exchange_weak(state,
+                                                   next_state,
+                                                   std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed));
+#if defined(OS_LINUX)
+            ::syscall(SYS_futex, __futex(), FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, nullptr, nullptr, 0);
+#else
+            {
+                std::lock_guard<std::mutex> lock(mx_);
+            }
+            if (all) {
+                cond_.notify_all();
+            } else {
+                cond_.notify_one();
+            }
+#endif
+        }
+
+      private:
+        // Waiter count and epoch
+        std::atomic<uint64_t> state_;
+#if !defined(OS_LINUX)
+        // Waiting mutex
+        std::mutex mx_;
+        // Waiting condition
+        std::condition_variable cond_;
+#endif
+    };
+
+}  // namespace toolkit
+}  // namespace pump
+
+#endif
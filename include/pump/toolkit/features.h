@@ -18,11 +18,15 @@
 #define pump_toolkit_features_h
 
 #include "pump/fncb.h"
+#include "pump/types.h"
 #include "pump/platform.h"
 
 namespace pump {
 namespace toolkit {
 
+    // Cache line size, it is used to pad data shared by threads.
+    constexpr static int32_t CACHE_LINE_SIZE = 64;
+
     /*********************************************************************************
      * Noncopyable base class
      ********************************************************************************/
@@ -17,13 +17,21 @@
 #ifndef pump_toolkit_freelock_block_queue_h
 #define pump_toolkit_freelock_block_queue_h
 
+#include <chrono>
+
 #include "pump/platform.h"
 #include "pump/toolkit/features.h"
-#include "pump/toolkit/semaphore.h"
+#include "pump/toolkit/event_count.h"
 
 namespace pump {
 namespace toolkit {
 
+    /*********************************************************************************
+     * Freelock block queue
+     * Consumers pop the inner queue directly, and they just park on the event count
+     * when the inner queue is empty. So producers only issue a syscall when there is a
+     * parked consumer.
+     ********************************************************************************/
     template <typename Q>
     class LIB_PUMP freelock_block_queue
       : public noncopyable {
@@ -47,15 +55,15 @@ namespace toolkit {
          ********************************************************************************/
         PUMP_INLINE bool enqueue(const element_type& item) {
             if (PUMP_LIKELY(queue_.push(item))) {
-                semaphone_.signal();
+                event_.notify_one();
                 return true;
             }
             return false;
         }
 
         PUMP_INLINE bool enqueue(element_type&& item) {
-            if (PUMP_LIKELY(queue_.push(item))) {
-                semaphone_.signal();
+            if (PUMP_LIKELY(queue_.push(std::move(item)))) {
+                event_.notify_one();
                 return true;
             }
             return false;
@@ -67,13 +75,7 @@ namespace toolkit {
          ********************************************************************************/
         template <typename U>
         bool dequeue(U& item) {
-            if (semaphone_.wait()) {
-                while (!queue_.pop(item)) {
-                    continue;
-                }
-                return true;
-            }
-            return false;
+            return dequeue_bulk(&item, 1, -1) == 1;
         }
 
         /*********************************************************************************
@@ -82,25 +84,63 @@ namespace toolkit {
          ********************************************************************************/
         template <typename U>
         bool dequeue(U& item, uint64_t timeout) {
-            if (semaphone_.wait(timeout)) {
-                while (!queue_.pop(item)) {
-                    continue;
-                }
-                return true;
-            }
-            return false;
+            return dequeue_bulk(&item, 1, int64_t(timeout)) == 1;
         }
 
         template <typename U, typename Rep, typename Period>
         bool dequeue(U& item, const std::chrono::duration<Rep, Period>& timeout) {
-            if (semaphone_.wait(
-                std::chrono::duration_cast<std::chrono::microseconds>(timeout).count())) {
-                while (!queue_.pop(item)) {
-                    continue;
+            return dequeue_bulk(
+                &item, 1, std::chrono::duration_cast<std::chrono::microseconds>(timeout)) == 1;
+        }
+
+        /*********************************************************************************
+         * Dequeue bulk
+         * This will block until some elements dequeued or timeout, and dequeue ready
+         * elements at most max count. Negative timeout means blocking forever. Return
+         * dequeued count.
+         ********************************************************************************/
+        template <typename U>
+        uint32_t dequeue_bulk(U* items, uint32_t max_count, int64_t timeout) {
+            uint32_t count = __pop_bulk(queue_, items, max_count, 0);
+            if (count > 0) {
+                return count;
+            }
+
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeout);
+            while (true) {
+                uint32_t key = event_.prepare_wait();
+                count = __pop_bulk(queue_, items, max_count, 0);
+                if (count > 0) {
+                    event_.cancel_wait(key);
+                    return count;
+                }
+
+                int64_t wait_usecs = -1;
+                if (timeout >= 0) {
+                    wait_usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+                                     deadline - std::chrono::steady_clock::now()).count();
+                    if (wait_usecs <= 0) {
+                        event_.cancel_wait(key);
+                        return 0;
+                    }
+                }
+                event_.commit_wait(key, wait_usecs);
+
+                count = __pop_bulk(queue_, items, max_count, 0);
+                if (count > 0) {
+                    return count;
                 }
-                return true;
             }
-            return false;
+        }
+
+        template <typename U, typename Rep, typename Period>
+        uint32_t dequeue_bulk(U* items,
+                              uint32_t max_count,
+                              const std::chrono::duration<Rep, Period>& timeout) {
+            return dequeue_bulk(
+                items,
+                max_count,
+                int64_t(std::chrono::duration_cast<std::chrono::microseconds>(timeout).count()));
         }
 
         /*********************************************************************************
@@ -109,13 +149,7 @@ namespace toolkit {
          ********************************************************************************/
         template <typename U>
         bool try_dequeue(U& item) {
-            if (semaphone_.try_wait()) {
-                while (!queue_.pop(item)) {
-                    continue;
-                }
-                return true;
-            }
-            return false;
+            return queue_.pop(item);
         }
 
         /*********************************************************************************
@@ -125,12 +159,33 @@ namespace toolkit {
             return queue_.empty();
         }
 
+    private:
+        /*********************************************************************************
+         * Pop bulk from inner queue
+         * Inner queue with bulk popping claims elements at once, else elements are
+         * popped one by one.
+         ********************************************************************************/
+        template <typename QQ, typename U>
+        PUMP_INLINE static auto __pop_bulk(QQ &q, U *items, uint32_t max_count, int32_t)
+            -> decltype(q.pop_bulk(items, max_count)) {
+            return q.pop_bulk(items, max_count);
+        }
+
+        template <typename QQ, typename U>
+        PUMP_INLINE static uint32_t __pop_bulk(QQ &q, U *items, uint32_t max_count, int64_t) {
+            uint32_t count = 0;
+            while (count < max_count && q.pop(items[count])) {
+                count++;
+            }
+            return count;
+        }
+
     private:
         inner_queue_type queue_;
-        light_semaphore semaphone_;
+        event_count event_;
     };
 
 }  // namespace toolkit
 }  // namespace pump
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef pump_toolkit_freelock_lazy_queue_h
+#define pump_toolkit_freelock_lazy_queue_h
+
+#include <atomic>
+
+#include "pump/memory.h"
+#include "pump/toolkit/features.h"
+
+namespace pump {
+namespace toolkit {
+
+    /*********************************************************************************
+     * Freelock lazy queue
+     * It creates the inner queue at the first pushing, so an owner that never pushes
+     * costs only a pointer. Threads pushing at the same time race to install the inner
+     * queue, and losers delete their own queue.
+     ********************************************************************************/
+    template <typename Q>
+    class LIB_PUMP freelock_lazy_queue
+      : public noncopyable {
+
+      public:
+        // Inner queue type
+        typedef Q inner_queue_type;
+        // Element type
+        typedef typename inner_queue_type::element_type element_type;
+
+      public:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        freelock_lazy_queue(int32_t size) noexcept
+          : size_(size),
+            queue_(nullptr) {
+        }
+
+        /*********************************************************************************
+         * Deconstructor
+         ********************************************************************************/
+        ~freelock_lazy_queue() {
+            object_delete(queue_.load(std::memory_order_relaxed));
+        }
+
+        /*********************************************************************************
+         * Push
+         ********************************************************************************/
+        template <typename U>
+        PUMP_INLINE bool push(U &&data) {
+            inner_queue_type *q = queue_.load(std::memory_order_acquire);
+            if (PUMP_UNLIKELY(q == nullptr)) {
+                if ((q = __create_queue()) == nullptr) {
+                    return false;
+                }
+            }
+            return q->push(std::forward<U>(data));
+        }
+
+        /*********************************************************************************
+         * Pop
+         ********************************************************************************/
+        template <typename U>
+        PUMP_INLINE bool pop(U &data) {
+            inner_queue_type *q = queue_.load(std::memory_order_acquire);
+            if (q == nullptr) {
+                return false;
+            }
+            return q->pop(data);
+        }
+
+        /*********************************************************************************
+         * Empty
+         ********************************************************************************/
+        PUMP_INLINE bool empty() const {
+            inner_queue_type *q = queue_.load(std::memory_order_acquire);
+            return q == nullptr || q->empty();
+        }
+
+        /*********************************************************************************
+         * Check inner queue is created or not
+         ********************************************************************************/
+        PUMP_INLINE bool is_created() const {
+            return queue_.load(std::memory_order_relaxed) != nullptr;
+        }
+
+      private:
+        /*********************************************************************************
+         * Create inner queue
+         ********************************************************************************/
+        inner_queue_type* __create_queue() {
+            inner_queue_type *q = object_create<inner_queue_type>(size_);
+            if (q == nullptr) {
+                return nullptr;
+            }
+            inner_queue_type *exp = nullptr;
+            if (!queue_.compare_exchange_strong(exp,
+                                                q,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+                object_delete(q);
+                return exp;
+            }
+            return q;
+        }
+
+      private:
+        // Inner queue init size
+        int32_t size_;
+        // Inner queue
+        std::atomic<inner_queue_type*> queue_;
+    };
+
+}  // namespace toolkit
+}  // namespace pump
+
+#endif
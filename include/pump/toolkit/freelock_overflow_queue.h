@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef pump_toolkit_freelock_overflow_queue_h
+#define pump_toolkit_freelock_overflow_queue_h
+
+#include "pump/toolkit/features.h"
+#include "pump/toolkit/freelock_ring_queue.h"
+#include "pump/toolkit/freelock_multi_queue.h"
+
+namespace pump {
+namespace toolkit {
+
+    /*********************************************************************************
+     * Freelock overflow queue
+     * Elements are pushed to the bounded ring queue, and to the unbounded overflow
+     * queue only when the ring queue is full, so pushing never fails. Elements in
+     * the overflow queue are popped after the ring queue, so order is not kept once
+     * the ring queue overflowed.
+     ********************************************************************************/
+    template <typename T>
+    class LIB_PUMP freelock_overflow_queue
+      : public noncopyable {
+
+      public:
+        // Element type
+        typedef T element_type;
+
+      public:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        freelock_overflow_queue(int32_t size)
+          : ring_(size),
+            overflow_(1024) {
+        }
+
+        /*********************************************************************************
+         * Push
+         ********************************************************************************/
+        template <typename U>
+        PUMP_INLINE bool push(U &&data) {
+            // Ring queue moves data only when pushing succeeds.
+            if (PUMP_LIKELY(ring_.push(std::forward<U>(data)))) {
+                return true;
+            }
+            return overflow_.push(std::forward<U>(data));
+        }
+
+        /*********************************************************************************
+         * Pop
+         ********************************************************************************/
+        template <typename U>
+        PUMP_INLINE bool pop(U &data) {
+            if (PUMP_LIKELY(ring_.pop(data))) {
+                return true;
+            }
+            return overflow_.pop(data);
+        }
+
+        /*********************************************************************************
+         * Pop bulk
+         * Return popped count.
+         ********************************************************************************/
+        template <typename It>
+        PUMP_INLINE uint32_t pop_bulk(It items, uint32_t max_count) {
+            uint32_t count = ring_.pop_bulk(items, max_count);
+            while (count < max_count && overflow_.pop(items[count])) {
+                count++;
+            }
+            return count;
+        }
+
+        /*********************************************************************************
+         * Empty
+         ********************************************************************************/
+        PUMP_INLINE bool empty() const {
+            return ring_.empty() && overflow_.empty();
+        }
+
+      private:
+        // Ring queue
+        freelock_ring_queue<element_type> ring_;
+        // Overflow queue
+        freelock_multi_queue<element_type> overflow_;
+    };
+
+}  // namespace toolkit
+}  // namespace pump
+
+#endif
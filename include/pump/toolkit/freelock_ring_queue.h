@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef pump_toolkit_freelock_ring_queue_h
+#define pump_toolkit_freelock_ring_queue_h
+
+#include <atomic>
+#include <type_traits>
+
+#include "pump/utils.h"
+#include "pump/debug.h"
+#include "pump/memory.h"
+#include "pump/platform.h"
+#include "pump/toolkit/features.h"
+
+namespace pump {
+namespace toolkit {
+
+    /*********************************************************************************
+     * Bounded multi producer and multi consumer ring queue
+     * Every slot has a sequence number. A slot is free for the producer of position p
+     * when its sequence is p, and it is ready for the consumer of position p when its
+     * sequence is p + 1. Slots are padded to cache line, and bulk operations claim
+     * many slots with one atomic operation.
+     ********************************************************************************/
+    template <typename T>
+    class LIB_PUMP freelock_ring_queue
+      : public noncopyable {
+
+      public:
+        // Element type
+        typedef T element_type;
+
+        struct alignas(CACHE_LINE_SIZE) element_node {
+            // Slot sequence
+            std::atomic<uint64_t> seq;
+            // Element data
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type data;
+        };
+
+      public:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        freelock_ring_queue(uint32_t size)
+          : size_(0),
+            size_mask_(0),
+            mem_(nullptr),
+            nodes_(nullptr),
+            write_index_(0),
+            read_index_(0) {
+            // Init ring size.
+            size_ = ceil_to_pow2(size > 2 ? size : 2);
+            // Init ring size mask.
+            size_mask_ = size_ - 1;
+            // Create element nodes aligned to cache line.
+            mem_ = pump_malloc(sizeof(element_node) * size_ + CACHE_LINE_SIZE);
+            PUMP_ASSERT(mem_);
+            nodes_ = (element_node*)(((uintptr_t)mem_ + CACHE_LINE_SIZE - 1) &
+                                     ~uintptr_t(CACHE_LINE_SIZE - 1));
+            for (uint64_t i = 0; i < size_; i++) {
+                new (&nodes_[i].seq) std::atomic<uint64_t>(i);
+            }
+        }
+
+        /*********************************************************************************
+         * Deconstructor
+         ********************************************************************************/
+        ~freelock_ring_queue() {
+            if (mem_) {
+                uint64_t beg = read_index_.load();
+                uint64_t end = write_index_.load();
+                for (uint64_t i = beg; i < end; i++) {
+                    __element(i)->~element_type();
+                }
+                pump_free(mem_);
+            }
+        }
+
+        /*********************************************************************************
+         * Push
+         * Return false if the queue is full.
+         ********************************************************************************/
+        template <typename U>
+        bool push(U &&data) {
+            uint64_t pos = write_index_.load(std::memory_order_relaxed);
+            do {
+                element_node *node = &nodes_[pos & size_mask_];
+                int64_t diff =
+                    int64_t(node->seq.load(std::memory_order_acquire)) - int64_t(pos);
+                if (diff == 0) {
+                    if (write_index_.compare_exchange_weak(pos,
+                                                           pos + 1,
+                                                           std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = write_index_.load(std::memory_order_relaxed);
+                }
+            } while (true);
+
+            __push_at(pos, std::forward<U>(data));
+
+            return true;
+        }
+
+        /*********************************************************************************
+         * Push bulk
+         * Push elements as many as possible with one claiming, and return pushed count.
+         ********************************************************************************/
+        template <typename It>
+        uint32_t push_bulk(It items, uint32_t count) {
+            uint64_t pos = write_index_.load(std::memory_order_relaxed);
+            uint32_t claimed = 0;
+            do {
+                // Free slots can only be taken by the producer claiming them.
+                claimed = 0;
+                while (claimed < count &&
+                       nodes_[(pos + claimed) & size_mask_].seq.load(
+                           std::memory_order_acquire) == pos + claimed) {
+                    claimed++;
+                }
+                if (claimed == 0) {
+                    uint64_t seq = nodes_[pos & size_mask_].seq.load(std::memory_order_relaxed);
+                    if (int64_t(seq) - int64_t(pos) < 0) {
+                        return 0;
+                    }
+                    pos = write_index_.load(std::memory_order_relaxed);
+                    continue;
+                }
+                if (write_index_.compare_exchange_weak(pos,
+                                                       pos + claimed,
+                                                       std::memory_order_relaxed)) {
+                    break;
+                }
+            } while (true);
+
+            for (uint32_t i = 0; i < claimed; i++, ++items) {
+                __push_at(pos + i, *items);
+            }
+
+            return claimed;
+        }
+
+        /*********************************************************************************
+         * Pop
+         * Return false if the queue is empty.
+         ********************************************************************************/
+        template <typename U>
+        bool pop(U &data) {
+            uint64_t pos = read_index_.load(std::memory_order_relaxed);
+            do {
+                element_node *node = &nodes_[pos & size_mask_];
+                int64_t diff =
+                    int64_t(node->seq.load(std::memory_order_acquire)) - int64_t(pos + 1);
+                if (diff == 0) {
+                    if (read_index_.compare_exchange_weak(pos,
+                                                          pos + 1,
+                                                          std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = read_index_.load(std::memory_order_relaxed);
+                }
+            } while (true);
+
+            __pop_at(pos, data);
+
+            return true;
+        }
+
+        /*********************************************************************************
+         * Pop bulk
+         * Pop ready elements at most max count with one claiming, and return popped
+         * count.
+         ********************************************************************************/
+        template <typename It>
+        uint32_t pop_bulk(It items, uint32_t max_count) {
+            uint64_t pos = read_index_.load(std::memory_order_relaxed);
+            uint32_t claimed = 0;
+            do {
+                // Ready slots can only be taken by the consumer claiming them.
+                claimed = 0;
+                while (claimed < max_count &&
+                       nodes_[(pos + claimed) & size_mask_].seq.load(
+                           std::memory_order_acquire) == pos + claimed + 1) {
+                    claimed++;
+                }
+                if (claimed == 0) {
+                    uint64_t seq = nodes_[pos & size_mask_].seq.load(std::memory_order_relaxed);
+                    if (int64_t(seq) - int64_t(pos + 1) < 0) {
+                        return 0;
+                    }
+                    pos = read_index_.load(std::memory_order_relaxed);
+                    continue;
+                }
+                if (read_index_.compare_exchange_weak(pos,
+                                                      pos + claimed,
+                                                      std::memory_order_relaxed)) {
+                    break;
+                }
+            } while (true);
+
+            for (uint32_t i = 0; i < claimed; i++, ++items) {
+                __pop_at(pos + i, *items);
+            }
+
+            return claimed;
+        }
+
+        /*********************************************************************************
+         * Get size
+         ********************************************************************************/
+        PUMP_INLINE int32_t size() const {
+            uint64_t cur_read_index = read_index_.load(std::memory_order_relaxed);
+            uint64_t cur_write_index = write_index_.load(std::memory_order_relaxed);
+            if (cur_write_index > cur_read_index) {
+                return int32_t(cur_write_index - cur_read_index);
+            }
+            return 0;
+        }
+
+        /*********************************************************************************
+         * Empty
+         ********************************************************************************/
+        PUMP_INLINE bool empty() const {
+            return size() == 0;
+        }
+
+        /*********************************************************************************
+         * Get capacity
+         ********************************************************************************/
+        PUMP_INLINE int32_t capacity() const {
+            return int32_t(size_);
+        }
+
+      private:
+        /*********************************************************************************
+         * Get element at position
+         ********************************************************************************/
+        PUMP_INLINE element_type* __element(uint64_t pos) {
+            return (element_type*)&nodes_[pos & size_mask_].data;
+        }
+
+        /*********************************************************************************
+         * Push element at claimed position
+         ********************************************************************************/
+        template <typename U>
+        PUMP_INLINE void __push_at(uint64_t pos, U &&data) {
+            element_node *node = &nodes_[pos & size_mask_];
+            new (&node->data) element_type(std::forward<U>(data));
+            node->seq.store(pos + 1, std::memory_order_release);
+        }
+
+        /*********************************************************************************
+         * Pop element at claimed position
+         ********************************************************************************/
+        template <typename U>
+        PUMP_INLINE void __pop_at(uint64_t pos, U &data) {
+            element_node *node = &nodes_[pos & size_mask_];
+            element_type *elem = (element_type*)&node->data;
+            data = std::move(*elem);
+            elem->~element_type();
+            node->seq.store(pos + size_, std::memory_order_release);
+        }
+
+      private:
+        // Ring size
+        uint64_t size_;
+        // Ring size mask
+        uint64_t size_mask_;
+
+        // Element nodes memory
+        void *mem_;
+        // Element nodes aligned to cache line
+        element_node *nodes_;
+
+        // Next write index, it is padded to its own cache line
+        block_t write_pad_[CACHE_LINE_SIZE];
+        std::atomic<uint64_t> write_index_;
+        // Next read index, it is padded to its own cache line
+        block_t read_pad_[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)];
+        std::atomic<uint64_t> read_index_;
+        block_t end_pad_[CACHE_LINE_SIZE - sizeof(std::atomic<uint64_t>)];
+    };
+
+}  // namespace toolkit
+}  // namespace pump
+
+#endif
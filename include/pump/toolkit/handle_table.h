@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef pump_toolkit_handle_table_h
+#define pump_toolkit_handle_table_h
+
+#include <atomic>
+#include <memory>
+
+#include "pump/debug.h"
+#include "pump/memory.h"
+#include "pump/toolkit/features.h"
+
+namespace pump {
+namespace toolkit {
+
+    /*********************************************************************************
+     * Handle table
+     * It keeps shared objects in slots and addresses them with 64-bit handles, high 32
+     * bits of a handle are slot generation and low 32 bits are slot index plus one, so
+     * zero is an invalid handle. Generation is increased when a slot is released, so a
+     * stale handle never reaches a new object in the same slot.
+     *
+     * Slot state packs generation, pin count and live bit. Pinning an object only
+     * increases the pin count of its slot. Removing clears the live bit, then the last
+     * one of remover and unpinners releases the object and frees the slot.
+     *
+     * Slots are allocated by chunks and never freed before the table, so free slot
+     * list can be a lock-free stack with a tag against ABA.
+     ********************************************************************************/
+    template <typename T>
+    class LIB_PUMP handle_table
+      : public noncopyable {
+
+      public:
+        // Object type
+        typedef T object_type;
+        // Object shared pointer type
+        typedef std::shared_ptr<T> object_sptr;
+
+        // Invalid handle
+        constexpr static uint64_t INVALID_HANDLE = 0;
+
+      protected:
+        // Slot count of a chunk
+        constexpr static uint32_t CHUNK_SIZE = 4096;
+        // Max chunk count
+        constexpr static uint32_t MAX_CHUNKS = 4096;
+
+        // Slot state bits
+        constexpr static uint64_t STATE_LIVE = 1;
+        constexpr static uint64_t STATE_PIN_ONE = 2;
+        constexpr static uint64_t STATE_PIN_MASK = 0xfffffffe;
+        constexpr static uint64_t STATE_GEN_ONE = uint64_t(1) << 32;
+
+        struct slot {
+            // Generation, pin count and live bit
+            std::atomic<uint64_t> state;
+            // Next free slot index plus one
+            std::atomic<uint32_t> next_free;
+            // Object
+            object_sptr obj;
+        };
+
+      public:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        handle_table() noexcept
+          : free_head_(0),
+            next_index_(0),
+            size_(0) {
+            for (uint32_t i = 0; i < MAX_CHUNKS; i++) {
+                chunks_[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        /*********************************************************************************
+         * Deconstructor
+         ********************************************************************************/
+        ~handle_table() {
+            for (uint32_t i = 0; i < MAX_CHUNKS; i++) {
+                slot *chunk = chunks_[i].load(std::memory_order_relaxed);
+                if (chunk == nullptr) {
+                    break;
+                }
+                for (uint32_t k = 0; k < CHUNK_SIZE; k++) {
+                    chunk[k].~slot();
+                }
+                pump_free(chunk);
+            }
+        }
+
+        /*********************************************************************************
+         * Insert object
+         * Return invalid handle if object is null or slots are exhausted.
+         ********************************************************************************/
+        uint64_t insert(const object_sptr &obj) {
+            if (!obj) {
+                return INVALID_HANDLE;
+            }
+
+            uint32_t index = __alloc_slot();
+            if (index == 0) {
+                return INVALID_HANDLE;
+            }
+            slot *s = __get_slot(index);
+            s->obj = obj;
+
+            uint64_t state = s->state.load(std::memory_order_relaxed);
+            s->state.store(state | STATE_LIVE, std::memory_order_release);
+            size_.fetch_add(1, std::memory_order_relaxed);
+
+            return (state & ~(STATE_GEN_ONE - 1)) | index;
+        }
+
+        /*********************************************************************************
+         * Remove object
+         * Object is released at once if it is not pinned, or it is released by the last
+         * unpinning. Return false if handle is stale.
+         ********************************************************************************/
+        bool remove(uint64_t handle) {
+            slot *s = __find_slot(handle);
+            if (s == nullptr) {
+                return false;
+            }
+            uint64_t state = s->state.load(std::memory_order_acquire);
+            do {
+                if (!__is_live(state, handle)) {
+                    return false;
+                }
+            } while (!s->state.compare_exchange_weak(state,
+                                                     state & ~STATE_LIVE,
+                                                     std::memory_order_acq_rel,
+                                                     std::memory_order_acquire));
+            size_.fetch_sub(1, std::memory_order_relaxed);
+            if ((state & STATE_PIN_MASK) == 0) {
+                __release_slot(s, uint32_t(handle));
+            }
+            return true;
+        }
+
+        /*********************************************************************************
+         * Pin object
+         * Pinned object is kept until unpinning even if it is removed. Return nullptr if
+         * handle is stale.
+         ********************************************************************************/
+        PUMP_INLINE T* pin(uint64_t handle) {
+            slot *s = __find_slot(handle);
+            if (PUMP_UNLIKELY(s == nullptr)) {
+                return nullptr;
+            }
+            uint64_t state = s->state.load(std::memory_order_acquire);
+            do {
+                if (!__is_live(state, handle)) {
+                    return nullptr;
+                }
+            } while (!s->state.compare_exchange_weak(state,
+                                                     state + STATE_PIN_ONE,
+                                                     std::memory_order_acquire,
+                                                     std::memory_order_acquire));
+            return s->obj.get();
+        }
+
+        /*********************************************************************************
+         * Unpin object
+         * Handle must be pinned before.
+         ********************************************************************************/
+        PUMP_INLINE void unpin(uint64_t handle) {
+            slot *s = __get_slot(uint32_t(handle));
+            uint64_t state = s->state.fetch_sub(STATE_PIN_ONE, std::memory_order_acq_rel);
+            PUMP_ASSERT((state & STATE_PIN_MASK) != 0);
+            if (PUMP_UNLIKELY((state & (STATE_PIN_MASK | STATE_LIVE)) == STATE_PIN_ONE)) {
+                __release_slot(s, uint32_t(handle));
+            }
+        }
+
+        /*********************************************************************************
+         * Get object
+         * Return shared pointer of object, or empty pointer if handle is stale.
+         ********************************************************************************/
+        object_sptr get(uint64_t handle) {
+            object_sptr obj;
+            if (pin(handle) != nullptr) {
+                obj = __get_slot(uint32_t(handle))->obj;
+                unpin(handle);
+            }
+            return obj;
+        }
+
+        /*********************************************************************************
+         * Clear
+         * Remove all live objects.
+         ********************************************************************************/
+        void clear() {
+            uint32_t count = next_index_.load(std::memory_order_acquire);
+            for (uint32_t index = 1; index <= count; index++) {
+                slot *s = __find_slot(index);
+                if (s == nullptr) {
+                    break;
+                }
+                uint64_t state = s->state.load(std::memory_order_acquire);
+                if ((state & STATE_LIVE) != 0) {
+                    remove((state & ~(STATE_GEN_ONE - 1)) | index);
+                }
+            }
+        }
+
+        /*********************************************************************************
+         * Get live object count
+         ********************************************************************************/
+        PUMP_INLINE uint32_t size() const {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+      private:
+        /*********************************************************************************
+         * Check slot state is live for the handle
+         ********************************************************************************/
+        PUMP_INLINE static bool __is_live(uint64_t state, uint64_t handle) {
+            return (state & STATE_LIVE) != 0 && (state >> 32) == (handle >> 32);
+        }
+
+        /*********************************************************************************
+         * Get slot by index
+         * Index is slot index plus one, and the slot must be allocated.
+         ********************************************************************************/
+        PUMP_INLINE slot* __get_slot(uint32_t index) {
+            uint32_t pos = index - 1;
+            return chunks_[pos / CHUNK_SIZE].load(std::memory_order_acquire) + pos % CHUNK_SIZE;
+        }
+
+        /*********************************************************************************
+         * Find slot by handle
+         * Return nullptr if the handle is out of created chunks.
+         ********************************************************************************/
+        PUMP_INLINE slot* __find_slot(uint64_t handle) {
+            uint32_t index = uint32_t(handle);
+            if (PUMP_UNLIKELY(index == 0 || index > CHUNK_SIZE * MAX_CHUNKS)) {
+                return nullptr;
+            }
+            uint32_t pos = index - 1;
+            slot *chunk = chunks_[pos / CHUNK_SIZE].load(std::memory_order_acquire);
+            if (PUMP_UNLIKELY(chunk == nullptr)) {
+                return nullptr;
+            }
+            return chunk + pos % CHUNK_SIZE;
+        }
+
+        /*********************************************************************************
+         * Allocate slot
+         * Return slot index plus one, or zero if slots are exhausted.
+         ********************************************************************************/
+        uint32_t __alloc_slot() {
+            // Pop free slot list at first.
+            uint64_t head = free_head_.load(std::memory_order_acquire);
+            while (uint32_t(head) != 0) {
+                uint32_t next = __get_slot(uint32_t(head))->next_free.load(
+                                    std::memory_order_relaxed);
+                uint64_t new_head = ((head >> 32) + 1) << 32 | next;
+                if (free_head_.compare_exchange_weak(head,
+                                                     new_head,
+                                                     std::memory_order_acquire,
+                                                     std::memory_order_acquire)) {
+                    return uint32_t(head);
+                }
+            }
+
+            // Allocate a new slot.
+            uint32_t index = next_index_.load(std::memory_order_relaxed);
+            do {
+                if (index >= CHUNK_SIZE * MAX_CHUNKS) {
+                    PUMP_WARN_LOG("handle_table: alloc slot failed for slots exhausted");
+                    return 0;
+                }
+            } while (!next_index_.compare_exchange_weak(index,
+                                                        index + 1,
+                                                        std::memory_order_relaxed));
+            if (!__ensure_chunk(index / CHUNK_SIZE)) {
+                return 0;
+            }
+            return index + 1;
+        }
+
+        /*********************************************************************************
+         * Release slot
+         * Release object, increase generation and push slot to free slot list.
+         ********************************************************************************/
+        void __release_slot(slot *s, uint32_t index) {
+            s->obj.reset();
+            uint64_t state = s->state.load(std::memory_order_relaxed);
+            s->state.store((state & ~(STATE_GEN_ONE - 1)) + STATE_GEN_ONE,
+                           std::memory_order_release);
+
+            uint64_t head = free_head_.load(std::memory_order_relaxed);
+            do {
+                s->next_free.store(uint32_t(head), std::memory_order_relaxed);
+            } while (!free_head_.compare_exchange_weak(head,
+                                                       ((head >> 32) + 1) << 32 | index,
+                                                       std::memory_order_release,
+                                                       std::memory_order_relaxed));
+        }
+
+        /*********************************************************************************
+         * Ensure chunk created
+         ********************************************************************************/
+        bool __ensure_chunk(uint32_t ci) {
+            if (PUMP_LIKELY(chunks_[ci].load(std::memory_order_acquire) != nullptr)) {
+                return true;
+            }
+
+            slot *chunk = (slot*)pump_malloc(sizeof(slot) * CHUNK_SIZE);
+            if (chunk == nullptr) {
+                PUMP_WARN_LOG("handle_table: ensure chunk failed for allocating failed");
+                return false;
+            }
+            for (uint32_t k = 0; k < CHUNK_SIZE; k++) {
+                slot *s = new (chunk + k) slot;
+                s->state.store(0, std::memory_order_relaxed);
+                s->next_free.store(0, std::memory_order_relaxed);
+            }
+
+            slot *exp = nullptr;
+            if (!chunks_[ci].compare_exchange_strong(exp,
+                                                     chunk,
+                                                     std::memory_order_acq_rel,
+                                                     std::memory_order_acquire)) {
+                for (uint32_t k = 0; k < CHUNK_SIZE; k++) {
+                    chunk[k].~slot();
+                }
+                pump_free(chunk);
+            }
+            return true;
+        }
+
+      private:
+        // Free slot list head, high 32 bits are tag and low 32 bits are index plus one
+        std::atomic<uint64_t> free_head_;
+        // Next new slot index
+        std::atomic<uint32_t> next_index_;
+        // Live object count
+        std::atomic<uint32_t> size_;
+        // Slot chunks
+        std::atomic<slot*> chunks_[MAX_CHUNKS];
+    };
+
+}  // namespace toolkit
+}  // namespace pump
+
+#endif
@@ -24,6 +24,7 @@
 #include "pump/toolkit/features.h"
 
 #if defined(OS_LINUX)
+#include <errno.h>
 #include <semaphore.h>
 #endif
 
@@ -21,11 +21,86 @@
 
 #include "pump/types.h"
 #include "pump/platform.h"
+#include "pump/toolkit/features.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
 
 namespace pump {
 namespace toolkit {
 
-    class LIB_PUMP spin_mutex {
+    /*********************************************************************************
+     * Relax cpu in spinning loop
+     ********************************************************************************/
+    PUMP_INLINE void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+#else
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+    /*********************************************************************************
+     * Spin backoff
+     * Every pausing doubles relaxing count until the max count. After yield_rounds
+     * pausings, every pausing yields cpu, so waiter does not starve lock holder when
+     * threads are more than cpus.
+     ********************************************************************************/
+    class LIB_PUMP spin_backoff {
+
+      public:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        spin_backoff(int32_t yield_rounds) noexcept
+          : spins_(1),
+            rounds_(0),
+            yield_rounds_(yield_rounds) {
+        }
+
+        /*********************************************************************************
+         * Pause
+         ********************************************************************************/
+        PUMP_INLINE void pause() {
+            if (rounds_ >= yield_rounds_) {
+                pump_sched_yield();
+                return;
+            }
+            rounds_++;
+            for (int32_t i = 0; i < spins_; i++) {
+                cpu_relax();
+            }
+            if (spins_ < MAX_SPINS) {
+                spins_ <<= 1;
+            }
+        }
+
+      private:
+        // Max relaxing count of one pausing
+        constexpr static int32_t MAX_SPINS = 64;
+        // Relaxing count of next pausing
+        int32_t spins_;
+        // Pausing count
+        int32_t rounds_;
+        // Pausing count before yielding
+        int32_t yield_rounds_;
+    };
+
+    /*********************************************************************************
+     * Spin mutex
+     * It is a test and test-and-set lock with exponential backoff. It is cheapest when
+     * contention is low, but it is not fair.
+     *
+     * Spin mutex, ticket mutex and mcs mutex share the same interface, so they can
+     * replace each other and work with std::lock_guard.
+     ********************************************************************************/
+    class LIB_PUMP spin_mutex
+      : public noncopyable {
 
       public:
         /*********************************************************************************
@@ -41,36 +116,174 @@ namespace toolkit {
         /*********************************************************************************
          * Lock
          ********************************************************************************/
-        void lock();
+        PUMP_INLINE void lock() {
+            if (PUMP_UNLIKELY(locked_.exchange(true, std::memory_order_acquire))) {
+                __lock_slow();
+            }
+        }
 
         /*********************************************************************************
          * Try lock
          ********************************************************************************/
         PUMP_INLINE bool try_lock() {
-            bool exp = false;
-            return locked_.compare_exchange_strong(exp, true);
+            return !locked_.load(std::memory_order_relaxed) &&
+                   !locked_.exchange(true, std::memory_order_acquire);
         }
 
         /*********************************************************************************
          * Unlock
          ********************************************************************************/
         PUMP_INLINE void unlock() {
-            locked_.store(false);
+            locked_.store(false, std::memory_order_release);
         }
 
         /*********************************************************************************
          * Get locked status
          ********************************************************************************/
         PUMP_INLINE bool is_locked() const {
-            return locked_.load();
+            return locked_.load(std::memory_order_relaxed);
         }
 
+      private:
+        /*********************************************************************************
+         * Lock with backoff
+         ********************************************************************************/
+        void __lock_slow();
+
       private:
         int32_t per_loop_;
         std::atomic_bool locked_;
     };
 
+    /*********************************************************************************
+     * Ticket mutex
+     * Waiters get the lock in arriving order. It is fair, but all waiters spin on the
+     * same cache line, and a waiter being descheduled blocks all waiters behind it.
+     ********************************************************************************/
+    class LIB_PUMP ticket_mutex
+      : public noncopyable {
+
+      public:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        ticket_mutex(int32_t per_loop = 32) noexcept;
+
+        /*********************************************************************************
+         * Deconstructor
+         ********************************************************************************/
+        ~ticket_mutex() = default;
+
+        /*********************************************************************************
+         * Lock
+         ********************************************************************************/
+        PUMP_INLINE void lock() {
+            uint32_t ticket = next_.fetch_add(1, std::memory_order_relaxed);
+            if (PUMP_UNLIKELY(serving_.load(std::memory_order_acquire) != ticket)) {
+                __lock_slow(ticket);
+            }
+        }
+
+        /*********************************************************************************
+         * Try lock
+         ********************************************************************************/
+        PUMP_INLINE bool try_lock() {
+            uint32_t ticket = serving_.load(std::memory_order_relaxed);
+            return next_.compare_exchange_strong(
+                ticket, ticket + 1, std::memory_order_acquire, std::memory_order_relaxed);
+        }
+
+        /*********************************************************************************
+         * Unlock
+         ********************************************************************************/
+        PUMP_INLINE void unlock() {
+            serving_.store(serving_.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_release);
+        }
+
+        /*********************************************************************************
+         * Get locked status
+         ********************************************************************************/
+        PUMP_INLINE bool is_locked() const {
+            return next_.load(std::memory_order_relaxed) !=
+                   serving_.load(std::memory_order_relaxed);
+        }
+
+      private:
+        /*********************************************************************************
+         * Lock with backoff
+         ********************************************************************************/
+        void __lock_slow(uint32_t ticket);
+
+      private:
+        int32_t per_loop_;
+        // Next ticket
+        std::atomic<uint32_t> next_;
+        block_t padding_[CACHE_LINE_SIZE];
+        // Serving ticket
+        std::atomic<uint32_t> serving_;
+    };
+
+    /*********************************************************************************
+     * Mcs mutex
+     * Waiters queue up in arriving order, and every waiter spins on its own node, so
+     * unlocking only touches the cache line of the next waiter. It scales best when
+     * contention is high, but costs more than spin mutex when contention is low.
+     * Queue nodes are cached per thread.
+     ********************************************************************************/
+    class LIB_PUMP mcs_mutex
+      : public noncopyable {
+
+      public:
+        // Queue node
+        struct mcs_node {
+            std::atomic<mcs_node*> next;
+            std::atomic_bool locked;
+            mcs_node *free_next;
+        };
+
+      public:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        mcs_mutex(int32_t per_loop = 32) noexcept;
+
+        /*********************************************************************************
+         * Deconstructor
+         ********************************************************************************/
+        ~mcs_mutex() = default;
+
+        /*********************************************************************************
+         * Lock
+         ********************************************************************************/
+        void lock();
+
+        /*********************************************************************************
+         * Try lock
+         ********************************************************************************/
+        bool try_lock();
+
+        /*********************************************************************************
+         * Unlock
+         ********************************************************************************/
+        void unlock();
+
+        /*********************************************************************************
+         * Get locked status
+         ********************************************************************************/
+        PUMP_INLINE bool is_locked() const {
+            return tail_.load(std::memory_order_relaxed) != nullptr;
+        }
+
+      private:
+        int32_t per_loop_;
+        // Queue tail node
+        std::atomic<mcs_node*> tail_;
+        // Node of lock holder, it is only accessed by lock holder.
+        mcs_node *owner_;
+    };
+
 }  // namespace toolkit
 }  // namespace pump
 
-#endif
\ No newline at end of file
+#endif
@@ -18,6 +18,7 @@
 #define pump_transport_address_h
 
 #include <string>
+#include <functional>
 
 #include "pump/utils.h"
 #include "pump/net/socket.h"
@@ -97,6 +98,20 @@ namespace transport {
          ********************************************************************************/
         bool operator<(const address &other) const noexcept;
 
+        /*********************************************************************************
+         * Get hash value
+         * This hashes raw address bytes, so it is cheap enough for per packet lookups.
+         ********************************************************************************/
+        PUMP_INLINE size_t hash() const noexcept {
+            // FNV-1a hash.
+            uint64_t h = 14695981039346656037ULL;
+            for (int32_t i = 0; i < addrlen_; i++) {
+                h ^= (uint8_t)addr_[i];
+                h *= 1099511628211ULL;
+            }
+            return (size_t)h;
+        }
+
       private:
         bool is_v6_;
 
@@ -108,4 +123,15 @@ namespace transport {
 }  // namespace transport
 }  // namespace pump
 
+namespace std {
+
+    template <>
+    struct hash<pump::transport::address> {
+        PUMP_INLINE size_t operator()(const pump::transport::address &addr) const noexcept {
+            return addr.hash();
+        }
+    };
+
+}  // namespace std
+
 #endif
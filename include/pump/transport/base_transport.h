@@ -41,6 +41,8 @@ namespace transport {
     const int32_t TLS_DIALER = 5;
     const int32_t TLS_HANDSHAKER = 6;
     const int32_t TLS_TRANSPORT = 7;
+    const int32_t UDP_SESSION = 8;
+    const int32_t RUDP_TRANSPORT = 9;
 
     /*********************************************************************************
      * Transport state
@@ -130,7 +132,7 @@ namespace transport {
          * Post channel event
          ********************************************************************************/
         PUMP_INLINE void __post_channel_event(poll::channel_sptr &&ch, int32_t event) {
-            get_service()->post_channel_event(ch, event);
+            get_service()->post_channel_event(std::move(ch), event);
         }
         PUMP_INLINE void __post_channel_event(poll::channel_sptr &ch, int32_t event) {
             get_service()->post_channel_event(ch, event);
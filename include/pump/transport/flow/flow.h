@@ -30,6 +30,12 @@ namespace flow {
 
     #define MAX_TCP_BUFFER_SIZE 4096 // 4KB
     #define MAX_UDP_BUFFER_SIZE 8192 // 8KB
+    #define MAX_UDP_SEND_BATCH 32
+
+    #define TLS_SMALL_RECORD_SIZE 1400 // Fit in one tcp segment
+    #define TLS_MAX_RECORD_SIZE 16384 // 16KB
+    #define TLS_BULK_SEND_SIZE 1048576 // 1MB
+    #define TLS_RECORD_IDLE_TIMEOUT 1000 // 1s
 
     const int32_t FLOW_ERR_NO = 0;
     const int32_t FLOW_ERR_ABORT = 1;
@@ -23,7 +23,7 @@ namespace pump {
 namespace transport {
 namespace flow {
 
-    class flow_tcp
+    class flow_tcp final
       : public flow_base {
 
       public:
@@ -60,7 +60,10 @@ namespace flow {
          *      FLOW_ERR_AGAIN => try again
          *      FLOW_ERR_ABORT => error
          ********************************************************************************/
-        int32_t want_to_send(toolkit::io_buffer_ptr iob);
+        PUMP_INLINE int32_t want_to_send(toolkit::io_buffer_ptr iob) {
+            PUMP_DEBUG_ASSIGN(iob, send_iob_, iob);
+            return __send_iob();
+        }
 
         /*********************************************************************************
          * Send
@@ -69,7 +72,11 @@ namespace flow {
          *     FLOW_ERR_AGAIN   => try again
          *     FLOW_ERR_ABORT   => error
          ********************************************************************************/
-        int32_t send();
+        PUMP_INLINE int32_t send() {
+            PUMP_ASSERT(send_iob_);
+            PUMP_ASSERT(send_iob_->data_size() > 0);
+            return __send_iob();
+        }
 
         /*********************************************************************************
          * Check there are data to send or not
@@ -78,6 +85,27 @@ namespace flow {
             return (send_iob_ && send_iob_->data_size() > 0);
         }
 
+      private:
+        /*********************************************************************************
+         * Send io buffer
+         ********************************************************************************/
+        PUMP_INLINE int32_t __send_iob() {
+            int32_t size = net::send(fd_, send_iob_->data(), (int32_t)send_iob_->data_size());
+            if (PUMP_LIKELY(size > 0)) {
+                if (PUMP_LIKELY(send_iob_->shift(size) == 0)) {
+                    send_iob_ = nullptr;
+                    return FLOW_ERR_NO;
+                }
+                return FLOW_ERR_AGAIN;
+            } else if (size < 0) {
+                return FLOW_ERR_AGAIN;
+            }
+
+            PUMP_DEBUG_LOG("flow_tcp: send failed %d", size);
+
+            return FLOW_ERR_ABORT;
+        }
+
       private:
         // Send buffer
         toolkit::io_buffer_ptr send_iob_;
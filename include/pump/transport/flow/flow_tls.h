@@ -18,6 +18,7 @@
 #define pump_transport_flow_tls_h
 
 #include "pump/ssl/tls_helper.h"
+#include "pump/ssl/tls_session_cache.h"
 #include "pump/transport/flow/flow.h"
 
 namespace pump {
@@ -31,6 +32,9 @@ namespace flow {
       : public flow_base {
 
       public:
+        // Objects are allocated from object pool
+        PUMP_ENABLE_OBJECT_POOL(flow_tls);
+
         /*********************************************************************************
          * Constructor
          ********************************************************************************/
@@ -43,6 +47,8 @@ namespace flow {
 
         /*********************************************************************************
          * Init flow
+         * With memory io, tls library does no socket io and flow reads and sends
+         * ciphertext in large chunks by itself.
          * Return results:
          *     FLOW_ERR_NO    => success
          *     FLOW_ERR_ABORT => error
@@ -50,7 +56,8 @@ namespace flow {
         int32_t init(poll::channel_sptr &ch,
                      pump_socket fd,
                      void_ptr xcred,
-                     bool client);
+                     bool client,
+                     bool memory_io = false);
 
         /*********************************************************************************
          * Handshake
@@ -61,21 +68,62 @@ namespace flow {
          *     TLS_HANDSHAKE_ERROR
          ********************************************************************************/
         PUMP_INLINE int32_t handshake() {
-            return ssl::tls_handshake(session_);
+            if (ssl::tls_is_memory_session(session_)) {
+                return __memory_handshake();
+            }
+            if (is_handshaked_) {
+                return ssl::TLS_HANDSHAKE_OK;
+            }
+            int32_t ret = ssl::tls_handshake(session_);
+            if (ret == ssl::TLS_HANDSHAKE_OK) {
+                __on_handshaked();
+            }
+            return ret;
+        }
+
+        /*********************************************************************************
+         * Set session cache
+         * Client flow resumes the cached session of the key, and saves the session to the
+         * cache once it is resumable. TLS 1.3 session ticket arrives after handshake, so
+         * it is checked when reading too. It must be set before handshake.
+         ********************************************************************************/
+        void set_session_cache(ssl::tls_session_cache_sptr &cache, const std::string &key);
+
+        /*********************************************************************************
+         * Check session resumed or not
+         ********************************************************************************/
+        PUMP_INLINE bool is_session_resumed() const {
+            return ssl::tls_is_session_resumed(session_);
         }
 
         /*********************************************************************************
          * Read
+         * With kernel tls receiving, tls library just reads decrypted data from socket,
+         * and handles non application data records.
+         * With memory io, records written by tls library when reading are sent with
+         * next sending.
          ********************************************************************************/
         PUMP_INLINE int32_t read(block_t* b, int32_t size) {
-            return ssl::tls_read(session_, b, size);
+            int32_t ret = ssl::tls_read(session_, b, size);
+            if (ret < 0 && ssl::tls_is_memory_session(session_)) {
+                ret = __memory_read(b, size);
+            }
+            if (PUMP_UNLIKELY(session_cache_ && !session_saved_)) {
+                __save_session();
+            }
+            return ret;
         }
 
         /*********************************************************************************
          * Check there are data to read or not
+         * With memory io, only a full record in net read buffer can be read, a partial
+         * record needs more data from socket.
          ********************************************************************************/
         PUMP_INLINE bool has_unread_data() const {
             PUMP_ASSERT(session_);
+            if (ssl::tls_is_memory_session(session_) && __has_full_net_record()) {
+                return true;
+            }
             return ssl::tls_has_unread_data(session_);
         }
 
@@ -104,6 +152,9 @@ namespace flow {
          ********************************************************************************/
         PUMP_INLINE bool has_unsend_data() const {
             PUMP_ASSERT(session_);
+            if (ssl::tls_is_memory_session(session_)) {
+                return session_->net_send_iob->data_size() > 0;
+            }
             return false;
         }
 
@@ -114,13 +165,109 @@ namespace flow {
             return is_handshaked_;
         }
 
-        private:
+        /*********************************************************************************
+         * Get record size
+         * Records start small for fast first bytes, and grow to the max record size
+         * after bulk data is sent. Record size resets when sending idle for a while.
+         ********************************************************************************/
+        PUMP_INLINE int32_t get_record_size() const {
+            return record_size_;
+        }
+
+        /*********************************************************************************
+         * Check kernel tls sending offloaded or not
+         * If offloaded, application data is sent to socket directly like tcp flow.
+         ********************************************************************************/
+        PUMP_INLINE bool is_kernel_send_offloaded() const {
+            return (ktls_state_ & ssl::TLS_KTLS_SEND) != 0;
+        }
+
+      private:
+        /*********************************************************************************
+         * Handshaked callback
+         ********************************************************************************/
+        void __on_handshaked();
+
+        /*********************************************************************************
+         * Handshake with memory io
+         * Handshake data is read and sent by flow until tls library wants more data
+         * from or to socket.
+         ********************************************************************************/
+        int32_t __memory_handshake();
+
+        /*********************************************************************************
+         * Read with memory io
+         * Return results same as read.
+         ********************************************************************************/
+        int32_t __memory_read(block_t* b, int32_t size);
+
+        /*********************************************************************************
+         * Check a full record is in net read buffer or not
+         * Record header is 1 byte type, 2 bytes version and 2 bytes payload length.
+         ********************************************************************************/
+        PUMP_INLINE bool __has_full_net_record() const {
+            toolkit::io_buffer_ptr iob = session_->net_read_iob;
+            uint32_t size = iob->data_size();
+            if (size < 5) {
+                return false;
+            }
+            const uint8_t *header = (const uint8_t*)iob->data();
+            return size >= 5 + (((uint32_t)header[3] << 8) | header[4]);
+        }
+
+        /*********************************************************************************
+         * Send with memory io
+         * All data of send buffer is encrypted to net send buffer, and sent by one
+         * socket writing as much as possible.
+         ********************************************************************************/
+        int32_t __memory_send();
+
+        /*********************************************************************************
+         * Read ciphertext from socket to net read buffer
+         * Return read size, -1 if would block, 0 if socket closed or error.
+         ********************************************************************************/
+        int32_t __read_from_net();
+
+        /*********************************************************************************
+         * Send ciphertext of net send buffer to socket
+         * Return results:
+         *     FLOW_ERR_NO      => send completely
+         *     FLOW_ERR_AGAIN   => try again
+         *     FLOW_ERR_ABORT   => error
+         ********************************************************************************/
+        int32_t __send_to_net();
+
+        /*********************************************************************************
+         * Update record size
+         ********************************************************************************/
+        void __update_record_size(int32_t size);
+
+        /*********************************************************************************
+         * Save session to session cache
+         ********************************************************************************/
+        void __save_session();
+
+      private:
         // Handshaked status
         bool is_handshaked_;
+        // Kernel tls offload state
+        int32_t ktls_state_;
         // TLS session
         ssl::tls_session_ptr session_;
         // Current sending io buffer
         toolkit::io_buffer_ptr send_iob_;
+        // Current record size
+        int32_t record_size_;
+        // Sent size since record size reset
+        int64_t bulk_sent_size_;
+        // Last sending time
+        uint64_t last_send_time_;
+        // Client session cache
+        ssl::tls_session_cache_sptr session_cache_;
+        // Session cache key
+        std::string session_key_;
+        // Session saved or not
+        bool session_saved_;
     };
     DEFINE_ALL_POINTER_TYPE(flow_tls);
 
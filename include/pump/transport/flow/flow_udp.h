@@ -63,6 +63,14 @@ namespace flow {
          * Return sent size.
          ********************************************************************************/
         int32_t send(const block_t *b, int32_t size, const address &to_address);
+
+        /*********************************************************************************
+         * Send datagrams in batch
+         * Return sent datagram count, -1 if would block or 0 if failed.
+         ********************************************************************************/
+        PUMP_INLINE int32_t send_batch(net::datagram *dgs, int32_t count) {
+            return net::send_to_batch(fd_, dgs, count);
+        }
     };
     DEFINE_ALL_POINTER_TYPE(flow_udp);
 
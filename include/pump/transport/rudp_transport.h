@@ -0,0 +1,304 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_transport_rudp_transport_h
+#define pump_transport_rudp_transport_h
+
+#include <map>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "pump/time/timer.h"
+#include "pump/transport/flow/flow.h"
+#include "pump/transport/base_transport.h"
+
+namespace pump {
+namespace transport {
+
+    /*********************************************************************************
+     * Rudp options
+     ********************************************************************************/
+    struct rudp_options {
+        rudp_options() noexcept
+          : mtu(1200),
+            send_window(128),
+            recv_window(128),
+            interval(10),
+            fast_resend(2),
+            min_rto(30),
+            pacing(0),
+            dead_link(20) {
+        }
+        // Max datagram size
+        int32_t mtu;
+        // Send window in segments
+        int32_t send_window;
+        // Receive window in segments
+        int32_t recv_window;
+        // Update interval in milliseconds
+        int32_t interval;
+        // Duplicate ack count to trigger fast retransmit, zero to disable
+        int32_t fast_resend;
+        // Min retransmit timeout in milliseconds
+        int32_t min_rto;
+        // Max segments sent in one update interval, zero to disable pacing
+        int32_t pacing;
+        // Max transmit count of one segment before disconnected
+        int32_t dead_link;
+    };
+
+    class rudp_transport;
+    DEFINE_ALL_POINTER_TYPE(rudp_transport);
+
+    /*********************************************************************************
+     * Rudp transport
+     * Rudp transport is a reliable ordered stream transport implementing selective
+     * repeat ARQ over a datagram transport, which should be an udp session of the
+     * remote peer. Both peers should use rudp transport with the same mtu.
+     ********************************************************************************/
+    class LIB_PUMP rudp_transport final
+      : public base_transport {
+
+      public:
+        /*********************************************************************************
+         * Create instance
+         ********************************************************************************/
+        PUMP_INLINE static rudp_transport_sptr create(
+            base_transport_sptr datagram_transport,
+            const rudp_options &opts = rudp_options()) {
+            INLINE_OBJECT_CREATE(obj, rudp_transport, (datagram_transport, opts));
+            return rudp_transport_sptr(obj, object_delete<rudp_transport>);
+        }
+
+        /*********************************************************************************
+         * Deconstructor
+         ********************************************************************************/
+        virtual ~rudp_transport();
+
+        /*********************************************************************************
+         * Start
+         ********************************************************************************/
+        virtual int32_t start(service_ptr sv, const transport_callbacks &cbs) override;
+
+        /*********************************************************************************
+         * Stop
+         ********************************************************************************/
+        virtual void stop() override;
+
+        /*********************************************************************************
+         * Force stop
+         ********************************************************************************/
+        virtual void force_stop() override {
+            stop();
+        }
+
+        /*********************************************************************************
+         * Read for once
+         ********************************************************************************/
+        virtual int32_t read_for_once() override;
+
+        /*********************************************************************************
+         * Read for loop
+         ********************************************************************************/
+        virtual int32_t read_for_loop() override;
+
+        /*********************************************************************************
+         * Send
+         ********************************************************************************/
+        virtual int32_t send(const block_t *b, int32_t size) override;
+
+        /*********************************************************************************
+         * Send io buffer
+         * The ownership of io buffer will be transferred.
+         ********************************************************************************/
+        virtual int32_t send(toolkit::io_buffer_ptr iob) override;
+
+        /*********************************************************************************
+         * Get smoothed round trip time in milliseconds
+         ********************************************************************************/
+        PUMP_INLINE int32_t get_srtt() const {
+            return srtt_;
+        }
+
+      protected:
+        /*********************************************************************************
+         * Channel event callback
+         ********************************************************************************/
+        virtual void on_channel_event(int32_t ev) override;
+
+        /*********************************************************************************
+         * Datagram transport callbacks
+         ********************************************************************************/
+        static void on_datagram(rudp_transport_wptr wptr, const block_t *b, int32_t size);
+        static void on_datagram_disconnected(rudp_transport_wptr wptr);
+        static void on_datagram_stopped(rudp_transport_wptr wptr);
+
+        /*********************************************************************************
+         * Update timer callback
+         ********************************************************************************/
+        static void on_update(rudp_transport_wptr wptr);
+
+      private:
+        /*********************************************************************************
+         * Segment
+         * Segment data is stored right behind the header in the same memory block.
+         ********************************************************************************/
+        struct segment {
+            // Sequence number
+            uint32_t sn;
+            // Send timestamp
+            uint32_t ts;
+            // Retransmit timestamp
+            uint32_t resendts;
+            // Retransmit timeout
+            uint32_t rto;
+            // Skipped ack count
+            int32_t fastack;
+            // Transmit count
+            int32_t xmit;
+            // Data size
+            int32_t len;
+
+            PUMP_INLINE block_t* data() {
+                return (block_t*)(this + 1);
+            }
+        };
+
+      private:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        rudp_transport(base_transport_sptr &datagram_transport,
+                       const rudp_options &opts) noexcept;
+
+        /*********************************************************************************
+         * Close transport flow
+         ********************************************************************************/
+        virtual void __close_transport_flow() override;
+
+        /*********************************************************************************
+         * Handle input datagram
+         * Mutex should be locked.
+         ********************************************************************************/
+        bool __input(const block_t *b, int32_t size, uint32_t now);
+
+        /*********************************************************************************
+         * Flush acks, window probes and segments
+         * Mutex should be locked.
+         ********************************************************************************/
+        bool __flush(uint32_t now);
+
+        /*********************************************************************************
+         * Write segment header to output buffer, flush the buffer if full
+         * Mutex should be locked.
+         ********************************************************************************/
+        void __output_segment(uint8_t cmd, 
+                              uint32_t sn, 
+                              uint32_t ts,
+                              const block_t *data, 
+                              int32_t len);
+        void __output_flush();
+
+        /*********************************************************************************
+         * Update rtt and rto
+         * Mutex should be locked.
+         ********************************************************************************/
+        void __update_rtt(int32_t rtt);
+
+        /*********************************************************************************
+         * Get receive window unused
+         * Mutex should be locked.
+         ********************************************************************************/
+        PUMP_INLINE int32_t __recv_window_unused() const {
+            int32_t used = (int32_t)rcv_queue_.size();
+            return used < opts_.recv_window ? opts_.recv_window - used : 0;
+        }
+
+        /*********************************************************************************
+         * Deliver received data to read callback
+         ********************************************************************************/
+        void __deliver();
+
+        /*********************************************************************************
+         * Try doing disconnected process
+         ********************************************************************************/
+        void __try_doing_disconnected_process();
+
+        /*********************************************************************************
+         * Create and destroy segment
+         ********************************************************************************/
+        segment* __create_segment(const block_t *b, int32_t size);
+        void __destroy_segment(segment *seg);
+
+        /*********************************************************************************
+         * Clear all segments
+         ********************************************************************************/
+        void __clear_segments();
+
+      private:
+        // Rudp options
+        rudp_options opts_;
+        // Max segment data size
+        int32_t mss_;
+
+        // Datagram transport
+        base_transport_sptr datagram_transport_;
+        // Update timer
+        time::timer_sptr update_timer_;
+
+        // State mutex
+        std::mutex mx_;
+        // Deliver mutex, it keeps read callbacks in order
+        std::mutex deliver_mx_;
+
+        // Segments can be sent in current update interval, it is reset by update timer
+        int32_t pacing_budget_;
+
+        // Send state
+        uint32_t snd_una_;
+        uint32_t snd_nxt_;
+        int32_t rmt_wnd_;
+        std::deque<segment*> snd_queue_;
+        std::deque<segment*> snd_buf_;
+
+        // Receive state
+        uint32_t rcv_nxt_;
+        std::map<uint32_t, segment*> rcv_buf_;
+        std::deque<segment*> rcv_queue_;
+
+        // Pending acks, pairs of sequence number and timestamp
+        std::vector<std::pair<uint32_t, uint32_t>> acks_;
+
+        // Window probe state
+        bool ask_wnd_;
+        bool tell_wnd_;
+        uint32_t probe_ts_;
+
+        // Rtt state
+        int32_t srtt_;
+        int32_t rttval_;
+        int32_t rto_;
+
+        // Output buffer
+        int32_t output_size_;
+        block_t *output_;
+    };
+
+}  // namespace transport
+}  // namespace pump
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "pump/transport/flow/flow_tcp.h"
 #include "pump/transport/base_transport.h"
+#include "pump/toolkit/freelock_lazy_queue.h"
 #include "pump/toolkit/freelock_multi_queue.h"
 
 namespace pump {
@@ -27,10 +28,13 @@ namespace transport {
     class tcp_transport;
     DEFINE_ALL_POINTER_TYPE(tcp_transport);
 
-    class LIB_PUMP tcp_transport
+    class LIB_PUMP tcp_transport final
       : public base_transport {
 
       public:
+        // Objects are allocated from object pool
+        PUMP_ENABLE_OBJECT_POOL(tcp_transport);
+
         /*********************************************************************************
          * Create instance
          ********************************************************************************/
@@ -112,18 +116,14 @@ namespace transport {
          * Shutdown transport flow
          ********************************************************************************/
         PUMP_INLINE void __shutdown_transport_flow() {
-            if (flow_) {
-                flow_->shutdown();
-            }
+            flow_.shutdown();
         }
 
         /*********************************************************************************
          * Close transport flow
          ********************************************************************************/
         virtual void __close_transport_flow() override {
-            if (flow_) {
-                flow_->close();
-            }
+            flow_.close();
         }
 
         /*********************************************************************************
@@ -161,7 +161,8 @@ namespace transport {
 
       private:
         // Transport flow
-        flow::flow_tcp_sptr flow_;
+        // Flow is embedded, so read and send paths reach it without pointer chasing.
+        flow::flow_tcp flow_;
 
         // Last send buffer
         volatile int32_t last_send_iob_size_;
@@ -170,8 +171,10 @@ namespace transport {
         // Pending send count
         std::atomic_int32_t pending_send_cnt_;
 
-        // Send buffer list
-        toolkit::freelock_multi_queue<toolkit::io_buffer_ptr, 8> sendlist_;
+        // Send buffer list, it is created at first sending, so idle transports
+        // keep no send buffer list.
+        toolkit::freelock_lazy_queue<
+            toolkit::freelock_multi_queue<toolkit::io_buffer_ptr, 8>> sendlist_;
     };
 
 }  // namespace transport
@@ -74,6 +74,32 @@ namespace transport {
          ********************************************************************************/
         virtual ~tls_acceptor();
 
+        /*********************************************************************************
+         * Set session cache
+         * Clients can resume sessions stored in the cache. It must be set before start.
+         ********************************************************************************/
+        PUMP_INLINE bool set_session_cache(ssl::tls_session_cache_sptr cache) {
+            return ssl::set_tls_session_cache(xcred_, cache);
+        }
+
+        /*********************************************************************************
+         * Enable session ticket
+         * Ticket keys are rotated every interval milliseconds. It must be set before
+         * start.
+         ********************************************************************************/
+        PUMP_INLINE bool enable_session_ticket(int64_t key_rotate_interval) {
+            return ssl::enable_tls_session_ticket(xcred_, key_rotate_interval);
+        }
+
+        /*********************************************************************************
+         * Enable memory io
+         * TLS flows of accepted transports do all socket io instead of tls library.
+         * It must be set before start.
+         ********************************************************************************/
+        PUMP_INLINE void enable_memory_io() {
+            memory_io_ = true;
+        }
+
         /*********************************************************************************
          * Start
          ********************************************************************************/
@@ -146,6 +172,9 @@ namespace transport {
         // Handshake timeout
         int64_t handshake_timeout_;
 
+        // Memory io
+        bool memory_io_;
+
         // Handshakers
         std::mutex handshaker_mx_;
         std::unordered_map<tls_handshaker_ptr, tls_handshaker_sptr> handshakers_;
@@ -66,6 +66,27 @@ namespace transport {
          ********************************************************************************/
         virtual ~tls_dialer();
 
+        /*********************************************************************************
+         * Set session cache
+         * Session resumption is disabled if no cache is set. Dialer resumes the cached
+         * session keyed by credentials, server name and remote address, so sessions
+         * are never shared between different credentials or servers.
+         ********************************************************************************/
+        PUMP_INLINE void set_session_cache(ssl::tls_session_cache_sptr cache,
+                                           const std::string &server_name = "") {
+            session_cache_ = cache;
+            server_name_ = server_name;
+        }
+
+        /*********************************************************************************
+         * Enable memory io
+         * TLS flow of dialed transport does all socket io instead of tls library. It
+         * must be set before start.
+         ********************************************************************************/
+        PUMP_INLINE void enable_memory_io() {
+            memory_io_ = true;
+        }
+
         /*********************************************************************************
          * Start
          ********************************************************************************/
@@ -114,6 +135,12 @@ namespace transport {
                 flow_->close();
         }
 
+      private:
+        /*********************************************************************************
+         * Get session cache key
+         ********************************************************************************/
+        std::string __get_session_key(const address &remote_address) const;
+
       private:
         /*********************************************************************************
          * Constructor
@@ -131,8 +158,15 @@ namespace transport {
         // Credentials owner
         bool xcred_owner_;
 
+        // Session cache
+        ssl::tls_session_cache_sptr session_cache_;
+        // Server name of session cache key
+        std::string server_name_;
+
         // Handshake timeout
         int64_t handshake_timeout_;
+        // Memory io
+        bool memory_io_;
         // Handshaker
         tls_handshaker_sptr handshaker_;
 
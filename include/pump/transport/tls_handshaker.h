@@ -52,12 +52,14 @@ namespace transport {
 
         /*********************************************************************************
          * Init
+         * With memory io, tls flow does all socket io instead of tls library.
          ********************************************************************************/
         void init(pump_socket fd,
                   bool client,
                   void_ptr xcred,
                   const address &local_address,
-                  const address &remote_address);
+                  const address &remote_address,
+                  bool memory_io = false);
 
         /*********************************************************************************
          * Start tls handshaker
@@ -69,6 +71,17 @@ namespace transport {
          ********************************************************************************/
         void stop();
 
+        /*********************************************************************************
+         * Set session cache
+         * Client handshaker resumes the cached session of the key.
+         ********************************************************************************/
+        PUMP_INLINE void set_session_cache(ssl::tls_session_cache_sptr &cache,
+                                           const std::string &key) {
+            if (flow_) {
+                flow_->set_session_cache(cache, key);
+            }
+        }
+
         /*********************************************************************************
          * Unlock flow
          ********************************************************************************/
@@ -101,30 +114,52 @@ namespace transport {
          ********************************************************************************/
         virtual void on_send_event() override;
 
+        /*********************************************************************************
+         * Channel event callback
+         * Crypto worker posts handshake step result to the poller as channel event.
+         ********************************************************************************/
+        virtual void on_channel_event(int32_t ev) override;
+
         /*********************************************************************************
          * Timer timeout callback
          ********************************************************************************/
         static void on_timeout(tls_handshaker_wptr wptr);
 
+        /*********************************************************************************
+         * Handshake task callback
+         ********************************************************************************/
+        static void on_handshake_task(tls_handshaker_wptr wptr);
+
       private:
         /*********************************************************************************
          * Open flow
          ********************************************************************************/
-        bool __open_flow(pump_socket fd, void_ptr xcred, bool client);
+        bool __open_flow(pump_socket fd, void_ptr xcred, bool client, bool memory_io);
 
         /*********************************************************************************
          * Close flow
          ********************************************************************************/
         PUMP_INLINE void __close_flow() {
-            if (flow_) {
+            if (flow_ && !flag_.test_and_set()) {
                 flow_->close();
             }
         }
 
         /*********************************************************************************
-         * Process handshake
+         * Handshake step
+         * It runs handshake step on the poller, or posts it to crypto workers.
+         ********************************************************************************/
+        void __handshake_step();
+
+        /*********************************************************************************
+         * Process handshake step result
          ********************************************************************************/
-        void __process_handshake();
+        void __process_handshake(int32_t ret);
+
+        /*********************************************************************************
+         * Post handshake task to crypto workers
+         ********************************************************************************/
+        bool __post_handshake_task();
 
         /*********************************************************************************
          * Start handshake timer
@@ -157,9 +192,12 @@ namespace transport {
         // Remote address
         address remote_address_;
 
-        // Finished flag
+        // Flow closed flag
         std::atomic_flag flag_;
 
+        // Handshake step is running on crypto worker
+        std::atomic<bool> handshaking_;
+
         // Handshake timeout timer
         time::timer_sptr timer_;
 
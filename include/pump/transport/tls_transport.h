@@ -19,6 +19,7 @@
 
 #include "pump/transport/flow/flow_tls.h"
 #include "pump/transport/base_transport.h"
+#include "pump/toolkit/freelock_lazy_queue.h"
 #include "pump/toolkit/freelock_multi_queue.h"
 
 namespace pump {
@@ -27,10 +28,13 @@ namespace transport {
     class tls_transport;
     DEFINE_ALL_POINTER_TYPE(tls_transport);
 
-    class LIB_PUMP tls_transport
+    class LIB_PUMP tls_transport final
       : public base_transport {
 
       public:
+        // Objects are allocated from object pool
+        PUMP_ENABLE_OBJECT_POOL(tls_transport);
+
         /*********************************************************************************
          * Create instance
          ********************************************************************************/
@@ -88,6 +92,13 @@ namespace transport {
          ********************************************************************************/
         virtual int32_t send(toolkit::io_buffer_ptr iob) override;
 
+        /*********************************************************************************
+         * Check session resumed or not
+         ********************************************************************************/
+        PUMP_INLINE bool is_session_resumed() const {
+            return flow_ && flow_->is_session_resumed();
+        }
+
       protected:
         /*********************************************************************************
          * Channel event callback
@@ -143,6 +154,22 @@ namespace transport {
          ********************************************************************************/
         int32_t __send_once(flow::flow_tls_ptr flow);
 
+        /*********************************************************************************
+         * Coalesce send buffers
+         * Small buffers in sendlist are copied into the record buffer, so they can be
+         * sent in one record.
+         ********************************************************************************/
+        bool __coalesce_send_buffers(int32_t record_size);
+
+        /*********************************************************************************
+         * Pop coalescing buffer
+         * Buffer popped but not fitting the space or counted size is kept as next send
+         * buffer, and false is returned.
+         ********************************************************************************/
+        bool __pop_coalescing_buffer(int32_t space, 
+                                     int32_t counted_size,
+                                     toolkit::io_buffer_ptr &iob);
+
         /*********************************************************************************
          * Try doing transport dissconnected process
          ********************************************************************************/
@@ -169,11 +196,19 @@ namespace transport {
         volatile int32_t last_send_iob_size_;
         volatile toolkit::io_buffer_ptr last_send_iob_;
 
+        // Next send buffer popped but not coalesced
+        toolkit::io_buffer_ptr next_send_iob_;
+
+        // Record buffer for coalescing
+        toolkit::io_buffer_ptr record_iob_;
+
         // Pending send count
         std::atomic_int32_t pending_send_cnt_;
 
-        // Send buffer list
-        toolkit::freelock_multi_queue<toolkit::io_buffer_ptr, 8> sendlist_;
+        // Send buffer list, it is created at first sending, so idle transports
+        // keep no send buffer list.
+        toolkit::freelock_lazy_queue<
+            toolkit::freelock_multi_queue<toolkit::io_buffer_ptr, 8>> sendlist_;
     };
 
 }  // namespace transport
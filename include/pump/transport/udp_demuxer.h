@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_transport_udp_demuxer_h
+#define pump_transport_udp_demuxer_h
+
+#include <mutex>
+#include <unordered_map>
+
+#include "pump/time/timer.h"
+#include "pump/transport/udp_session.h"
+
+namespace pump {
+namespace transport {
+
+    #define UDP_DEMUXER_MAX_SESSIONS 65536
+
+    /*********************************************************************************
+     * Udp demuxer
+     * Udp demuxer binds an udp transport and demultiplexes received datagrams to udp
+     * sessions by remote address. A session is created and passed to accepted
+     * callback when a datagram from a new peer arrives, and is disconnected when it
+     * has no activity for idle timeout.
+     ********************************************************************************/
+    class LIB_PUMP udp_demuxer
+      : public std::enable_shared_from_this<udp_demuxer> {
+
+      protected:
+        friend class udp_session;
+
+      public:
+        /*********************************************************************************
+         * Create instance
+         * If idle timeout is zero, sessions never time out. Max send queue length is
+         * passed to the shared udp transport. Datagrams from new peers are dropped
+         * when there are max sessions already.
+         ********************************************************************************/
+        PUMP_INLINE static udp_demuxer_sptr create(
+            const address &bind_address,
+            int64_t idle_timeout = 0,
+            int32_t max_send_queue_len = 0,
+            int32_t max_sessions = UDP_DEMUXER_MAX_SESSIONS) {
+            INLINE_OBJECT_CREATE(
+                obj, 
+                udp_demuxer, 
+                (bind_address, idle_timeout, max_send_queue_len, max_sessions));
+            return udp_demuxer_sptr(obj, object_delete<udp_demuxer>);
+        }
+
+        /*********************************************************************************
+         * Deconstructor
+         ********************************************************************************/
+        ~udp_demuxer();
+
+        /*********************************************************************************
+         * Start
+         * Accepted callback is triggered with a new udp session when a datagram from a
+         * new peer arrives. The session should be started in the accepted callback,
+         * or the session will be removed and the datagram will be dropped.
+         ********************************************************************************/
+        int32_t start(service_ptr sv, const acceptor_callbacks &cbs);
+
+        /*********************************************************************************
+         * Stop
+         * All sessions will be disconnected.
+         ********************************************************************************/
+        void stop();
+
+        /*********************************************************************************
+         * Open session
+         * Return the session of the remote address, create it if not existed.
+         ********************************************************************************/
+        udp_session_sptr open_session(const address &remote_address);
+
+        /*********************************************************************************
+         * Get session count
+         ********************************************************************************/
+        int32_t get_session_count();
+
+        /*********************************************************************************
+         * Get bind address
+         ********************************************************************************/
+        PUMP_INLINE const address& get_bind_address() const {
+            return bind_address_;
+        }
+
+      protected:
+        /*********************************************************************************
+         * Read from callback
+         ********************************************************************************/
+        static void on_read_from(udp_demuxer_wptr wptr,
+                                 const block_t *b,
+                                 int32_t size,
+                                 const address &from_address);
+
+        /*********************************************************************************
+         * Transport stopped callback
+         ********************************************************************************/
+        static void on_stopped(udp_demuxer_wptr wptr);
+
+        /*********************************************************************************
+         * Idle timeout callback
+         ********************************************************************************/
+        static void on_idle_timeout(udp_demuxer_wptr wptr);
+
+      private:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        udp_demuxer(const address &bind_address,
+                    int64_t idle_timeout,
+                    int32_t max_send_queue_len,
+                    int32_t max_sessions) noexcept;
+
+        /*********************************************************************************
+         * Create session
+         * Session mutex should be locked.
+         ********************************************************************************/
+        udp_session_sptr __create_session(const address &remote_address);
+
+        /*********************************************************************************
+         * Remove session
+         ********************************************************************************/
+        void __remove_session(udp_session_ptr session);
+
+        /*********************************************************************************
+         * Disconnect all sessions
+         ********************************************************************************/
+        void __disconnect_all_sessions();
+
+      private:
+        // Service
+        service_ptr sv_;
+        // Demuxer state
+        std::atomic_int32_t state_;
+        // Bind address
+        address bind_address_;
+        // Session idle timeout
+        int64_t idle_timeout_;
+        // Max send queue length of udp transport
+        int32_t max_send_queue_len_;
+        // Max session count
+        int32_t max_sessions_;
+        // Udp transport
+        udp_transport_sptr transport_;
+        // Idle timer
+        time::timer_sptr idle_timer_;
+        // Sessions
+        std::mutex session_mx_;
+        std::unordered_map<address, udp_session_sptr> sessions_;
+        // Demuxer callbacks
+        acceptor_callbacks cbs_;
+    };
+
+}  // namespace transport
+}  // namespace pump
+
+#endif
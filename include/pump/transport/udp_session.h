@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_transport_udp_session_h
+#define pump_transport_udp_session_h
+
+#include "pump/time/timestamp.h"
+#include "pump/transport/udp_transport.h"
+
+namespace pump {
+namespace transport {
+
+    class udp_demuxer;
+    DEFINE_ALL_POINTER_TYPE(udp_demuxer);
+
+    class udp_session;
+    DEFINE_ALL_POINTER_TYPE(udp_session);
+
+    /*********************************************************************************
+     * Udp session
+     * Udp session is a virtual transport of one remote peer, it has no socket of its
+     * own. Datagrams are received and demultiplexed by udp demuxer, and sent by the
+     * udp transport shared by all sessions of the demuxer.
+     ********************************************************************************/
+    class LIB_PUMP udp_session
+      : public base_transport {
+
+      protected:
+        friend class udp_demuxer;
+
+      public:
+        /*********************************************************************************
+         * Deconstructor
+         ********************************************************************************/
+        virtual ~udp_session() = default;
+
+        /*********************************************************************************
+         * Start
+         ********************************************************************************/
+        virtual int32_t start(service_ptr sv, const transport_callbacks &cbs) override;
+
+        /*********************************************************************************
+         * Stop
+         ********************************************************************************/
+        virtual void stop() override;
+
+        /*********************************************************************************
+         * Force stop
+         ********************************************************************************/
+        virtual void force_stop() override {
+            stop();
+        }
+
+        /*********************************************************************************
+         * Read for once
+         ********************************************************************************/
+        virtual int32_t read_for_once() override;
+
+        /*********************************************************************************
+         * Read for loop
+         ********************************************************************************/
+        virtual int32_t read_for_loop() override;
+
+        /*********************************************************************************
+         * Send
+         ********************************************************************************/
+        virtual int32_t send(const block_t *b, int32_t size) override;
+
+        /*********************************************************************************
+         * Send io buffer
+         * The ownership of io buffer will be transferred.
+         ********************************************************************************/
+        virtual int32_t send(toolkit::io_buffer_ptr iob) override;
+
+        /*********************************************************************************
+         * Get last active time in milliseconds
+         ********************************************************************************/
+        PUMP_INLINE uint64_t get_last_active_time() const {
+            return last_active_time_.load(std::memory_order_relaxed);
+        }
+
+      protected:
+        /*********************************************************************************
+         * Handle datagram from demuxer
+         ********************************************************************************/
+        void __handle_datagram(const block_t *b, int32_t size);
+
+        /*********************************************************************************
+         * Disconnect session
+         ********************************************************************************/
+        void __disconnect();
+
+      private:
+        /*********************************************************************************
+         * Constructor
+         ********************************************************************************/
+        udp_session(udp_demuxer_wptr &&demuxer,
+                    udp_transport_sptr &transport,
+                    const address &remote_address) noexcept;
+
+        /*********************************************************************************
+         * Close transport flow
+         * Udp session has no flow of its own.
+         ********************************************************************************/
+        virtual void __close_transport_flow() override {
+        }
+
+        /*********************************************************************************
+         * Update last active time
+         ********************************************************************************/
+        PUMP_INLINE void __update_active_time() {
+            last_active_time_.store(time::get_cached_clock_milliseconds(),
+                                    std::memory_order_relaxed);
+        }
+
+      private:
+        // Udp demuxer
+        udp_demuxer_wptr demuxer_;
+        // Shared udp transport
+        udp_transport_sptr transport_;
+        // Last active time
+        std::atomic<uint64_t> last_active_time_;
+    };
+
+}  // namespace transport
+}  // namespace pump
+
+#endif
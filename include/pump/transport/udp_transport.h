@@ -19,22 +19,38 @@
 
 #include "pump/transport/flow/flow_udp.h"
 #include "pump/transport/base_transport.h"
+#include "pump/toolkit/freelock_multi_queue.h"
 
 namespace pump {
 namespace transport {
 
+    /*********************************************************************************
+     * Udp send queue drop policy
+     * When the send queue is full, UDP_DROP_NEWEST rejects the datagram being sent
+     * and UDP_DROP_OLDEST discards the oldest queued datagram instead.
+     ********************************************************************************/
+    const int32_t UDP_DROP_NEWEST = 0;
+    const int32_t UDP_DROP_OLDEST = 1;
+
     class udp_transport;
     DEFINE_ALL_POINTER_TYPE(udp_transport);
 
-    class LIB_PUMP udp_transport
+    class LIB_PUMP udp_transport final
       : public base_transport {
 
       public:
         /*********************************************************************************
          * Create instance
+         * If max_send_queue_len is greater than zero, datagrams will be queued and sent
+         * by send poller in batch when socket is not writable, otherwise sending is
+         * synchronous and returns ERROR_AGAIN when socket is not writable.
          ********************************************************************************/
-        PUMP_INLINE static udp_transport_sptr create(const address &bind_address) {
-            INLINE_OBJECT_CREATE(obj, udp_transport, (bind_address));
+        PUMP_INLINE static udp_transport_sptr create(
+            const address &bind_address,
+            int32_t max_send_queue_len = 0,
+            int32_t drop_policy = UDP_DROP_NEWEST) {
+            INLINE_OBJECT_CREATE(
+                obj, udp_transport, (bind_address, max_send_queue_len, drop_policy));
             return udp_transport_sptr(obj, object_delete<udp_transport>);
         }
 
@@ -78,17 +94,48 @@ namespace transport {
                              int32_t size,
                              const address &address) override;
 
+        /*********************************************************************************
+         * Get dropped datagram count of send queue
+         ********************************************************************************/
+        PUMP_INLINE int32_t get_dropped_count() const {
+            return dropped_cnt_.load(std::memory_order_relaxed);
+        }
+
       protected:
         /*********************************************************************************
          * Read event callback
          ********************************************************************************/
         virtual void on_read_event() override;
 
+        /*********************************************************************************
+         * Send event callback
+         ********************************************************************************/
+        virtual void on_send_event() override;
+
+      private:
+        /*********************************************************************************
+         * Queued datagram
+         * Datagram data is stored right behind the header in the same memory block.
+         ********************************************************************************/
+        struct datagram {
+            // Datagram destination address
+            address to;
+            // Datagram data size
+            int32_t size;
+
+            PUMP_INLINE block_t* data() {
+                return (block_t*)(this + 1);
+            }
+        };
+
       private:
         /*********************************************************************************
          * Constructor
          ********************************************************************************/
-        udp_transport(const address &bind_address) noexcept;
+        udp_transport(
+            const address &bind_address,
+            int32_t max_send_queue_len,
+            int32_t drop_policy) noexcept;
 
         /*********************************************************************************
          * Open transport flow
@@ -118,9 +165,49 @@ namespace transport {
          ********************************************************************************/
         int32_t __async_read(int32_t state);
 
+        /*********************************************************************************
+         * Async send
+         ********************************************************************************/
+        int32_t __async_send(const block_t *b, int32_t size, const address &address);
+
+        /*********************************************************************************
+         * Send queued datagrams in batch
+         ********************************************************************************/
+        int32_t __send_queued();
+
+        /*********************************************************************************
+         * Create and destroy datagram
+         ********************************************************************************/
+        datagram* __create_datagram(const block_t *b, int32_t size, const address &address);
+        void __destroy_datagram(datagram *dg);
+
+        /*********************************************************************************
+         * Clear send queue
+         ********************************************************************************/
+        void __clear_sendlist();
+
       private:
         // Udp flow
         flow::flow_udp_sptr flow_;
+
+        // Max send queue length
+        int32_t max_send_queue_len_;
+        // Send queue drop policy
+        int32_t drop_policy_;
+        // Dropped datagram count
+        std::atomic_int32_t dropped_cnt_;
+        // Queued datagram count, including datagrams in sending batch
+        std::atomic_int32_t send_queue_len_;
+        // Datagrams dropped as oldest but still counted in send queue length, the
+        // sending owner uncounts them
+        std::atomic_int32_t uncounted_drop_cnt_;
+        // Send queue, only created when max send queue length is greater than zero
+        toolkit::freelock_multi_queue<datagram*, 8> *sendlist_;
+
+        // Sending batch, only accessed by the sending owner
+        int32_t send_batch_pos_;
+        int32_t send_batch_cnt_;
+        datagram *send_batch_[MAX_UDP_SEND_BATCH];
     };
 
 }  // namespace transport
@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "pump/types.h"
+#include "pump/memory.h"
+
+namespace pump {
+
+    // Memory tag names
+    static const char *memory_tag_names[MEMORY_TAG_COUNT] = {
+        "other",
+        "poller",
+        "transport",
+        "tls",
+        "http",
+        "websocket",
+        "timer"
+    };
+
+    const char* get_memory_tag_name(memory_tag tag) {
+        if (tag < 0 || tag >= MEMORY_TAG_COUNT) {
+            return "unknown";
+        }
+        return memory_tag_names[tag];
+    }
+
+#if defined(PUMP_HAVE_MEMORY_ACCOUNTING)
+
+#if defined(PUMP_HAVE_JEMALLOC)
+#define raw_free je_free
+#define raw_malloc je_malloc
+#define raw_realloc je_realloc
+#else
+#define raw_free free
+#define raw_malloc malloc
+#define raw_realloc realloc
+#endif
+
+    // Allocation header size, it keeps alignment of malloc.
+    const static size_t MEMORY_HEADER_SIZE = 16;
+
+    /*********************************************************************************
+     * Memory counters of a thread
+     * Counters are only written by the owner thread, so they are updated without
+     * atomic read-modify-write, and read by other threads when collecting statistics.
+     ********************************************************************************/
+    struct thread_memory_counters {
+        std::atomic<uint64_t> alloc_count[MEMORY_TAG_COUNT];
+        std::atomic<uint64_t> free_count[MEMORY_TAG_COUNT];
+        std::atomic<uint64_t> alloc_bytes[MEMORY_TAG_COUNT];
+        std::atomic<uint64_t> free_bytes[MEMORY_TAG_COUNT];
+        thread_memory_counters *prev;
+        thread_memory_counters *next;
+    };
+
+    /*********************************************************************************
+     * Memory counters registry
+     * Counters of exited threads are merged into retired stats.
+     ********************************************************************************/
+    struct memory_registry {
+        std::mutex mx;
+        thread_memory_counters *head;
+        memory_stats retired[MEMORY_TAG_COUNT];
+    };
+
+    // Memory tag of current thread
+    static thread_local memory_tag current_memory_tag = MEMORY_TAG_OTHER;
+
+    // Memory counters of current thread
+    static thread_local thread_memory_counters *current_counters = nullptr;
+
+    // Current thread has exited and retired its counters
+    static thread_local bool current_counters_retired = false;
+
+    /*********************************************************************************
+     * Get registry
+     * Registry is never destructed, so threads exiting late can still use it.
+     ********************************************************************************/
+    static memory_registry& __registry() {
+        static memory_registry *registry = []() {
+            memory_registry *r = (memory_registry*)raw_malloc(sizeof(memory_registry));
+            new (&r->mx) std::mutex;
+            r->head = nullptr;
+            memset(r->retired, 0, sizeof(r->retired));
+            return r;
+        }();
+        return *registry;
+    }
+
+    /*********************************************************************************
+     * Retire counters of current thread at exiting
+     ********************************************************************************/
+    struct memory_counters_retirer {
+        ~memory_counters_retirer() {
+            thread_memory_counters *c = counters;
+            if (c == nullptr) {
+                return;
+            }
+            memory_registry &registry = __registry();
+            {
+                std::lock_guard<std::mutex> lock(registry.mx);
+                for (int32_t i = 0; i < MEMORY_TAG_COUNT; i++) {
+                    memory_stats &stats = registry.retired[i];
+                    stats.alloc_count += c->alloc_count[i].load(std::memory_order_relaxed);
+                    stats.free_count += c->free_count[i].load(std::memory_order_relaxed);
+                    stats.alloc_bytes += c->alloc_bytes[i].load(std::memory_order_relaxed);
+                    stats.free_bytes += c->free_bytes[i].load(std::memory_order_relaxed);
+                }
+                if (c->prev) {
+                    c->prev->next = c->next;
+                } else {
+                    registry.head = c->next;
+                }
+                if (c->next) {
+                    c->next->prev = c->prev;
+                }
+            }
+            current_counters = nullptr;
+            current_counters_retired = true;
+            raw_free(c);
+        }
+        thread_memory_counters *counters;
+    };
+
+    static thread_local memory_counters_retirer counters_retirer;
+
+    /*********************************************************************************
+     * Get counters of current thread
+     * Return nullptr after current thread has retired its counters.
+     ********************************************************************************/
+    static thread_memory_counters* __current_counters() {
+        if (PUMP_LIKELY(current_counters != nullptr)) {
+            return current_counters;
+        }
+        if (current_counters_retired) {
+            return nullptr;
+        }
+
+        thread_memory_counters *c =
+            (thread_memory_counters*)raw_malloc(sizeof(thread_memory_counters));
+        if (c == nullptr) {
+            return nullptr;
+        }
+        for (int32_t i = 0; i < MEMORY_TAG_COUNT; i++) {
+            new (&c->alloc_count[i]) std::atomic<uint64_t>(0);
+            new (&c->free_count[i]) std::atomic<uint64_t>(0);
+            new (&c->alloc_bytes[i]) std::atomic<uint64_t>(0);
+            new (&c->free_bytes[i]) std::atomic<uint64_t>(0);
+        }
+        c->prev = nullptr;
+
+        memory_registry &registry = __registry();
+        {
+            std::lock_guard<std::mutex> lock(registry.mx);
+            c->next = registry.head;
+            if (registry.head) {
+                registry.head->prev = c;
+            }
+            registry.head = c;
+        }
+
+        // Retirer is constructed at first using, then it is destructed when current
+        // thread exits.
+        counters_retirer.counters = c;
+        current_counters = c;
+
+        return c;
+    }
+
+    PUMP_INLINE static void __increase(std::atomic<uint64_t> &counter, uint64_t val) {
+        counter.store(counter.load(std::memory_order_relaxed) + val, std::memory_order_relaxed);
+    }
+
+    /*********************************************************************************
+     * Count allocating and freeing
+     ********************************************************************************/
+    static void __count(memory_tag tag, uint64_t alloc_size, uint64_t free_size) {
+        thread_memory_counters *c = __current_counters();
+        if (PUMP_LIKELY(c != nullptr)) {
+            if (alloc_size > 0) {
+                __increase(c->alloc_count[tag], 1);
+                __increase(c->alloc_bytes[tag], alloc_size);
+            }
+            if (free_size > 0) {
+                __increase(c->free_count[tag], 1);
+                __increase(c->free_bytes[tag], free_size);
+            }
+            return;
+        }
+
+        // Current thread is exiting, so count to retired stats.
+        memory_registry &registry = __registry();
+        std::lock_guard<std::mutex> lock(registry.mx);
+        memory_stats &stats = registry.retired[tag];
+        if (alloc_size > 0) {
+            stats.alloc_count++;
+            stats.alloc_bytes += alloc_size;
+        }
+        if (free_size > 0) {
+            stats.free_count++;
+            stats.free_bytes += free_size;
+        }
+    }
+
+    memory_tag set_memory_tag(memory_tag tag) {
+        memory_tag prev = current_memory_tag;
+        current_memory_tag = tag;
+        return prev;
+    }
+
+    void* accounted_malloc(size_t size) {
+        uint64_t *header = (uint64_t*)raw_malloc(size + MEMORY_HEADER_SIZE);
+        if (PUMP_UNLIKELY(header == nullptr)) {
+            return nullptr;
+        }
+        memory_tag tag = current_memory_tag;
+        header[0] = size;
+        header[1] = tag;
+        __count(tag, size + MEMORY_HEADER_SIZE, 0);
+        return (block_t*)header + MEMORY_HEADER_SIZE;
+    }
+
+    void* accounted_realloc(void *p, size_t size) {
+        if (p == nullptr) {
+            return accounted_malloc(size);
+        }
+
+        uint64_t *header = (uint64_t*)((block_t*)p - MEMORY_HEADER_SIZE);
+        uint64_t old_size = header[0];
+        memory_tag tag = (memory_tag)header[1];
+
+        header = (uint64_t*)raw_realloc(header, size + MEMORY_HEADER_SIZE);
+        if (PUMP_UNLIKELY(header == nullptr)) {
+            return nullptr;
+        }
+        header[0] = size;
+        // Reallocated memory keeps its tag.
+        __count(tag, size + MEMORY_HEADER_SIZE, old_size + MEMORY_HEADER_SIZE);
+        return (block_t*)header + MEMORY_HEADER_SIZE;
+    }
+
+    void accounted_free(void *p) {
+        if (p == nullptr) {
+            return;
+        }
+        uint64_t *header = (uint64_t*)((block_t*)p - MEMORY_HEADER_SIZE);
+        __count((memory_tag)header[1], 0, header[0] + MEMORY_HEADER_SIZE);
+        raw_free(header);
+    }
+
+    bool get_memory_stats(memory_tag tag, memory_stats &stats) {
+        if (tag < 0 || tag >= MEMORY_TAG_COUNT) {
+            return false;
+        }
+
+        memory_registry &registry = __registry();
+        std::lock_guard<std::mutex> lock(registry.mx);
+        stats = registry.retired[tag];
+        for (auto c = registry.head; c != nullptr; c = c->next) {
+            stats.alloc_count += c->alloc_count[tag].load(std::memory_order_relaxed);
+            stats.free_count += c->free_count[tag].load(std::memory_order_relaxed);
+            stats.alloc_bytes += c->alloc_bytes[tag].load(std::memory_order_relaxed);
+            stats.free_bytes += c->free_bytes[tag].load(std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+#else
+
+    bool get_memory_stats(memory_tag tag, memory_stats &stats) {
+        memset(&stats, 0, sizeof(stats));
+        return false;
+    }
+
+#endif
+
+}  // namespace pump
@@ -18,6 +18,11 @@
 #include "pump/net/error.h"
 #include "pump/net/socket.h"
 
+#if defined(OS_LINUX)
+#include <sys/uio.h>
+#include <sys/socket.h>
+#endif
+
 namespace pump {
 namespace net {
 
@@ -275,6 +280,45 @@ namespace net {
         return size;
     }
 
+    int32_t send_to_batch(pump_socket fd, datagram *dgs, int32_t count) {
+#if defined(OS_LINUX)
+        struct iovec iovs[64];
+        struct mmsghdr msgs[64];
+        if (count > 64) {
+            count = 64;
+        }
+        for (int32_t i = 0; i < count; i++) {
+            iovs[i].iov_base = (void*)dgs[i].b;
+            iovs[i].iov_len = dgs[i].size;
+            memset(&msgs[i], 0, sizeof(struct mmsghdr));
+            msgs[i].msg_hdr.msg_name = dgs[i].addr;
+            msgs[i].msg_hdr.msg_namelen = dgs[i].addrlen;
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int32_t sent = ::sendmmsg(fd, msgs, count, 0);
+        if (sent < 0) {
+            int32_t ec = net::last_errno();
+            if (ec == LANE_EINPROGRESS || 
+                ec == LANE_EWOULDBLOCK) {
+                sent = -1;
+            } else {
+                sent = 0;
+            }
+        }
+        return sent;
+#else
+        int32_t sent = 0;
+        for (; sent < count; sent++) {
+            int32_t ret = send_to(fd, dgs[sent].b, dgs[sent].size, dgs[sent].addr, dgs[sent].addrlen);
+            if (ret <= 0) {
+                return sent > 0 ? sent : ret;
+            }
+        }
+        return sent;
+#endif
+    }
+
     void shutdown(pump_socket fd) {
         ::shutdown(fd, 0);
     }
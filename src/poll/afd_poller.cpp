@@ -239,6 +239,7 @@ namespace poll {
         }
 
         if (completion_count > 0) {
+            time::update_cached_clock_milliseconds();
             __dispatch_pending_event(completion_count);
         }
 #endif
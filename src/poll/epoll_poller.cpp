@@ -18,6 +18,7 @@
 
 #if defined(PUMP_HAVE_EPOLL)
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #endif
 
 namespace pump {
@@ -32,6 +33,7 @@ namespace poll {
 
     epoll_poller::epoll_poller() noexcept
       : fd_(-1), 
+        wakeup_fd_(-1),
         events_(nullptr),
         max_event_count_(1024),
         cur_event_count_(0) {
@@ -43,6 +45,20 @@ namespace poll {
         }
 
         events_ = pump_malloc(sizeof(struct epoll_event) * max_event_count_);
+
+        // Wakeup eventfd is level triggered, it is drained when dispatching.
+        wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeup_fd_ >= 0) {
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.ptr = &wakeup_fd_;
+            if (epoll_ctl(fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) != 0) {
+                PUMP_WARN_LOG(
+                    "epoll_poller: add wakeup eventfd failed %d", net::last_errno());
+                close(wakeup_fd_);
+                wakeup_fd_ = -1;
+            }
+        }
 #endif
     }
 
@@ -51,6 +67,9 @@ namespace poll {
         if (fd_ != -1) {
             close(fd_);
         }
+        if (wakeup_fd_ != -1) {
+            close(wakeup_fd_);
+        }
         if (events_) {
             pump_free(events_);
         }
@@ -134,16 +153,30 @@ namespace poll {
                                   max_event_count_, 
                                   timeout);
         if (count > 0) {
+            time::update_cached_clock_milliseconds();
             __dispatch_pending_event(count);
         }
 #endif
     }
 
+    void epoll_poller::__wakeup() {
+#if defined(PUMP_HAVE_EPOLL)
+        if (wakeup_fd_ != -1) {
+            eventfd_write(wakeup_fd_, 1);
+        }
+#endif
+    }
+
     void epoll_poller::__dispatch_pending_event(int32_t count) {
 #if defined(PUMP_HAVE_EPOLL)
         auto ev_beg = (epoll_event*)events_;
         auto ev_end = (epoll_event*)events_ + count;
         for (auto ev = ev_beg; ev != ev_end; ++ev) {
+            if (PUMP_UNLIKELY(ev->data.ptr == &wakeup_fd_)) {
+                eventfd_t val;
+                eventfd_read(wakeup_fd_, &val);
+                continue;
+            }
             // If channel is invalid, tracker should be removed.
             auto tracker = (channel_tracker_ptr)ev->data.ptr;
             if (tracker->untrack()) {
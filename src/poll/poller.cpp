@@ -19,12 +19,20 @@
 namespace pump {
 namespace poll {
 
+    const static int32_t POLLER_MAX_TIMEOUT = 3;
+
+    const static int32_t POLLER_CHANNEL_EVENT_RING_SIZE = 4096;
+    const static int32_t POLLER_CHANNEL_EVENT_BULK_SIZE = 64;
+
     poller::poller() noexcept
       : started_(false), 
         cev_cnt_(0), 
-        cevents_(1024), 
+        cevents_(POLLER_CHANNEL_EVENT_RING_SIZE),
+        overflow_cevents_(1024),
+        waiting_(false),
         tev_cnt_(0), 
-        tevents_(1024) {
+        tevents_(1024),
+        timers_(time::timer_queue::create()) {
     }
 
     bool poller::start() {
@@ -33,18 +41,31 @@ namespace poll {
 
         started_.store(true);
 
+        // Timers are observed by poller thread, no observer thread is needed.
+        timers_->start(&poller::__handle_timeout_timer, false);
+
         worker_.reset(object_create<std::thread>([&]() {
+                          PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_POLLER);
                           while (started_.load()) {
+                              time::update_cached_clock_milliseconds();
+
                               __handle_channel_events();
 
                               __handle_channel_tracker_events();
 
-                              if (cev_cnt_.load(std::memory_order_acquire) > 0 ||
+                              int32_t timeout = __handle_timers();
+
+                              // Waiting flag is set before checking pending events,
+                              // and pushing channel event checks it after adding
+                              // pending count, so no wakeup is lost.
+                              waiting_.store(true);
+                              if (cev_cnt_.load() > 0 ||
                                   tev_cnt_.load(std::memory_order_acquire) > 0) {
                                   __poll(0);
                               } else {
-                                  __poll(3);
+                                  __poll(timeout);
                               }
+                              waiting_.store(false, std::memory_order_relaxed);
                           }
                       }),
                       object_delete<std::thread>);
@@ -57,6 +78,7 @@ namespace poll {
             worker_->join();
             worker_.reset();
         }
+        __clear_channel_events();
     }
 
     bool poller::add_channel_tracker(channel_tracker_sptr &tracker) {
@@ -110,36 +132,68 @@ namespace poll {
         tev_cnt_.fetch_add(1, std::memory_order_relaxed);
     }
 
-    bool poller::push_channel_event(channel_sptr &c, int32_t event) {
+    bool poller::push_channel_event(channel_sptr &&c, int32_t event) {
         if (PUMP_UNLIKELY(!started_.load())) {
             PUMP_DEBUG_LOG("poller: push channel event failed for poller not started");
             return false;
         }
 
-        // Create channel event
-        auto cev = object_create<channel_event>(c, event);
-        PUMP_DEBUG_CHECK(cevents_.push(cev));
+        // Push channel event to overflow queue if ring queue is full.
+        channel_event ev(std::move(c), event);
+        if (PUMP_UNLIKELY(!cevents_.push(std::move(ev)))) {
+            INLINE_OBJECT_CREATE(cev, channel_event, (std::move(ev)));
+            PUMP_DEBUG_CHECK(overflow_cevents_.push(cev));
+        }
 
         // Add pending channel event count
-        cev_cnt_.fetch_add(1, std::memory_order_relaxed);
+        cev_cnt_.fetch_add(1);
+
+        // Wakeup poller thread if it is waiting, so the event is handled at once
+        // instead of after polling timeout.
+        if (waiting_.load() && waiting_.exchange(false)) {
+            __wakeup();
+        }
 
         return true;
     }
 
     void poller::__handle_channel_events() {
-        channel_event_ptr ev = nullptr;
-        int32_t cnt = cev_cnt_.exchange(0, std::memory_order_relaxed);
-        while (cnt > 0) {
-            PUMP_DEBUG_CHECK(cevents_.pop(ev));
-            PUMP_LOCK_WPOINTER(ch, ev->ch);
-            if (ch) {
-                ch->handle_channel_event(ev->event);
+        // Pending count is just a hint, all ready events are handled. Events pushed but
+        // not ready yet will be handled at next loop, as their count is added later.
+        if (cev_cnt_.exchange(0, std::memory_order_acquire) == 0) {
+            return;
+        }
+
+        channel_event evs[POLLER_CHANNEL_EVENT_BULK_SIZE];
+        uint32_t cnt = 0;
+        while ((cnt = cevents_.pop_bulk(evs, POLLER_CHANNEL_EVENT_BULK_SIZE)) > 0) {
+            for (uint32_t i = 0; i < cnt; i++) {
+                evs[i].ch->handle_channel_event(evs[i].event);
+                evs[i].ch.reset();
             }
+        }
 
+        channel_event_ptr ev = nullptr;
+        while (overflow_cevents_.pop(ev)) {
+            ev->ch->handle_channel_event(ev->event);
             object_delete(ev);
+        }
+    }
 
-            cnt--;
+    void poller::__clear_channel_events() {
+        channel_event evs[POLLER_CHANNEL_EVENT_BULK_SIZE];
+        uint32_t cnt = 0;
+        while ((cnt = cevents_.pop_bulk(evs, POLLER_CHANNEL_EVENT_BULK_SIZE)) > 0) {
+            for (uint32_t i = 0; i < cnt; i++) {
+                evs[i].ch.reset();
+            }
+        }
+
+        channel_event_ptr ev = nullptr;
+        while (overflow_cevents_.pop(ev)) {
+            object_delete(ev);
         }
+        cev_cnt_.store(0, std::memory_order_relaxed);
     }
 
     void poller::__handle_channel_tracker_events() {
@@ -161,5 +215,28 @@ namespace poll {
         }
     }
 
+    int32_t poller::__handle_timers() {
+        uint64_t now = time::get_cached_clock_milliseconds();
+        uint64_t next = timers_->get_next_observe_time();
+        if (next <= now) {
+            timers_->observe(now);
+            next = timers_->get_next_observe_time();
+        }
+
+        if (next <= now) {
+            return 0;
+        } else if (next - now < POLLER_MAX_TIMEOUT) {
+            return int32_t(next - now);
+        }
+        return POLLER_MAX_TIMEOUT;
+    }
+
+    void poller::__handle_timeout_timer(time::timer_wptr &&wptr) {
+        PUMP_LOCK_WPOINTER(timer, wptr);
+        if (timer) {
+            timer->handle_timeout();
+        }
+    }
+
 }  // namespace poll
 }  // namespace pump
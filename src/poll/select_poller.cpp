@@ -95,6 +95,7 @@ namespace poll {
         }
 #endif
         if (count > 0) {
+            time::update_cached_clock_milliseconds();
             __dispatch_pending_event(&read_fds_, &write_fds_);
         }
 #endif
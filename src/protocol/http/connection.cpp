@@ -43,6 +43,8 @@ namespace http {
     }
 
     bool connection::start(service_ptr sv, const http_callbacks &cbs) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_HTTP);
+
         if (!transp_) {
             return false;
         }
@@ -82,18 +84,24 @@ namespace http {
     }
 
     bool connection::send(c_pocket_ptr pk) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_HTTP);
+
         std::string data;
         pk->serialize(data);
         return transp_->send(data.c_str(), (int32_t)data.size()) == transport::ERROR_OK;
     }
 
     bool connection::send(c_body_ptr b) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_HTTP);
+
         std::string data;
         b->serialize(data);
         return transp_->send(data.c_str(), (int32_t)data.size()) == transport::ERROR_OK;
     }
 
     void connection::on_read(connection_wptr wptr, const block_t *b, int32_t size) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_HTTP);
+
         PUMP_LOCK_WPOINTER(conn, wptr);
         if (conn) {
             conn->__handle_http_data(b, size);
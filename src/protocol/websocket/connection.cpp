@@ -85,6 +85,8 @@ namespace websocket {
     }
 
     bool connection::start(const connection_callbacks &cbs) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_WEBSOCKET);
+
         PUMP_ASSERT(!pocket_);
         PUMP_ASSERT(decode_phase_ == DECODE_FRAME_HEADER);
 
@@ -154,6 +156,8 @@ namespace websocket {
     }
 
     bool connection::send(const block_t *b, int32_t size) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_WEBSOCKET);
+
         PUMP_LOCK_SPOINTER(transp, transp_);
         if (!transp || !transp->is_started()) {
             return false;
@@ -186,6 +190,8 @@ namespace websocket {
     }
 
     void connection::on_read(connection_wptr wptr, const block_t *b, int32_t size) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_WEBSOCKET);
+
         PUMP_LOCK_WPOINTER(conn, wptr);
         if (conn) {
             if (!conn->read_cache_.empty()) {
@@ -19,11 +19,22 @@
 #include "pump/poll/epoll_poller.h"
 #include "pump/poll/select_poller.h"
 #include "pump/poll/afd_poller.h"
+#include "pump/transport/base_transport.h"
 
 namespace pump {
 
+    const static int32_t SERVICE_POSTED_TASK_RING_SIZE = 16384;
+
+    const static int32_t SERVICE_WORKER_BULK_SIZE = 32;
+
     service::service(bool enable_poller)
-      : running_(false) {
+      : running_(false),
+        posted_tasks_(SERVICE_POSTED_TASK_RING_SIZE),
+        crypto_worker_count_(0),
+        timer_worker_count_(1),
+        timer_dispatch_count_(0),
+        timer_dispatch_lag_(0),
+        timer_dispatch_max_lag_(0) {
         memset(pollers_, 0, sizeof(pollers_));
         if (enable_poller) {
 #if defined(PUMP_HAVE_IOCP)
@@ -39,15 +50,15 @@ namespace pump {
         }
 
         timers_ = time::timer_queue::create();
+        hr_timers_ = time::timer_queue::create_high_resolution();
     }
 
     service::~service() {
-        if (pollers_[READ_POLLER]) {
-            delete pollers_[READ_POLLER];
-        }
-        if (pollers_[SEND_POLLER]) {
-            delete pollers_[SEND_POLLER];
-        }
+        // Transports are released before pollers, as they remove trackers from pollers.
+        transports_.clear();
+        // Pollers are created by object_create, so they must be freed by object_delete.
+        object_delete(pollers_[READ_POLLER]);
+        object_delete(pollers_[SEND_POLLER]);
     }
 
     bool service::start() {
@@ -61,6 +72,9 @@ namespace pump {
         if (timers_) {
             timers_->start(pump_bind(&service::__post_pending_timer, this, _1));
         }
+        if (hr_timers_) {
+            hr_timers_->start(pump_bind(&service::__handle_high_resolution_timer, this, _1));
+        }
         if (pollers_[READ_POLLER]) {
             pollers_[READ_POLLER]->start();
         }
@@ -70,7 +84,9 @@ namespace pump {
 
         __start_posted_task_worker();
 
-        __start_timeout_timer_worker();
+        __start_timeout_timer_workers();
+
+        __start_crypto_workers();
 
         return true;
     }
@@ -81,6 +97,9 @@ namespace pump {
         if (timers_) {
             timers_->stop();
         }
+        if (hr_timers_) {
+            hr_timers_->stop();
+        }
         if (pollers_[READ_POLLER]) {
             pollers_[READ_POLLER]->stop();
         }
@@ -99,11 +118,17 @@ namespace pump {
         if (timers_) {
             timers_->wait_stopped();
         }
+        if (hr_timers_) {
+            hr_timers_->wait_stopped();
+        }
         if (posted_task_worker_) {
             posted_task_worker_->join();
         }
-        if (pending_timer_worker_) {
-            pending_timer_worker_->join();
+        for (auto &worker : pending_timer_workers_) {
+            worker->join();
+        }
+        for (auto &worker : crypto_workers_) {
+            worker->join();
         }
     }
 
@@ -131,14 +156,52 @@ namespace pump {
     }
 
     bool service::post_channel_event(poll::channel_sptr &ch, int32_t event) {
+        return post_channel_event(poll::channel_sptr(ch), event);
+    }
+
+    bool service::post_channel_event(poll::channel_sptr &&ch, int32_t event) {
         if (PUMP_LIKELY(!!pollers_[SEND_POLLER])) {
-            return pollers_[SEND_POLLER]->push_channel_event(ch, event);
+            return pollers_[SEND_POLLER]->push_channel_event(std::move(ch), event);
         }
         return false;
     }
 
+    bool service::set_crypto_worker_count(int32_t count) {
+        if (running_) {
+            PUMP_WARN_LOG("service: set crypto worker count failed for having started");
+            return false;
+        }
+        if (count < 0) {
+            PUMP_WARN_LOG("service: set crypto worker count failed with invalid count");
+            return false;
+        }
+        crypto_worker_count_ = count;
+        return true;
+    }
+
+    bool service::set_timer_worker_count(int32_t count) {
+        if (running_) {
+            PUMP_WARN_LOG("service: set timer worker count failed for having started");
+            return false;
+        }
+        if (count <= 0) {
+            PUMP_WARN_LOG("service: set timer worker count failed with invalid count");
+            return false;
+        }
+        timer_worker_count_ = count;
+        return true;
+    }
+
+    timer_dispatch_stats service::get_timer_dispatch_stats() const {
+        timer_dispatch_stats stats;
+        stats.count = timer_dispatch_count_.load(std::memory_order_relaxed);
+        stats.total_lag = timer_dispatch_lag_.load(std::memory_order_relaxed);
+        stats.max_lag = timer_dispatch_max_lag_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
     bool service::start_timer(time::timer_sptr &timer) {
-        auto queue = timers_;
+        auto queue = timer->is_high_resolution() ? hr_timers_ : timers_;
         if (PUMP_LIKELY(!!queue)) {
             return queue->start_timer(timer);
         }
@@ -148,12 +211,50 @@ namespace pump {
         return false;
     }
 
+    bool service::start_timer(time::timer_sptr &timer, int32_t pi) {
+        PUMP_ASSERT(pi <= SEND_POLLER);
+        if (pollers_[pi] && !timer->is_high_resolution()) {
+            return pollers_[pi]->start_timer(timer);
+        }
+        return start_timer(timer);
+    }
+
+    void service::__handle_high_resolution_timer(time::timer_wptr &&wptr) {
+        PUMP_LOCK_WPOINTER(timer, wptr);
+        if (timer) {
+            __dispatch_timer(timer_locker);
+        }
+    }
+
+    void service::__dispatch_timer(time::timer_sptr &timer) {
+        // Dispatch lag is with us, millisecond timer has millisecond precision.
+        uint64_t lag = 0;
+        if (timer->is_high_resolution()) {
+            uint64_t now = time::get_clock_microseconds();
+            lag = now > timer->time() ? now - timer->time() : 0;
+        } else {
+            uint64_t now = time::get_clock_milliseconds();
+            lag = now > timer->time() ? (now - timer->time()) * 1000 : 0;
+        }
+        timer_dispatch_count_.fetch_add(1, std::memory_order_relaxed);
+        timer_dispatch_lag_.fetch_add(lag, std::memory_order_relaxed);
+        uint64_t max_lag = timer_dispatch_max_lag_.load(std::memory_order_relaxed);
+        while (lag > max_lag &&
+               !timer_dispatch_max_lag_.compare_exchange_weak(max_lag, lag)) {
+        }
+
+        timer->handle_timeout();
+    }
+
     void service::__start_posted_task_worker() {
         auto func = [&]() {
-            posted_task_type task;
+            posted_task_type tasks[SERVICE_WORKER_BULK_SIZE];
             while (running_) {
-                if (posted_tasks_.dequeue(task, std::chrono::seconds(1))) {
-                    task();
+                uint32_t count = posted_tasks_.dequeue_bulk(
+                    tasks, SERVICE_WORKER_BULK_SIZE, std::chrono::seconds(1));
+                for (uint32_t i = 0; i < count; i++) {
+                    tasks[i]();
+                    tasks[i] = posted_task_type();
                 }
             }
         };
@@ -161,20 +262,68 @@ namespace pump {
                                   object_delete<std::thread>);
     }
 
-    void service::__start_timeout_timer_worker() {
-        auto func = [&]() {
-            time::timer_wptr wptr;
+    void service::__start_timeout_timer_workers() {
+        // With many workers, a worker takes one timer once, so slow timers are spread
+        // to all workers.
+        uint32_t bulk_size = timer_worker_count_ > 1 ? 1 : SERVICE_WORKER_BULK_SIZE;
+        auto func = [&, bulk_size]() {
+            PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TIMER);
+            time::timer_wptr wptrs[SERVICE_WORKER_BULK_SIZE];
             while (running_) {
-                if (pending_timers_.dequeue(wptr, std::chrono::seconds(1))) {
-                    auto ptr = wptr.lock();
+                uint32_t count =
+                    pending_timers_.dequeue_bulk(wptrs, bulk_size, std::chrono::seconds(1));
+                for (uint32_t i = 0; i < count; i++) {
+                    auto ptr = wptrs[i].lock();
                     if (PUMP_LIKELY(!!ptr)) {
-                        ptr->handle_timeout();
+                        __dispatch_timer(ptr);
                     }
+                    wptrs[i].reset();
+                }
+            }
+        };
+        for (int32_t i = 0; i < timer_worker_count_; i++) {
+            pending_timer_workers_.push_back(std::shared_ptr<std::thread>(
+                object_create<std::thread>(func), object_delete<std::thread>));
+        }
+    }
+
+    void service::__start_crypto_workers() {
+        auto func = [&]() {
+            posted_task_type task;
+            while (running_) {
+                if (crypto_tasks_.dequeue(task, std::chrono::seconds(1))) {
+                    task();
                 }
             }
         };
-        pending_timer_worker_.reset(object_create<std::thread>(func),
-                                    object_delete<std::thread>);
+        for (int32_t i = 0; i < crypto_worker_count_; i++) {
+            crypto_workers_.push_back(std::shared_ptr<std::thread>(
+                object_create<std::thread>(func), object_delete<std::thread>));
+        }
+    }
+
+    transport_handle service::add_transport(
+        const std::shared_ptr<transport::base_transport> &t) {
+        if (!t) {
+            PUMP_WARN_LOG("service: add transport failed for invalid transport");
+            return INVALID_TRANSPORT_HANDLE;
+        }
+        return transports_.insert(t);
+    }
+
+    std::shared_ptr<transport::base_transport> service::get_transport(
+        transport_handle handle) {
+        return transports_.get(handle);
+    }
+
+    int32_t service::send(transport_handle handle, const block_t *b, int32_t size) {
+        transport::base_transport *t = transports_.pin(handle);
+        if (PUMP_UNLIKELY(t == nullptr)) {
+            return transport::ERROR_INVALID;
+        }
+        int32_t ret = t->send(b, size);
+        transports_.unpin(handle);
+        return ret;
     }
 
 }  // namespace pump
@@ -17,11 +17,19 @@
 #include "pump/debug.h"
 #include "pump/config.h"
 #include "pump/ssl/ssl_helper.h"
+#include "pump/time/timestamp.h"
+
+#include <map>
+#include <string.h>
 
 #if defined(PUMP_HAVE_OPENSSL)
 extern "C" {
 #include <openssl/ssl.h>
 #include <openssl/err.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#endif
 }
 #endif
 
@@ -34,6 +42,236 @@ extern "C" {
 namespace pump {
 namespace ssl {
 
+#if defined(PUMP_HAVE_GNUTLS) || defined(PUMP_HAVE_OPENSSL)
+    struct tls_ticket_key {
+        uint8_t name[16];
+        uint8_t aes_key[32];
+        uint8_t hmac_key[32];
+    };
+
+    struct tls_certificate_options {
+        tls_certificate_options() noexcept
+          : key_rotate_interval(0),
+            next_rotate_time(0),
+            has_previous_key(false) {
+#if defined(PUMP_HAVE_GNUTLS)
+            ticket_key.data = nullptr;
+            ticket_key.size = 0;
+#endif
+        }
+
+        ~tls_certificate_options() {
+#if defined(PUMP_HAVE_GNUTLS)
+            if (ticket_key.data) {
+                gnutls_free(ticket_key.data);
+            }
+#endif
+        }
+
+        // Server session cache
+        tls_session_cache_sptr cache;
+        // Ticket key rotate interval
+        int64_t key_rotate_interval;
+#if defined(PUMP_HAVE_GNUTLS)
+        // GnuTLS ticket master key
+        gnutls_datum_t ticket_key;
+#endif
+        // Ticket keys locker
+        std::mutex ticket_mx;
+        // Next ticket key rotate time
+        uint64_t next_rotate_time;
+        // Ticket keys, the first is current key and the second is previous key
+        tls_ticket_key ticket_keys[2];
+        // Previous key valid or not
+        bool has_previous_key;
+    };
+    DEFINE_ALL_POINTER_TYPE(tls_certificate_options);
+
+    static int32_t __to_timeout_seconds(int64_t ms) {
+        return ms < 1000 ? 1 : (int32_t)(ms / 1000);
+    }
+
+    // Certificate options
+    static std::mutex cert_options_mx;
+    static std::map<void_ptr, tls_certificate_options_sptr> cert_options;
+
+    static tls_certificate_options_sptr __get_certificate_options(void_ptr xcred,
+                                                                  bool create) {
+        std::lock_guard<std::mutex> lock(cert_options_mx);
+        auto it = cert_options.find(xcred);
+        if (it != cert_options.end()) {
+            return it->second;
+        }
+        if (!create) {
+            return tls_certificate_options_sptr();
+        }
+        tls_certificate_options_sptr options(object_create<tls_certificate_options>(),
+                                             object_delete<tls_certificate_options>);
+        cert_options[xcred] = options;
+        return options;
+    }
+#endif
+
+#if defined(PUMP_HAVE_GNUTLS)
+    static int32_t __store_session(void_ptr ptr, gnutls_datum_t key, gnutls_datum_t data) {
+        ((tls_session_cache_ptr)ptr)->put(
+            std::string((const char*)key.data, key.size),
+            std::string((const char*)data.data, data.size));
+        return 0;
+    }
+
+    static gnutls_datum_t __retrieve_session(void_ptr ptr, gnutls_datum_t key) {
+        gnutls_datum_t res = {nullptr, 0};
+        std::string data;
+        if (((tls_session_cache_ptr)ptr)->get(
+                std::string((const char*)key.data, key.size), data)) {
+            res.data = (uint8_t*)gnutls_malloc(data.size());
+            if (res.data) {
+                memcpy(res.data, data.data(), data.size());
+                res.size = (uint32_t)data.size();
+            }
+        }
+        return res;
+    }
+
+    static int32_t __remove_session(void_ptr ptr, gnutls_datum_t key) {
+        ((tls_session_cache_ptr)ptr)->remove(std::string((const char*)key.data, key.size));
+        return 0;
+    }
+#elif defined(PUMP_HAVE_OPENSSL)
+    static int32_t __new_session(SSL *ssl, SSL_SESSION *sess) {
+        auto options = __get_certificate_options(SSL_get_SSL_CTX(ssl), false);
+        if (!options || !options->cache) {
+            return 0;
+        }
+
+        uint32_t id_len = 0;
+        const uint8_t *id = SSL_SESSION_get_id(sess, &id_len);
+        int32_t size = i2d_SSL_SESSION(sess, nullptr);
+        if (size <= 0) {
+            return 0;
+        }
+        std::string data(size, 0);
+        uint8_t *p = (uint8_t*)&data[0];
+        i2d_SSL_SESSION(sess, &p);
+        options->cache->put(std::string((const char*)id, id_len), data);
+
+        // Session is not referenced by the callback.
+        return 0;
+    }
+
+    static SSL_SESSION* __get_session(SSL *ssl,
+                                      const uint8_t *id,
+                                      int32_t id_len,
+                                      int32_t *copy) {
+        *copy = 0;
+        auto options = __get_certificate_options(SSL_get_SSL_CTX(ssl), false);
+        if (!options || !options->cache) {
+            return nullptr;
+        }
+
+        std::string data;
+        if (!options->cache->get(std::string((const char*)id, id_len), data)) {
+            return nullptr;
+        }
+        const uint8_t *p = (const uint8_t*)data.data();
+        return d2i_SSL_SESSION(nullptr, &p, (long)data.size());
+    }
+
+    static void __remove_session(SSL_CTX *ctx, SSL_SESSION *sess) {
+        auto options = __get_certificate_options(ctx, false);
+        if (!options || !options->cache) {
+            return;
+        }
+
+        uint32_t id_len = 0;
+        const uint8_t *id = SSL_SESSION_get_id(sess, &id_len);
+        options->cache->remove(std::string((const char*)id, id_len));
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    static bool __rotate_ticket_keys(tls_certificate_options_ptr options) {
+        uint64_t now = time::get_clock_milliseconds();
+        if (now < options->next_rotate_time) {
+            return true;
+        }
+
+        // Previous key is valid only if current key is not older than two intervals.
+        options->has_previous_key = options->next_rotate_time > 0 &&
+            now < options->next_rotate_time + options->key_rotate_interval;
+        options->ticket_keys[1] = options->ticket_keys[0];
+
+        auto &key = options->ticket_keys[0];
+        if (RAND_bytes(key.name, sizeof(key.name)) <= 0 ||
+            RAND_bytes(key.aes_key, sizeof(key.aes_key)) <= 0 ||
+            RAND_bytes(key.hmac_key, sizeof(key.hmac_key)) <= 0) {
+            return false;
+        }
+        options->next_rotate_time = now + options->key_rotate_interval;
+
+        return true;
+    }
+
+    static int32_t __ticket_key_callback(SSL *ssl,
+                                         uint8_t *key_name,
+                                         uint8_t *iv,
+                                         EVP_CIPHER_CTX *ctx,
+                                         EVP_MAC_CTX *hctx,
+                                         int32_t enc) {
+        auto options = __get_certificate_options(SSL_get_SSL_CTX(ssl), false);
+        if (!options) {
+            return -1;
+        }
+
+        std::lock_guard<std::mutex> lock(options->ticket_mx);
+        if (!__rotate_ticket_keys(options.get())) {
+            return -1;
+        }
+
+        int32_t ret = 1;
+        tls_ticket_key *key = nullptr;
+        if (enc) {
+            key = &options->ticket_keys[0];
+            if (RAND_bytes(iv, EVP_CIPHER_get_iv_length(EVP_aes_256_cbc())) <= 0) {
+                return -1;
+            }
+            memcpy(key_name, key->name, sizeof(key->name));
+        } else if (memcmp(key_name, options->ticket_keys[0].name, sizeof(key->name)) == 0) {
+            key = &options->ticket_keys[0];
+        } else if (options->has_previous_key &&
+                   memcmp(key_name, options->ticket_keys[1].name, sizeof(key->name)) == 0) {
+            // Ticket encrypted by previous key should be renewed.
+            key = &options->ticket_keys[1];
+            ret = 2;
+        } else {
+            return 0;
+        }
+
+        OSSL_PARAM params[3];
+        params[0] = OSSL_PARAM_construct_octet_string(
+            OSSL_MAC_PARAM_KEY, key->hmac_key, sizeof(key->hmac_key));
+        params[1] = OSSL_PARAM_construct_utf8_string(
+            OSSL_MAC_PARAM_DIGEST, (char*)"sha256", 0);
+        params[2] = OSSL_PARAM_construct_end();
+        if (EVP_MAC_CTX_set_params(hctx, params) <= 0) {
+            return -1;
+        }
+
+        if (enc) {
+            if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key->aes_key, iv) <= 0) {
+                return -1;
+            }
+        } else {
+            if (EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key->aes_key, iv) <= 0) {
+                return -1;
+            }
+        }
+
+        return ret;
+    }
+#endif
+#endif
+
     void_ptr create_tls_client_certificate() {
 #if defined(PUMP_HAVE_GNUTLS)
         gnutls_certificate_credentials_t xcred;
@@ -194,7 +432,119 @@ namespace ssl {
 #endif
     }
 
+    bool enable_tls_kernel_offload(void_ptr xcred) {
+#if defined(PUMP_HAVE_OPENSSL) && defined(SSL_OP_ENABLE_KTLS)
+        if (xcred) {
+            SSL_CTX_set_options((SSL_CTX*)xcred, SSL_OP_ENABLE_KTLS);
+            return true;
+        }
+#endif
+        return false;
+    }
+
+    bool set_tls_session_cache(void_ptr xcred, tls_session_cache_sptr &cache) {
+        if (!xcred || !cache) {
+            return false;
+        }
+#if defined(PUMP_HAVE_GNUTLS)
+        __get_certificate_options(xcred, true)->cache = cache;
+        return true;
+#elif defined(PUMP_HAVE_OPENSSL)
+        auto options = __get_certificate_options(xcred, true);
+        options->cache = cache;
+
+        SSL_CTX *ctx = (SSL_CTX*)xcred;
+        SSL_CTX_set_session_id_context(ctx, (const uint8_t*)"pump", 4);
+        SSL_CTX_set_session_cache_mode(
+            ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_set_timeout(ctx, __to_timeout_seconds(cache->get_timeout()));
+        SSL_CTX_sess_set_new_cb(ctx, __new_session);
+        SSL_CTX_sess_set_get_cb(ctx, __get_session);
+        SSL_CTX_sess_set_remove_cb(ctx, __remove_session);
+        // Use stateful resumption if session ticket is not enabled.
+        if (options->key_rotate_interval == 0) {
+            SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool enable_tls_session_ticket(void_ptr xcred, int64_t key_rotate_interval) {
+        if (!xcred || key_rotate_interval <= 0) {
+            return false;
+        }
+#if defined(PUMP_HAVE_GNUTLS)
+        auto options = __get_certificate_options(xcred, true);
+        std::lock_guard<std::mutex> lock(options->ticket_mx);
+        if (!options->ticket_key.data &&
+            gnutls_session_ticket_key_generate(&options->ticket_key) != 0) {
+            PUMP_ERR_LOG(
+                "ssl_helper: enable tls session ticket failed for gnutls_session_ticket_key_generate failed");
+            return false;
+        }
+        options->key_rotate_interval = key_rotate_interval;
+        return true;
+#elif defined(PUMP_HAVE_OPENSSL) && OPENSSL_VERSION_NUMBER >= 0x30000000L
+        auto options = __get_certificate_options(xcred, true);
+        {
+            std::lock_guard<std::mutex> lock(options->ticket_mx);
+            options->key_rotate_interval = key_rotate_interval;
+            options->next_rotate_time = 0;
+            if (!__rotate_ticket_keys(options.get())) {
+                PUMP_ERR_LOG(
+                    "ssl_helper: enable tls session ticket failed for generating ticket key failed");
+                return false;
+            }
+        }
+
+        SSL_CTX *ctx = (SSL_CTX*)xcred;
+        SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+        SSL_CTX_set_timeout(ctx, __to_timeout_seconds(key_rotate_interval * 2));
+        if (SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, __ticket_key_callback) != 1) {
+            PUMP_ERR_LOG(
+                "ssl_helper: enable tls session ticket failed for SSL_CTX_set_tlsext_ticket_key_evp_cb failed");
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void apply_tls_certificate_options(void_ptr xcred, void_ptr ssl_ctx) {
+#if defined(PUMP_HAVE_GNUTLS)
+        auto options = __get_certificate_options(xcred, false);
+        if (!options) {
+            return;
+        }
+
+        gnutls_session_t session = (gnutls_session_t)ssl_ctx;
+        if (options->cache) {
+            gnutls_db_set_ptr(session, options->cache.get());
+            gnutls_db_set_store_function(session, __store_session);
+            gnutls_db_set_retrieve_function(session, __retrieve_session);
+            gnutls_db_set_remove_function(session, __remove_session);
+            gnutls_db_set_cache_expiration(
+                session, __to_timeout_seconds(options->cache->get_timeout()));
+        }
+        if (options->ticket_key.data) {
+            gnutls_session_ticket_enable_server(session, &options->ticket_key);
+            gnutls_db_set_cache_expiration(
+                session, __to_timeout_seconds(options->key_rotate_interval));
+        }
+#endif
+    }
+
     void destory_tls_certificate(void_ptr xcred) {
+#if defined(PUMP_HAVE_GNUTLS) || defined(PUMP_HAVE_OPENSSL)
+        {
+            std::lock_guard<std::mutex> lock(cert_options_mx);
+            cert_options.erase(xcred);
+        }
+#endif
+
 #if defined(PUMP_HAVE_GNUTLS)
         if (xcred) {
             gnutls_certificate_free_credentials((gnutls_certificate_credentials_t)xcred);
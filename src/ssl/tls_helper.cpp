@@ -17,6 +17,7 @@
 #include "pump/debug.h"
 #include "pump/config.h"
 #include "pump/ssl/tls_helper.h"
+#include "pump/ssl/ssl_helper.h"
 
 #if defined(PUMP_HAVE_OPENSSL)
 extern "C" {
@@ -25,28 +26,144 @@ extern "C" {
 #endif
 
 #if defined(PUMP_HAVE_GNUTLS)
+#include <errno.h>
+
 extern "C" {
 #include <gnutls/gnutls.h>
+#if GNUTLS_VERSION_NUMBER >= 0x030703
+#include <gnutls/socket.h>
+#endif
 }
 #endif
 
 namespace pump {
 namespace ssl {
 
-    tls_session_ptr create_tls_session(void_ptr xcred, int32_t fd, bool client) {
+#if defined(PUMP_HAVE_OPENSSL) || defined(PUMP_HAVE_GNUTLS)
+    static int32_t __read_net_buffer(tls_session_ptr session, block_t *b, int32_t size) {
+        toolkit::io_buffer_ptr iob = session->net_read_iob;
+        int32_t data_size = (int32_t)iob->data_size();
+        if (data_size == 0) {
+            return 0;
+        }
+        if (size > data_size) {
+            size = data_size;
+        }
+        memcpy(b, iob->data(), size);
+        if (iob->shift(size) == 0) {
+            iob->reset();
+        }
+        return size;
+    }
+#endif
+
 #if defined(PUMP_HAVE_GNUTLS)
-        tls_session_ptr session = object_create<tls_session>();
+    static ssize_t __memory_push(gnutls_transport_ptr_t ptr, const void *b, size_t size) {
+        tls_session_ptr session = (tls_session_ptr)ptr;
+        if (!session->net_send_iob->append((const block_t*)b, (uint32_t)size)) {
+            gnutls_transport_set_errno((gnutls_session_t)session->ssl_ctx, ENOMEM);
+            return -1;
+        }
+        return (ssize_t)size;
+    }
+
+    static ssize_t __memory_pull(gnutls_transport_ptr_t ptr, void *b, size_t size) {
+        tls_session_ptr session = (tls_session_ptr)ptr;
+        int32_t ret = __read_net_buffer(session, (block_t*)b, (int32_t)size);
+        if (ret == 0) {
+            gnutls_transport_set_errno((gnutls_session_t)session->ssl_ctx, EAGAIN);
+            return -1;
+        }
+        return ret;
+    }
+
+    static int __memory_pull_timeout(gnutls_transport_ptr_t ptr, unsigned int ms) {
+        tls_session_ptr session = (tls_session_ptr)ptr;
+        if (session->net_read_iob->data_size() == 0) {
+            gnutls_transport_set_errno((gnutls_session_t)session->ssl_ctx, EAGAIN);
+            return -1;
+        }
+        return 1;
+    }
+
+    static gnutls_session_t __create_tls_context(void_ptr xcred, bool client) {
         gnutls_session_t ssl_ctx = nullptr;
         if (client) {
             gnutls_init(&ssl_ctx, GNUTLS_CLIENT | GNUTLS_NONBLOCK);
         } else {
             gnutls_init(&ssl_ctx, GNUTLS_SERVER | GNUTLS_NONBLOCK);
+            // Apply server session cache and session ticket options.
+            apply_tls_certificate_options(xcred, ssl_ctx);
         }
         gnutls_set_default_priority(ssl_ctx);
         // Set GnuTLS session with credentials
         gnutls_credentials_set(ssl_ctx, GNUTLS_CRD_CERTIFICATE, xcred);
         // Set GnuTLS handshake timeout time.
         gnutls_handshake_set_timeout(ssl_ctx, GNUTLS_INDEFINITE_TIMEOUT);
+        return ssl_ctx;
+    }
+#elif defined(PUMP_HAVE_OPENSSL)
+    static int __memory_bio_write(BIO *bio, const char *b, int size) {
+        BIO_clear_retry_flags(bio);
+        if (size <= 0) {
+            return 0;
+        }
+        tls_session_ptr session = (tls_session_ptr)BIO_get_data(bio);
+        if (!session->net_send_iob->append(b, size)) {
+            return -1;
+        }
+        return size;
+    }
+
+    static int __memory_bio_read(BIO *bio, char *b, int size) {
+        BIO_clear_retry_flags(bio);
+        tls_session_ptr session = (tls_session_ptr)BIO_get_data(bio);
+        int32_t ret = __read_net_buffer(session, b, size);
+        if (ret == 0) {
+            BIO_set_retry_read(bio);
+            return -1;
+        }
+        return ret;
+    }
+
+    static long __memory_bio_ctrl(BIO *bio, int cmd, long num, void *ptr) {
+        return cmd == BIO_CTRL_FLUSH ? 1 : 0;
+    }
+
+    static int __memory_bio_create(BIO *bio) {
+        BIO_set_init(bio, 1);
+        return 1;
+    }
+
+    static BIO_METHOD* __create_memory_bio_method() {
+        BIO_METHOD *method = BIO_meth_new(
+            BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "pump memory io");
+        if (method) {
+            BIO_meth_set_write(method, __memory_bio_write);
+            BIO_meth_set_read(method, __memory_bio_read);
+            BIO_meth_set_ctrl(method, __memory_bio_ctrl);
+            BIO_meth_set_create(method, __memory_bio_create);
+        }
+        return method;
+    }
+
+    static SSL* __create_tls_context(void_ptr xcred, bool client) {
+        SSL *ssl_ctx = SSL_new((SSL_CTX*)xcred);
+        if (ssl_ctx) {
+            if (client) {
+                SSL_set_connect_state(ssl_ctx);
+            } else {
+                SSL_set_accept_state(ssl_ctx);
+            }
+        }
+        return ssl_ctx;
+    }
+#endif
+
+    tls_session_ptr create_tls_session(void_ptr xcred, int32_t fd, bool client) {
+#if defined(PUMP_HAVE_GNUTLS)
+        tls_session_ptr session = object_create<tls_session>();
+        gnutls_session_t ssl_ctx = __create_tls_context(xcred, client);
         // Set GnuTLS transport fd.
         gnutls_transport_set_int(ssl_ctx, fd);
 
@@ -55,13 +172,57 @@ namespace ssl {
         return session;
 #elif defined(PUMP_HAVE_OPENSSL)
         tls_session_ptr session = object_create<tls_session>();
-        SSL *ssl_ctx = SSL_new((SSL_CTX*)xcred);
+        SSL *ssl_ctx = __create_tls_context(xcred, client);
         SSL_set_fd(ssl_ctx, fd);
-        if (client) {
-            SSL_set_connect_state(ssl_ctx);
-        } else {
-            SSL_set_accept_state(ssl_ctx);
+
+        session->ssl_ctx = ssl_ctx;
+
+        return session;
+#else
+        return nullptr;
+#endif
+    }
+
+    tls_session_ptr create_tls_memory_session(void_ptr xcred, bool client) {
+#if defined(PUMP_HAVE_OPENSSL) || defined(PUMP_HAVE_GNUTLS)
+        tls_session_ptr session = object_create<tls_session>();
+        session->ssl_ctx = nullptr;
+        session->net_read_iob = toolkit::io_buffer::create();
+        session->net_send_iob = toolkit::io_buffer::create();
+        if (!session->net_read_iob || 
+            !session->net_read_iob->init_with_size(TLS_NET_BUFFER_SIZE) ||
+            !session->net_send_iob || 
+            !session->net_send_iob->init_with_size(TLS_NET_BUFFER_SIZE)) {
+            PUMP_WARN_LOG("tls_helper: create tls memory session failed for creating net buffers failed");
+            destory_tls_session(session);
+            return nullptr;
+        }
+#endif
+
+#if defined(PUMP_HAVE_GNUTLS)
+        gnutls_session_t ssl_ctx = __create_tls_context(xcred, client);
+        // Set GnuTLS transport functions with net buffers.
+        gnutls_transport_set_ptr(ssl_ctx, session);
+        gnutls_transport_set_push_function(ssl_ctx, __memory_push);
+        gnutls_transport_set_pull_function(ssl_ctx, __memory_pull);
+        gnutls_transport_set_pull_timeout_function(ssl_ctx, __memory_pull_timeout);
+
+        session->ssl_ctx = ssl_ctx;
+
+        return session;
+#elif defined(PUMP_HAVE_OPENSSL)
+        static BIO_METHOD *method = __create_memory_bio_method();
+        BIO *bio = method ? BIO_new(method) : nullptr;
+        if (!bio) {
+            PUMP_WARN_LOG("tls_helper: create tls memory session failed for creating bio failed");
+            destory_tls_session(session);
+            return nullptr;
         }
+        BIO_set_data(bio, session);
+
+        SSL *ssl_ctx = __create_tls_context(xcred, client);
+        // SSL takes the bio ownership for both reading and writing.
+        SSL_set_bio(ssl_ctx, bio, bio);
 
         session->ssl_ctx = ssl_ctx;
 
@@ -85,6 +246,12 @@ namespace ssl {
             SSL_free((SSL*)session->ssl_ctx);
         }
 #endif
+        if (session->net_read_iob) {
+            session->net_read_iob->sub_ref();
+        }
+        if (session->net_send_iob) {
+            session->net_send_iob->sub_ref();
+        }
         object_delete(session);
     }
 
@@ -118,13 +285,97 @@ namespace ssl {
         return TLS_HANDSHAKE_ERROR;
     }
 
+    bool tls_set_session_data(tls_session_ptr session, const std::string &data) {
+        if (data.empty()) {
+            return false;
+        }
+#if defined(PUMP_HAVE_GNUTLS)
+        return gnutls_session_set_data(
+            (gnutls_session_t)session->ssl_ctx, data.data(), data.size()) == 0;
+#elif defined(PUMP_HAVE_OPENSSL)
+        const uint8_t *p = (const uint8_t*)data.data();
+        SSL_SESSION *sess = d2i_SSL_SESSION(nullptr, &p, (long)data.size());
+        if (!sess) {
+            return false;
+        }
+        int32_t ret = SSL_set_session((SSL*)session->ssl_ctx, sess);
+        SSL_SESSION_free(sess);
+        return ret == 1;
+#else
+        return false;
+#endif
+    }
+
+    bool tls_get_session_data(tls_session_ptr session, std::string &data) {
+#if defined(PUMP_HAVE_GNUTLS)
+        gnutls_session_t ssl_ctx = (gnutls_session_t)session->ssl_ctx;
+        if (gnutls_protocol_get_version(ssl_ctx) == GNUTLS_TLS1_3 &&
+            (gnutls_session_get_flags(ssl_ctx) & GNUTLS_SFLAGS_SESSION_TICKET) == 0) {
+            return false;
+        }
+        gnutls_datum_t datum;
+        if (gnutls_session_get_data2(ssl_ctx, &datum) != 0) {
+            return false;
+        }
+        data.assign((const char*)datum.data, datum.size);
+        gnutls_free(datum.data);
+        return true;
+#elif defined(PUMP_HAVE_OPENSSL)
+        SSL_SESSION *sess = SSL_get_session((SSL*)session->ssl_ctx);
+        if (!sess || !SSL_SESSION_is_resumable(sess)) {
+            return false;
+        }
+        int32_t size = i2d_SSL_SESSION(sess, nullptr);
+        if (size <= 0) {
+            return false;
+        }
+        data.resize(size);
+        uint8_t *p = (uint8_t*)&data[0];
+        i2d_SSL_SESSION(sess, &p);
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool tls_is_session_resumed(tls_session_ptr session) {
+#if defined(PUMP_HAVE_GNUTLS)
+        return gnutls_session_is_resumed((gnutls_session_t)session->ssl_ctx) != 0;
+#elif defined(PUMP_HAVE_OPENSSL)
+        return SSL_session_reused((SSL*)session->ssl_ctx) == 1;
+#else
+        return false;
+#endif
+    }
+
+    int32_t tls_kernel_offload_state(tls_session_ptr session) {
+        int32_t state = 0;
+#if defined(PUMP_HAVE_GNUTLS) && GNUTLS_VERSION_NUMBER >= 0x030703
+        int32_t ret = gnutls_transport_is_ktls_enabled((gnutls_session_t)session->ssl_ctx);
+        if (ret & GNUTLS_KTLS_SEND) {
+            state |= TLS_KTLS_SEND;
+        }
+        if (ret & GNUTLS_KTLS_RECV) {
+            state |= TLS_KTLS_RECV;
+        }
+#elif defined(PUMP_HAVE_OPENSSL) && defined(BIO_get_ktls_send)
+        if (BIO_get_ktls_send(SSL_get_wbio((SSL*)session->ssl_ctx))) {
+            state |= TLS_KTLS_SEND;
+        }
+        if (BIO_get_ktls_recv(SSL_get_rbio((SSL*)session->ssl_ctx))) {
+            state |= TLS_KTLS_RECV;
+        }
+#endif
+        return state;
+    }
+
     bool tls_has_unread_data(tls_session_ptr session) {
 #if defined(PUMP_HAVE_GNUTLS)
         if (gnutls_record_check_pending((gnutls_session_t)session->ssl_ctx) > 0) {
             return true;
         }
 #elif defined(PUMP_HAVE_OPENSSL)
-        if (SSL_pending((SSL*)session->ssl_ctx) == 1) {
+        if (SSL_pending((SSL*)session->ssl_ctx) > 0) {
             return true;
         }
 #endif
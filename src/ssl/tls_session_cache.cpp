@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pump/ssl/tls_session_cache.h"
+#include "pump/time/timestamp.h"
+
+namespace pump {
+namespace ssl {
+
+    tls_session_cache::tls_session_cache(int32_t max_count, int64_t timeout) noexcept
+      : shard_max_count_(max_count / TLS_SESSION_CACHE_SHARDS + 1),
+        timeout_(timeout) {
+    }
+
+    void tls_session_cache::put(const std::string &id, const std::string &data) {
+        if (id.empty() || data.empty()) {
+            return;
+        }
+
+        uint64_t now = time::get_clock_milliseconds();
+
+        auto &shard = __get_shard(id);
+        std::lock_guard<std::mutex> lock(shard.mx);
+
+        auto it = shard.sessions.find(id);
+        if (it != shard.sessions.end()) {
+            __erase(shard, it);
+        }
+
+        // Evict expired sessions and the oldest session if shard is full. Sessions
+        // have the same timeout, so the front of order list expires at first.
+        while (!shard.order.empty()) {
+            auto oldest = shard.sessions.find(shard.order.front());
+            if (oldest->second.expired > now &&
+                (int32_t)shard.sessions.size() < shard_max_count_) {
+                break;
+            }
+            __erase(shard, oldest);
+        }
+
+        shard.order.push_back(id);
+        auto &entry = shard.sessions[id];
+        entry.data = data;
+        entry.expired = now + timeout_;
+        entry.pos = --shard.order.end();
+    }
+
+    bool tls_session_cache::get(const std::string &id, std::string &data) {
+        auto &shard = __get_shard(id);
+        std::lock_guard<std::mutex> lock(shard.mx);
+
+        auto it = shard.sessions.find(id);
+        if (it == shard.sessions.end()) {
+            return false;
+        }
+        if (it->second.expired <= time::get_clock_milliseconds()) {
+            __erase(shard, it);
+            return false;
+        }
+
+        data = it->second.data;
+
+        return true;
+    }
+
+    void tls_session_cache::remove(const std::string &id) {
+        auto &shard = __get_shard(id);
+        std::lock_guard<std::mutex> lock(shard.mx);
+
+        auto it = shard.sessions.find(id);
+        if (it != shard.sessions.end()) {
+            __erase(shard, it);
+        }
+    }
+
+    int32_t tls_session_cache::size() {
+        int32_t count = 0;
+        for (int32_t i = 0; i < TLS_SESSION_CACHE_SHARDS; i++) {
+            std::lock_guard<std::mutex> lock(shards_[i].mx);
+            count += (int32_t)shards_[i].sessions.size();
+        }
+        return count;
+    }
+
+    void tls_session_cache::__erase(
+        cache_shard &shard,
+        std::unordered_map<std::string, cache_entry>::iterator it) {
+        shard.order.erase(it->second.pos);
+        shard.sessions.erase(it);
+    }
+
+}  // namespace ssl
+}  // namespace pump
@@ -20,15 +20,31 @@
 namespace pump {
 namespace time {
 
-    timer::timer(uint64_t timeout, const timer_callback &cb, bool repeated) noexcept
-      : queue_(nullptr),
+    timer::timer(uint64_t timeout,
+                 const timer_callback &cb,
+                 bool repeated,
+                 bool high_resolution) noexcept
+      : node_(nullptr),
         status_(TIMER_INIT),
         cb_(cb),
         repeated_(repeated),
+        high_resolution_(high_resolution),
         timeout_(timeout),
         overtime_(0) {
     }
 
+    timer::~timer() {
+        // Stopped timer has been removed from timer queue.
+        if (is_started()) {
+            __cancel();
+        }
+    }
+
+    void timer::stop() {
+        __force_set_state(TIMER_STOPPED);
+        __cancel();
+    }
+
     void timer::handle_timeout() {
         if (__set_state(TIMER_STARTED, TIMER_PENDING)) {
 
@@ -37,9 +53,12 @@ namespace time {
             if (PUMP_LIKELY(repeated_)) {
                 if (__set_state(TIMER_PENDING, TIMER_STARTED)) {
                     // Update overtime.
-                    overtime_ = get_clock_milliseconds() + timeout_;
-                    // Add to timer queue.
-                    queue_->restart_timer(shared_from_this());
+                    overtime_ = __now() + timeout_;
+                    // Add to timer queue if it is still alive.
+                    auto queue = queue_.lock();
+                    if (queue) {
+                        queue->restart_timer(shared_from_this());
+                    }
                 }
             } else {
                 __set_state(TIMER_PENDING, TIMER_STOPPED);
@@ -47,16 +66,25 @@ namespace time {
         }
     }
 
-    bool timer::__start(timer_queue_ptr queue) {
+    void timer::__cancel() {
+        // Timer queue may be destroyed before the timer, then there is nothing to
+        // cancel as its timer wheel is released.
+        auto queue = queue_.lock();
+        if (queue) {
+            queue->cancel_timer(this);
+        }
+    }
+
+    bool timer::__start(timer_queue_wptr &&queue) {
         if (!__set_state(TIMER_INIT, TIMER_STARTED)) {
             return false;
         }
 
         // Update overtime.
-        overtime_ = get_clock_milliseconds() + timeout_;
+        overtime_ = __now() + timeout_;
 
         // Save timer queue.
-        queue_ = queue;
+        queue_ = std::move(queue);
 
         return true;
     }
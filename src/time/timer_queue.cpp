@@ -16,33 +16,75 @@
 
 #include "pump/time/timer_queue.h"
 
+#if defined(OS_LINUX)
+#include <errno.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
 namespace pump {
 namespace time {
 
     const static uint64_t TIMER_DEFAULT_INTERVAL = 100;
 
-    timer_queue::timer_queue() noexcept
-      : started_(false), 
-        next_observe_time_(0) {
+    timer_queue::timer_queue(bool high_resolution, uint64_t tick) noexcept
+      : started_(false),
+        high_resolution_(high_resolution),
+        tick_(tick),
+        timer_fd_(-1),
+        next_observe_time_(0),
+        timers_(__now() / tick) {
     }
 
     timer_queue::~timer_queue() {
+#if defined(OS_LINUX)
+        if (timer_fd_ >= 0) {
+            ::close(timer_fd_);
+        }
+#endif
     }
 
-    bool timer_queue::start(const timer_pending_callback &cb) {
+    bool timer_queue::start(const timer_pending_callback &cb, bool with_observer) {
         if (!started_.load()) {
             started_.store(true);
 
             PUMP_DEBUG_ASSIGN(cb, pending_cb_, cb);
 
-            observer_.reset(
-                object_create<std::thread>(pump_bind(&timer_queue::__observe_thread, this)),
-                object_delete<std::thread>);
+            if (with_observer) {
+#if defined(OS_LINUX)
+                if (high_resolution_) {
+                    timer_fd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+                }
+#endif
+                observer_.reset(
+                    object_create<std::thread>(pump_bind(&timer_queue::__observe_thread, this)),
+                    object_delete<std::thread>);
+            }
         }
 
         return started_.load();
     }
 
+    void timer_queue::observe(uint64_t now) {
+        {
+            std::lock_guard<std::mutex> lock(mx_);
+            __observe(now);
+            __update_next_observe_time(now);
+        }
+
+        for (auto &timer : expired_timers_) {
+            pending_cb_(std::move(timer));
+        }
+        expired_timers_.clear();
+    }
+
+    void timer_queue::stop() {
+        std::lock_guard<std::mutex> lock(mx_);
+        started_.store(false);
+        __notify(0);
+    }
+
     void timer_queue::wait_stopped() {
         if (observer_) {
             observer_->join();
@@ -54,81 +96,150 @@ namespace time {
             return false;
         }
 
-        if (!ptr->__start(this)) {
+        // Timer must have the same resolution as the queue.
+        if (ptr->is_high_resolution() != high_resolution_) {
             return false;
         }
 
-        PUMP_DEBUG_CHECK(new_timers_.enqueue(ptr));
+        if (!ptr->__start(shared_from_this())) {
+            return false;
+        }
 
-        return true;
+        return __add_timer(ptr);
     }
 
     bool timer_queue::restart_timer(timer_sptr &&ptr) {
         if (started_.load()) {
-            PUMP_DEBUG_CHECK(new_timers_.enqueue(std::move(ptr)));
-            return true;
+            return __add_timer(ptr);
         }
         return false;
     }
 
+    void timer_queue::cancel_timer(timer_ptr ptr) {
+        std::lock_guard<std::mutex> lock(mx_);
+        if (ptr->node_) {
+            timers_.remove(ptr->node_);
+            ptr->node_ = nullptr;
+        }
+    }
+
+    bool timer_queue::__add_timer(const timer_sptr &ptr) {
+        std::lock_guard<std::mutex> lock(mx_);
+        // Timer maybe stopped before adding, and it must not be added to wheel.
+        if (!ptr->is_started() || ptr->node_) {
+            return false;
+        }
+
+        // Timer expires at the end of its tick, so it never expires early.
+        uint64_t expire = (ptr->time() + tick_ - 1) / tick_;
+        ptr->node_ = timers_.add(ptr, expire);
+        if (PUMP_UNLIKELY(!ptr->node_)) {
+            return false;
+        }
+
+        if (expire * tick_ < next_observe_time_.load(std::memory_order_relaxed)) {
+            next_observe_time_.store(expire * tick_, std::memory_order_relaxed);
+            __notify(expire * tick_);
+        }
+
+        return true;
+    }
+
     void timer_queue::__observe_thread() {
-        // New timer
-        timer_sptr new_timer;
-        // New timer overtime
-        uint64_t new_timer_overtime;
-
-        // Init next observe time.
-        uint64_t now = get_clock_milliseconds();
-        next_observe_time_ = now + TIMER_DEFAULT_INTERVAL;
-
-        while (1) {
-            // Wait unitl next observe time arrived or new timer added.
-            now = get_clock_milliseconds();
-            if (next_observe_time_ > now) {
-                if (new_timers_.dequeue(new_timer, (next_observe_time_ - now) * 1000)) {
-                    new_timer_overtime = new_timer->time();
-                    timers_.insert(std::make_pair(new_timer_overtime, std::move(new_timer)));
-                } else {
-                    now = next_observe_time_;
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TIMER);
+
+        std::unique_lock<std::mutex> lock(mx_);
+        while (started_.load()) {
+            uint64_t now = __now();
+
+            // Collect expired timers, and callback them without lock.
+            __observe(now);
+            if (!expired_timers_.empty()) {
+                lock.unlock();
+                for (auto &timer : expired_timers_) {
+                    pending_cb_(std::move(timer));
                 }
-                
+                expired_timers_.clear();
+                lock.lock();
+                continue;
             }
 
-            // Try to add new timers.
-            while (new_timers_.try_dequeue(new_timer)) {
-                new_timer_overtime = new_timer->time();
-                timers_.insert(std::make_pair(new_timer_overtime, std::move(new_timer)));
-            }
+            // Wait unitl next advancing time arrived or an earlier timer added.
+            __update_next_observe_time(now);
+            __wait(lock, now);
+        }
+    }
 
-            if (!timers_.empty()) {
-                __observe(now);
-            }
+    void timer_queue::__update_next_observe_time(uint64_t now) {
+        uint64_t interval = high_resolution_ ? TIMER_DEFAULT_INTERVAL * 1000
+                                             : TIMER_DEFAULT_INTERVAL;
+        uint64_t next_observe_time = timers_.next_advance_time();
+        if (next_observe_time > (now + interval) / tick_) {
+            next_observe_time = now + interval;
+        } else {
+            next_observe_time *= tick_;
+        }
+        next_observe_time_.store(next_observe_time, std::memory_order_relaxed);
+    }
 
-            if (timers_.empty()) {
-                next_observe_time_ = now + TIMER_DEFAULT_INTERVAL;
-            } else {
-                next_observe_time_ = timers_.begin()->first;
+    void timer_queue::__wait(std::unique_lock<std::mutex> &lock, uint64_t now) {
+        uint64_t next_observe_time = next_observe_time_.load(std::memory_order_relaxed);
+        if (next_observe_time <= now) {
+            return;
+        }
+#if defined(OS_LINUX)
+        if (timer_fd_ >= 0) {
+            // Earlier timers and stopping rearm the timer fd, so it can be read without
+            // lock.
+            __notify(next_observe_time);
+            lock.unlock();
+            uint64_t expirations = 0;
+            if (::read(timer_fd_, &expirations, sizeof(expirations)) < 0) {
+                PUMP_DEBUG_LOG("timer_queue: wait timer fd failed %d", errno);
             }
+            lock.lock();
+            return;
+        }
+#endif
+        if (high_resolution_) {
+            cond_.wait_for(lock, std::chrono::microseconds(next_observe_time - now));
+        } else {
+            cond_.wait_for(lock, std::chrono::milliseconds(next_observe_time - now));
         }
     }
 
-    void timer_queue::__observe(uint64_t now) {
-        // If first timer not pending just return.
-        auto beg = timers_.begin();
-        if (beg->first > now) {
+    void timer_queue::__notify(uint64_t time) {
+#if defined(OS_LINUX)
+        if (timer_fd_ >= 0) {
+            // Zero time disarms timer fd, so the smallest time is used for notifying.
+            struct itimerspec spec;
+            memset(&spec, 0, sizeof(spec));
+            spec.it_value.tv_sec = time / 1000000;
+            spec.it_value.tv_nsec = (time % 1000000) * 1000;
+            if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+                spec.it_value.tv_nsec = 1;
+            }
+            ::timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
             return;
         }
+#endif
+        cond_.notify_one();
+    }
 
-        // Callback pending timers.  
-        auto pending_end = timers_.upper_bound(now);
-        for (auto it = beg; it != pending_end; ++it) {
-            pending_cb_(std::move(it->second));
+    void timer_queue::__observe(uint64_t now) {
+        timers_.advance(now / tick_, expired_nodes_);
+        if (expired_nodes_.empty()) {
+            return;
         }
 
-        // Remove pending timers.
-        if (beg != pending_end) {
-            timers_.erase(beg, pending_end);
+        // Timers are not locked here, as the last timer reference released with lock
+        // would deadlock in timer deconstructor.
+        for (auto node : expired_nodes_) {
+            node->timer->node_ = nullptr;
+            expired_timers_.push_back(std::move(node->timer_ref));
+            timers_.release(node);
         }
+        expired_nodes_.clear();
     }
 
 }  // namespace time
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "pump/time/timer_wheel.h"
+
+namespace pump {
+namespace time {
+
+    const static uint64_t TIMER_WHEEL_ROOT_MASK = TIMER_WHEEL_ROOT_SIZE - 1;
+    const static uint64_t TIMER_WHEEL_LEVEL_MASK = TIMER_WHEEL_LEVEL_SIZE - 1;
+    const static uint64_t TIMER_WHEEL_MAX_DELTA =
+        (1ULL << (TIMER_WHEEL_ROOT_BITS + 
+                  (TIMER_WHEEL_LEVELS - 1) * TIMER_WHEEL_LEVEL_BITS)) - 1;
+
+    PUMP_INLINE static int32_t __first_bit(uint64_t bits) {
+#if defined(__GNUC__)
+        return __builtin_ctzll(bits);
+#else
+        int32_t index = 0;
+        while ((bits & 1) == 0) {
+            bits >>= 1;
+            index++;
+        }
+        return index;
+#endif
+    }
+
+    PUMP_INLINE static int32_t __level_shift(int32_t level) {
+        return TIMER_WHEEL_ROOT_BITS + (level - 1) * TIMER_WHEEL_LEVEL_BITS;
+    }
+
+    PUMP_INLINE static int32_t __level_slot(int32_t level, int32_t index) {
+        return TIMER_WHEEL_ROOT_SIZE + (level - 1) * TIMER_WHEEL_LEVEL_SIZE + index;
+    }
+
+    timer_wheel::timer_wheel(uint64_t now) noexcept
+      : current_(now),
+        count_(0),
+        free_nodes_(nullptr),
+        free_count_(0) {
+        for (int32_t i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+            slots_[i].prev = slots_[i].next = &slots_[i];
+        }
+        memset(root_bitmap_, 0, sizeof(root_bitmap_));
+    }
+
+    timer_wheel::~timer_wheel() {
+        for (int32_t i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+            while (slots_[i].next != &slots_[i]) {
+                auto node = (timer_wheel_node_ptr)slots_[i].next;
+                __unlink(node);
+                object_delete(node);
+            }
+        }
+        while (free_nodes_) {
+            auto node = free_nodes_;
+            free_nodes_ = (timer_wheel_node_ptr)node->next;
+            object_delete(node);
+        }
+    }
+
+    timer_wheel_node_ptr timer_wheel::add(const timer_sptr &timer, uint64_t expire) {
+        auto node = __new_node();
+        if (PUMP_UNLIKELY(!node)) {
+            return nullptr;
+        }
+        node->expire = expire;
+        node->timer = timer.get();
+        node->timer_ref = timer;
+        __link(node);
+        count_++;
+        return node;
+    }
+
+    void timer_wheel::remove(timer_wheel_node_ptr node) {
+        __unlink(node);
+        __free_node(node);
+        count_--;
+    }
+
+    void timer_wheel::advance(uint64_t now, std::vector<timer_wheel_node_ptr> &expired) {
+        while (current_ <= now) {
+            int32_t index = int32_t(current_ & TIMER_WHEEL_ROOT_MASK);
+
+            // Cascade timers of upper levels when root level turns around.
+            if (index == 0) {
+                for (int32_t level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+                    int32_t li = int32_t((current_ >> __level_shift(level)) & TIMER_WHEEL_LEVEL_MASK);
+                    __cascade(level, li);
+                    if (li != 0) {
+                        break;
+                    }
+                }
+            }
+
+            // Expire timers of current root slot.
+            timer_wheel_link *head = &slots_[index];
+            while (head->next != head) {
+                auto node = (timer_wheel_node_ptr)head->next;
+                __unlink(node);
+                expired.push_back(node);
+                count_--;
+            }
+
+            if (count_ == 0) {
+                current_ = now + 1;
+                break;
+            }
+
+            // Skip empty root slots until next expire slot or next cascading.
+            uint64_t next = (current_ | TIMER_WHEEL_ROOT_MASK) + 1;
+            for (int32_t i = (index + 1) / 64; i < TIMER_WHEEL_ROOT_SIZE / 64; i++) {
+                uint64_t bits = root_bitmap_[i];
+                if (i == (index + 1) / 64) {
+                    bits &= ~0ULL << ((index + 1) % 64);
+                }
+                if (bits != 0) {
+                    next = (current_ & ~TIMER_WHEEL_ROOT_MASK) + i * 64 + __first_bit(bits);
+                    break;
+                }
+            }
+            current_ = next <= now ? next : now + 1;
+        }
+    }
+
+    uint64_t timer_wheel::next_advance_time() const {
+        if (count_ == 0) {
+            return uint64_t(-1);
+        }
+
+        // Timers of upper levels are cascaded at the beginning of root level, and they
+        // maybe expire at current tick.
+        int32_t index = int32_t(current_ & TIMER_WHEEL_ROOT_MASK);
+        if (index == 0) {
+            return current_;
+        }
+
+        for (int32_t i = index / 64; i < TIMER_WHEEL_ROOT_SIZE / 64; i++) {
+            uint64_t bits = root_bitmap_[i];
+            if (i == index / 64) {
+                bits &= ~0ULL << (index % 64);
+            }
+            if (bits != 0) {
+                return (current_ & ~TIMER_WHEEL_ROOT_MASK) + i * 64 + __first_bit(bits);
+            }
+        }
+
+        return (current_ | TIMER_WHEEL_ROOT_MASK) + 1;
+    }
+
+    void timer_wheel::__link(timer_wheel_node_ptr node) {
+        uint64_t expire = node->expire < current_ ? current_ : node->expire;
+        uint64_t delta = expire - current_;
+
+        int32_t slot = 0;
+        if (delta < TIMER_WHEEL_ROOT_SIZE) {
+            slot = int32_t(expire & TIMER_WHEEL_ROOT_MASK);
+            root_bitmap_[slot / 64] |= 1ULL << (slot % 64);
+        } else {
+            // Timers out of wheel range are put in the last level, and they will be
+            // cascaded to the last level again until they are in range.
+            if (delta > TIMER_WHEEL_MAX_DELTA) {
+                expire = current_ + TIMER_WHEEL_MAX_DELTA;
+                delta = TIMER_WHEEL_MAX_DELTA;
+            }
+            int32_t level = 1;
+            while (level < TIMER_WHEEL_LEVELS - 1 && 
+                   delta >= (1ULL << __level_shift(level + 1))) {
+                level++;
+            }
+            slot = __level_slot(
+                level, int32_t((expire >> __level_shift(level)) & TIMER_WHEEL_LEVEL_MASK));
+        }
+
+        timer_wheel_link *head = &slots_[slot];
+        node->prev = head->prev;
+        node->next = head;
+        head->prev->next = node;
+        head->prev = node;
+    }
+
+    void timer_wheel::__unlink(timer_wheel_node_ptr node) {
+        timer_wheel_link *next = node->next;
+        node->prev->next = next;
+        next->prev = node->prev;
+
+        // Clear root slot bit if the slot becomes empty.
+        if (next == node->prev && next >= slots_ && next < slots_ + TIMER_WHEEL_ROOT_SIZE) {
+            int32_t slot = int32_t(next - slots_);
+            root_bitmap_[slot / 64] &= ~(1ULL << (slot % 64));
+        }
+    }
+
+    void timer_wheel::__cascade(int32_t level, int32_t index) {
+        timer_wheel_link *head = &slots_[__level_slot(level, index)];
+        if (head->next == head) {
+            return;
+        }
+
+        // Detach slot list at first, as timers maybe linked to the same slot again.
+        timer_wheel_link list;
+        list.next = head->next;
+        list.prev = head->prev;
+        list.next->prev = &list;
+        list.prev->next = &list;
+        head->prev = head->next = head;
+
+        while (list.next != &list) {
+            auto node = (timer_wheel_node_ptr)list.next;
+            list.next = node->next;
+            __link(node);
+        }
+    }
+
+    timer_wheel_node_ptr timer_wheel::__new_node() {
+        if (free_nodes_) {
+            auto node = free_nodes_;
+            free_nodes_ = (timer_wheel_node_ptr)node->next;
+            free_count_--;
+            return node;
+        }
+        return object_create<timer_wheel_node>();
+    }
+
+    void timer_wheel::__free_node(timer_wheel_node_ptr node) {
+        node->timer = nullptr;
+        node->timer_ref.reset();
+        if (free_count_ < TIMER_WHEEL_MAX_FREE_NODES) {
+            node->next = free_nodes_;
+            free_nodes_ = node;
+            free_count_++;
+        } else {
+            object_delete(node);
+        }
+    }
+
+}  // namespace time
+}  // namespace pump
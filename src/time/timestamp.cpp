@@ -17,9 +17,20 @@
 // Import strncmp function
 #include <string.h>
 
+#include <thread>
+
 #include "pump/config.h"
 #include "pump/time/timestamp.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define PUMP_HAVE_TSC
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PUMP_HAVE_TSC
+#endif
+
 namespace pump {
 namespace time {
 
@@ -29,7 +40,7 @@ namespace time {
 
     uint64_t get_clock_microseconds() {
         return std::chrono::time_point_cast<std::chrono::microseconds>(
-                   std::chrono::high_resolution_clock::now())
+                   std::chrono::steady_clock::now())
             .time_since_epoch()
             .count();
     }
@@ -41,6 +52,105 @@ namespace time {
             .count();
     }
 
+    // Cached clock of current thread, zero means the thread never updates it.
+    static thread_local uint64_t cached_clock_milliseconds = 0;
+
+    uint64_t update_cached_clock_milliseconds() {
+        cached_clock_milliseconds = get_clock_milliseconds();
+        return cached_clock_milliseconds;
+    }
+
+    uint64_t get_cached_clock_milliseconds() {
+        if (PUMP_LIKELY(cached_clock_milliseconds > 0)) {
+            return cached_clock_milliseconds;
+        }
+        return get_clock_milliseconds();
+    }
+
+    struct tsc_calibration {
+        // Invariant tsc supported status
+        bool supported;
+        // Tsc at calibration
+        uint64_t tsc_base;
+        // Steady clock nanoseconds at calibration
+        uint64_t ns_base;
+        // Nanoseconds per tsc tick
+        double ns_per_tick;
+    };
+
+    PUMP_INLINE static uint64_t __steady_clock_nanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+#if defined(PUMP_HAVE_TSC)
+    PUMP_INLINE static bool __has_invariant_tsc() {
+        // Invariant tsc is reported by cpuid leaf 0x80000007 edx bit 8.
+#if defined(__GNUC__)
+        uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007) {
+            return false;
+        }
+        __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        return (edx & (1 << 8)) != 0;
+#else
+        int32_t regs[4] = {0};
+        __cpuid(regs, 0x80000000);
+        if (uint32_t(regs[0]) < 0x80000007) {
+            return false;
+        }
+        __cpuid(regs, 0x80000007);
+        return (regs[3] & (1 << 8)) != 0;
+#endif
+    }
+#endif
+
+    static tsc_calibration __calibrate_tsc() {
+        tsc_calibration calibration;
+        calibration.supported = false;
+        calibration.tsc_base = 0;
+        calibration.ns_base = 0;
+        calibration.ns_per_tick = 1.0;
+#if defined(PUMP_HAVE_TSC)
+        if (__has_invariant_tsc()) {
+            uint64_t ns_beg = __steady_clock_nanoseconds();
+            uint64_t tsc_beg = __rdtsc();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            uint64_t ns_end = __steady_clock_nanoseconds();
+            uint64_t tsc_end = __rdtsc();
+            if (tsc_end > tsc_beg && ns_end > ns_beg) {
+                calibration.supported = true;
+                calibration.tsc_base = tsc_end;
+                calibration.ns_base = ns_end;
+                calibration.ns_per_tick = double(ns_end - ns_beg) / double(tsc_end - tsc_beg);
+            }
+        }
+#endif
+        return calibration;
+    }
+
+    PUMP_INLINE static const tsc_calibration& __get_tsc_calibration() {
+        static const tsc_calibration calibration = __calibrate_tsc();
+        return calibration;
+    }
+
+    uint64_t get_tsc_clock_nanoseconds() {
+        const tsc_calibration &calibration = __get_tsc_calibration();
+#if defined(PUMP_HAVE_TSC)
+        if (PUMP_LIKELY(calibration.supported)) {
+            // Tsc of other cores maybe a little behind the base.
+            int64_t ticks = int64_t(__rdtsc() - calibration.tsc_base);
+            return calibration.ns_base + int64_t(double(ticks) * calibration.ns_per_tick);
+        }
+#endif
+        return __steady_clock_nanoseconds();
+    }
+
+    bool is_tsc_clock_supported() {
+        return __get_tsc_calibration().supported;
+    }
+
     std::string timestamp::to_string() const {
         struct tm tm_time;
         char date[64] = {0};
@@ -14,31 +14,132 @@
  * limitations under the License.
  */
 
+#include "pump/memory.h"
 #include "pump/toolkit/spin_mutex.h"
 
 namespace pump {
 namespace toolkit {
 
     spin_mutex::spin_mutex(int32_t per_loop) noexcept
-      : per_loop_(per_loop), 
+      : per_loop_(per_loop),
         locked_(false) {
     }
 
-    void spin_mutex::lock() {
-        int32_t loop = 0;
-        bool exp = false;
+    void spin_mutex::__lock_slow() {
+        spin_backoff backoff(per_loop_);
+        do {
+            // Wait with loading, so that waiters do not bounce the cache line.
+            while (locked_.load(std::memory_order_relaxed)) {
+                backoff.pause();
+            }
+        } while (locked_.exchange(true, std::memory_order_acquire));
+    }
+
+    ticket_mutex::ticket_mutex(int32_t per_loop) noexcept
+      : per_loop_(per_loop),
+        next_(0),
+        serving_(0) {
+    }
+
+    void ticket_mutex::__lock_slow(uint32_t ticket) {
+        spin_backoff backoff(per_loop_);
+        while (serving_.load(std::memory_order_acquire) != ticket) {
+            backoff.pause();
+        }
+    }
+
+    /*********************************************************************************
+     * Mcs node cache
+     * Every thread reuses its own free nodes, and frees them when thread exits.
+     ********************************************************************************/
+    class mcs_node_cache {
+
+      public:
+        mcs_node_cache()
+          : free_(nullptr) {
+        }
+
+        ~mcs_node_cache() {
+            while (free_) {
+                mcs_mutex::mcs_node *node = free_;
+                free_ = node->free_next;
+                object_delete(node);
+            }
+        }
+
+        PUMP_INLINE mcs_mutex::mcs_node* acquire() {
+            mcs_mutex::mcs_node *node = free_;
+            if (PUMP_LIKELY(node != nullptr)) {
+                free_ = node->free_next;
+            } else {
+                node = object_create<mcs_mutex::mcs_node>();
+            }
+            node->next.store(nullptr, std::memory_order_relaxed);
+            node->locked.store(true, std::memory_order_relaxed);
+            return node;
+        }
+
+        PUMP_INLINE void release(mcs_mutex::mcs_node *node) {
+            node->free_next = free_;
+            free_ = node;
+        }
+
+      private:
+        mcs_mutex::mcs_node *free_;
+    };
+
+    static thread_local mcs_node_cache node_cache;
+
+    mcs_mutex::mcs_mutex(int32_t per_loop) noexcept
+      : per_loop_(per_loop),
+        tail_(nullptr),
+        owner_(nullptr) {
+    }
 
-        while (1) {
-            if (!locked_.compare_exchange_strong(exp, true)) {
-                break;
+    void mcs_mutex::lock() {
+        mcs_node *node = node_cache.acquire();
+        mcs_node *prev = tail_.exchange(node, std::memory_order_acq_rel);
+        if (prev != nullptr) {
+            prev->next.store(node, std::memory_order_release);
+            spin_backoff backoff(per_loop_);
+            while (node->locked.load(std::memory_order_acquire)) {
+                backoff.pause();
             }
+        }
+        owner_ = node;
+    }
 
-            if (loop++ > per_loop_) {
-                loop = 0;
-                pump_sched_yield();
+    bool mcs_mutex::try_lock() {
+        mcs_node *node = node_cache.acquire();
+        mcs_node *exp = nullptr;
+        if (tail_.compare_exchange_strong(
+                exp, node, std::memory_order_acquire, std::memory_order_relaxed)) {
+            owner_ = node;
+            return true;
+        }
+        node_cache.release(node);
+        return false;
+    }
+
+    void mcs_mutex::unlock() {
+        mcs_node *node = owner_;
+        mcs_node *next = node->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            mcs_node *exp = node;
+            if (tail_.compare_exchange_strong(
+                    exp, nullptr, std::memory_order_release, std::memory_order_relaxed)) {
+                node_cache.release(node);
+                return;
+            }
+            // Next waiter has queued up, but it has not linked to the node yet.
+            spin_backoff backoff(per_loop_);
+            while ((next = node->next.load(std::memory_order_acquire)) == nullptr) {
+                backoff.pause();
             }
         }
+        next->locked.store(false, std::memory_order_release);
+        node_cache.release(node);
     }
 
 }  // namespace toolkit
-}  // namespace pump
\ No newline at end of file
+}  // namespace pump
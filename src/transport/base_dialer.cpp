@@ -59,7 +59,7 @@ namespace transport {
         PUMP_ASSERT(!connect_timer_);
         connect_timer_ = time::timer::create(connect_timeout_, cb);
 
-        return get_service()->start_timer(connect_timer_);
+        return get_service()->start_timer(connect_timer_, SEND_POLLER);
     }
 
     void base_dialer::__stop_dial_timer() {
@@ -33,44 +33,6 @@ namespace flow {
         return FLOW_ERR_NO;
     }
 
-    int32_t flow_tcp::want_to_send(toolkit::io_buffer_ptr iob) {
-        PUMP_DEBUG_ASSIGN(iob, send_iob_, iob);
-        int32_t size = net::send(fd_, send_iob_->data(), send_iob_->data_size());
-        if (PUMP_LIKELY(size > 0)) {
-            if (PUMP_LIKELY(send_iob_->shift(size) == 0)) {
-                send_iob_ = nullptr;
-                return FLOW_ERR_NO;
-            }
-            return FLOW_ERR_AGAIN;
-        } else if (size < 0) {
-            return FLOW_ERR_AGAIN;
-        }
-
-        PUMP_DEBUG_LOG("flow_tcp: want to send failed %d", size);
-
-        return FLOW_ERR_ABORT;
-    }
-
-    int32_t flow_tcp::send() {
-        PUMP_ASSERT(send_iob_);
-        PUMP_ASSERT(send_iob_->data_size() > 0);
-        int32_t data_size = (int32_t)send_iob_->data_size();
-        int32_t size = net::send(fd_, send_iob_->data(), data_size);
-        if (PUMP_LIKELY(size > 0)) {
-            if (send_iob_->shift(size) == 0) {
-                send_iob_ = nullptr;
-                return FLOW_ERR_NO;
-            }
-            return FLOW_ERR_AGAIN;
-        } else if (size < 0) {
-            return FLOW_ERR_AGAIN;
-        }
-
-        PUMP_DEBUG_LOG("flow_tcp: send failed %d", size);
-
-        return FLOW_ERR_ABORT;
-    }
-
 }  // namespace flow
 }  // namespace transport
 }  // namespace pump
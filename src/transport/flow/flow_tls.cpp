@@ -15,6 +15,7 @@
  */
 
 #include "pump/transport/flow/flow_tls.h"
+#include "pump/time/timestamp.h"
 
 namespace pump {
 namespace transport {
@@ -22,8 +23,13 @@ namespace flow {
 
     flow_tls::flow_tls() noexcept
       : is_handshaked_(false),
+        ktls_state_(0),
         session_(nullptr),
-        send_iob_(nullptr){
+        send_iob_(nullptr),
+        record_size_(TLS_SMALL_RECORD_SIZE),
+        bulk_sent_size_(0),
+        last_send_time_(0),
+        session_saved_(false) {
     }
 
     flow_tls::~flow_tls() {
@@ -33,11 +39,16 @@ namespace flow {
     int32_t flow_tls::init(poll::channel_sptr &ch,
                            pump_socket fd,
                            void_ptr xcred,
-                           bool client) {
+                           bool client,
+                           bool memory_io) {
         PUMP_DEBUG_ASSIGN(ch, ch_, ch);
         PUMP_DEBUG_ASSIGN(fd > 0, fd_, fd);
 
-        session_ = ssl::create_tls_session(xcred, (int32_t)fd, client);
+        if (memory_io) {
+            session_ = ssl::create_tls_memory_session(xcred, client);
+        } else {
+            session_ = ssl::create_tls_session(xcred, (int32_t)fd, client);
+        }
         if (!session_) {
             return FLOW_ERR_ABORT;
         }
@@ -45,48 +56,206 @@ namespace flow {
         return FLOW_ERR_NO;
     }
 
+    void flow_tls::set_session_cache(ssl::tls_session_cache_sptr &cache,
+                                     const std::string &key) {
+        PUMP_ASSERT(session_ && !is_handshaked_);
+        session_cache_ = cache;
+        session_key_ = key;
+
+        std::string data;
+        if (session_cache_ && session_cache_->get(session_key_, data)) {
+            ssl::tls_set_session_data(session_, data);
+        }
+    }
+
     int32_t flow_tls::want_to_send(toolkit::io_buffer_ptr iob) {
         PUMP_DEBUG_ASSIGN(iob, send_iob_, iob);
-        int32_t size = ssl::tls_send(session_, send_iob_->buffer(), send_iob_->data_size());
-        if (PUMP_LIKELY(size > 0)) {
-            // Shift send buffer and check data size.
-            if (send_iob_->shift(size) > 0) {
-                return FLOW_ERR_AGAIN;
+        __update_record_size(iob->data_size());
+        return send();
+    }
+
+    int32_t flow_tls::send() {
+        PUMP_ASSERT(send_iob_);
+        if (ssl::tls_is_memory_session(session_)) {
+            return __memory_send();
+        }
+        while (true) {
+            int32_t size = (int32_t)send_iob_->data_size();
+            if (is_kernel_send_offloaded()) {
+                size = net::send(fd_, send_iob_->data(), size);
+            } else {
+                // Write one record at most every time. A retry after would block will
+                // use the same size, as record size only changes with new buffer.
+                if (size > record_size_) {
+                    size = record_size_;
+                }
+                size = ssl::tls_send(session_, send_iob_->data(), size);
             }
+            if (PUMP_LIKELY(size > 0)) {
+                // Shift send buffer and check data size.
+                if (send_iob_->shift(size) > 0) {
+                    continue;
+                }
 
-            send_iob_->reset();
+                send_iob_->reset();
 
-            return FLOW_ERR_NO;
-        } else if (PUMP_UNLIKELY(size < 0)) {
-            // Send again
-            return FLOW_ERR_AGAIN;
+                return FLOW_ERR_NO;
+            } else if (PUMP_UNLIKELY(size < 0)) {
+                // Send again
+                return FLOW_ERR_AGAIN;
+            }
+            break;
         }
 
-        PUMP_DEBUG_LOG("flow_tls: want to send failed");
+        PUMP_DEBUG_LOG("flow_tls: send failed");
 
         return FLOW_ERR_ABORT;
     }
 
-    int32_t flow_tls::send() {
-        PUMP_ASSERT(send_iob_);
-        int32_t size = ssl::tls_send(session_, send_iob_->buffer(), send_iob_->data_size());
+    void flow_tls::__on_handshaked() {
+        is_handshaked_ = true;
+        ktls_state_ = ssl::tls_kernel_offload_state(session_);
+        __save_session();
+    }
+
+    int32_t flow_tls::__memory_handshake() {
+        while (true) {
+            int32_t ret = ssl::TLS_HANDSHAKE_OK;
+            if (!is_handshaked_) {
+                ret = ssl::tls_handshake(session_);
+                if (ret == ssl::TLS_HANDSHAKE_ERROR) {
+                    return ret;
+                } else if (ret == ssl::TLS_HANDSHAKE_OK) {
+                    __on_handshaked();
+                }
+            }
+
+            // Send handshake data written by tls library.
+            int32_t err = __send_to_net();
+            if (err == FLOW_ERR_AGAIN) {
+                return ssl::TLS_HANDSHAKE_SEND;
+            } else if (err != FLOW_ERR_NO) {
+                return ssl::TLS_HANDSHAKE_ERROR;
+            }
+
+            if (ret == ssl::TLS_HANDSHAKE_OK) {
+                return ret;
+            }
+
+            // Read handshake data from socket for tls library.
+            int32_t size = __read_from_net();
+            if (size < 0) {
+                return ssl::TLS_HANDSHAKE_READ;
+            } else if (size == 0) {
+                return ssl::TLS_HANDSHAKE_ERROR;
+            }
+        }
+    }
+
+    int32_t flow_tls::__memory_read(block_t* b, int32_t size) {
+        // TLS library wants more data only after consuming all data of net read buffer.
+        while (true) {
+            int32_t ret = __read_from_net();
+            if (ret <= 0) {
+                return ret;
+            }
+            ret = ssl::tls_read(session_, b, size);
+            if (ret >= 0) {
+                return ret;
+            }
+        }
+    }
+
+    int32_t flow_tls::__memory_send() {
+        // Send ciphertext left last time at first.
+        int32_t err = __send_to_net();
+        if (err != FLOW_ERR_NO) {
+            return err;
+        }
+
+        toolkit::io_buffer_ptr net_iob = session_->net_send_iob;
+        while (send_iob_->data_size() > 0) {
+            int32_t size = (int32_t)send_iob_->data_size();
+            if (size > record_size_) {
+                size = record_size_;
+            }
+            // Writing to net send buffer never would block.
+            size = ssl::tls_send(session_, send_iob_->data(), size);
+            if (PUMP_UNLIKELY(size <= 0)) {
+                PUMP_DEBUG_LOG("flow_tls: memory send failed for tls send failed");
+                return FLOW_ERR_ABORT;
+            }
+            send_iob_->shift(size);
+
+            // Send ciphertext when net send buffer is full.
+            if (net_iob->data_size() >= (uint32_t)ssl::TLS_NET_BUFFER_SIZE) {
+                err = __send_to_net();
+                if (err != FLOW_ERR_NO) {
+                    return err;
+                }
+            }
+        }
+        send_iob_->reset();
+
+        return __send_to_net();
+    }
+
+    int32_t flow_tls::__read_from_net() {
+        toolkit::io_buffer_ptr iob = session_->net_read_iob;
+        // Move left data to the front, then read as much as the buffer can hold.
+        uint32_t data_size = iob->data_size();
+        if (data_size > 0 && iob->data() != iob->buffer()) {
+            memmove(iob->buffer(), iob->data(), data_size);
+        }
+        iob->reset_data_size(data_size);
+
+        int32_t size = net::read(
+            fd_, iob->buffer() + data_size, iob->buffer_size() - data_size);
         if (PUMP_LIKELY(size > 0)) {
-            // Shift send buffer and check data size.
-            if (send_iob_->shift(size) > 0) {
+            iob->add_data_size(size);
+        }
+        return size;
+    }
+
+    int32_t flow_tls::__send_to_net() {
+        toolkit::io_buffer_ptr iob = session_->net_send_iob;
+        while (iob->data_size() > 0) {
+            int32_t size = net::send(fd_, iob->data(), iob->data_size());
+            if (PUMP_LIKELY(size > 0)) {
+                iob->shift(size);
+            } else if (size < 0) {
                 return FLOW_ERR_AGAIN;
+            } else {
+                PUMP_DEBUG_LOG("flow_tls: send to net failed");
+                return FLOW_ERR_ABORT;
             }
+        }
+        iob->reset();
+        return FLOW_ERR_NO;
+    }
 
-            send_iob_->reset();
-
-            return FLOW_ERR_NO;
-        } else if (PUMP_UNLIKELY(size < 0)) {
-            // Send again
-            return FLOW_ERR_AGAIN;
+    void flow_tls::__update_record_size(int32_t size) {
+        uint64_t now = time::get_clock_milliseconds();
+        if (now > last_send_time_ + TLS_RECORD_IDLE_TIMEOUT) {
+            record_size_ = TLS_SMALL_RECORD_SIZE;
+            bulk_sent_size_ = 0;
         }
+        last_send_time_ = now;
 
-        PUMP_DEBUG_LOG("flow_tls: send failed");
+        if (record_size_ < TLS_MAX_RECORD_SIZE) {
+            bulk_sent_size_ += size;
+            if (bulk_sent_size_ >= TLS_BULK_SEND_SIZE) {
+                record_size_ = TLS_MAX_RECORD_SIZE;
+            }
+        }
+    }
 
-        return FLOW_ERR_ABORT;
+    void flow_tls::__save_session() {
+        std::string data;
+        if (session_cache_ && ssl::tls_get_session_data(session_, data)) {
+            session_cache_->put(session_key_, data);
+            session_saved_ = true;
+        }
     }
 
 }  // namespace flow
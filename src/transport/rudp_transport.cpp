@@ -0,0 +1,699 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pump/transport/rudp_transport.h"
+
+namespace pump {
+namespace transport {
+
+    /*********************************************************************************
+     * Rudp segment commands
+     ********************************************************************************/
+    const uint8_t RUDP_CMD_PUSH = 1;
+    const uint8_t RUDP_CMD_ACK = 2;
+    const uint8_t RUDP_CMD_WASK = 3;
+    const uint8_t RUDP_CMD_WINS = 4;
+
+    /*********************************************************************************
+     * Rudp segment header: cmd(1) wnd(2) ts(4) sn(4) una(4) len(2)
+     ********************************************************************************/
+    const int32_t RUDP_HEADER_SIZE = 17;
+
+    /*********************************************************************************
+     * Rudp timeouts in milliseconds
+     ********************************************************************************/
+    const int32_t RUDP_INIT_RTO = 200;
+    const int32_t RUDP_MAX_RTO = 60000;
+    const uint32_t RUDP_PROBE_INTERVAL = 500;
+
+    PUMP_INLINE static int32_t seq_diff(uint32_t a, uint32_t b) {
+        return (int32_t)(a - b);
+    }
+
+    PUMP_INLINE static block_t* encode16(block_t *p, uint16_t v) {
+        v = htons(v);
+        memcpy(p, &v, sizeof(v));
+        return p + sizeof(v);
+    }
+
+    PUMP_INLINE static block_t* encode32(block_t *p, uint32_t v) {
+        v = htonl(v);
+        memcpy(p, &v, sizeof(v));
+        return p + sizeof(v);
+    }
+
+    PUMP_INLINE static const block_t* decode16(const block_t *p, uint16_t *v) {
+        memcpy(v, p, sizeof(*v));
+        *v = ntohs(*v);
+        return p + sizeof(*v);
+    }
+
+    PUMP_INLINE static const block_t* decode32(const block_t *p, uint32_t *v) {
+        memcpy(v, p, sizeof(*v));
+        *v = ntohl(*v);
+        return p + sizeof(*v);
+    }
+
+    PUMP_INLINE static uint32_t now_milliseconds() {
+        return (uint32_t)time::get_cached_clock_milliseconds();
+    }
+
+    rudp_transport::rudp_transport(base_transport_sptr &datagram_transport,
+                                   const rudp_options &opts) noexcept
+      : base_transport(RUDP_TRANSPORT, nullptr, -1),
+        opts_(opts),
+        datagram_transport_(datagram_transport),
+        pacing_budget_(opts.pacing),
+        snd_una_(0),
+        snd_nxt_(0),
+        rmt_wnd_(opts.recv_window),
+        rcv_nxt_(0),
+        ask_wnd_(false),
+        tell_wnd_(false),
+        probe_ts_(0),
+        srtt_(0),
+        rttval_(0),
+        rto_(RUDP_INIT_RTO),
+        output_size_(0) {
+        if (opts_.mtu > MAX_UDP_BUFFER_SIZE) {
+            opts_.mtu = MAX_UDP_BUFFER_SIZE;
+        } else if (opts_.mtu <= RUDP_HEADER_SIZE) {
+            opts_.mtu = RUDP_HEADER_SIZE + 1;
+        }
+        if (opts_.send_window <= 0) {
+            opts_.send_window = 1;
+        }
+        if (opts_.recv_window <= 0 || opts_.recv_window > 0xffff) {
+            opts_.recv_window = rudp_options().recv_window;
+        }
+        if (opts_.interval <= 0) {
+            opts_.interval = 1;
+        }
+        mss_ = opts_.mtu - RUDP_HEADER_SIZE;
+        output_ = (block_t*)pump_malloc(opts_.mtu);
+        if (datagram_transport) {
+            local_address_ = datagram_transport->get_local_address();
+            remote_address_ = datagram_transport->get_remote_address();
+        }
+    }
+
+    rudp_transport::~rudp_transport() {
+        if (update_timer_) {
+            update_timer_->stop();
+        }
+        __clear_segments();
+        pump_free(output_);
+    }
+
+    int32_t rudp_transport::start(service_ptr sv, const transport_callbacks &cbs) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
+        if (!sv) {
+            PUMP_ERR_LOG("rudp_transport: start failed with invalid service");
+            return ERROR_INVALID;
+        }
+
+        if (!datagram_transport_ || !output_) {
+            PUMP_ERR_LOG("rudp_transport: start failed with invalid datagram transport");
+            return ERROR_INVALID;
+        }
+
+        if (!cbs.read_cb || !cbs.disconnected_cb || !cbs.stopped_cb) {
+            PUMP_ERR_LOG("rudp_transport: start failed with invalid callbacks");
+            return ERROR_INVALID;
+        }
+
+        if (!__set_state(TRANSPORT_INITED, TRANSPORT_STARTING)) {
+            PUMP_ERR_LOG("rudp_transport: start failed with wrong status");
+            return ERROR_INVALID;
+        }
+
+        // Set callbacks
+        cbs_ = cbs;
+
+        // Set service
+        __set_service(sv);
+
+        toolkit::defer cleanup([&]() {
+            if (update_timer_) {
+                update_timer_->stop();
+            }
+            datagram_transport_->stop();
+            __set_state(TRANSPORT_STARTING, TRANSPORT_ERROR);
+        });
+
+        rudp_transport_wptr wptr = 
+            std::static_pointer_cast<rudp_transport>(shared_from_this());
+
+        transport_callbacks dcbs;
+        dcbs.read_cb = pump_bind(&rudp_transport::on_datagram, wptr, _1, _2);
+        dcbs.disconnected_cb = pump_bind(&rudp_transport::on_datagram_disconnected, wptr);
+        dcbs.stopped_cb = pump_bind(&rudp_transport::on_datagram_stopped, wptr);
+        if (datagram_transport_->start(sv, dcbs) != ERROR_OK) {
+            PUMP_ERR_LOG("rudp_transport: start failed for starting datagram transport failed");
+            return ERROR_FAULT;
+        }
+
+        if (datagram_transport_->read_for_loop() != ERROR_OK) {
+            PUMP_ERR_LOG("rudp_transport: start failed for reading datagram transport failed");
+            return ERROR_FAULT;
+        }
+
+        time::timer_callback cb = pump_bind(&rudp_transport::on_update, wptr);
+        update_timer_ = time::timer::create(opts_.interval, cb, true);
+        if (!sv->start_timer(update_timer_, READ_POLLER)) {
+            PUMP_ERR_LOG("rudp_transport: start failed for starting update timer failed");
+            return ERROR_FAULT;
+        }
+
+        __set_state(TRANSPORT_STARTING, TRANSPORT_STARTED);
+
+        cleanup.clear();
+
+        return ERROR_OK;
+    }
+
+    void rudp_transport::stop() {
+        while (__is_state(TRANSPORT_STARTED)) {
+            // Stopped callback will be triggered when datagram transport stopped.
+            if (__set_state(TRANSPORT_STARTED, TRANSPORT_STOPPING)) {
+                update_timer_->stop();
+                datagram_transport_->stop();
+                return;
+            }
+        }
+
+        // If in disconnecting status at the moment, it means transport is
+        // disconnected but hasn't triggered disconnected callback yet. So we just
+        // set stopping status, and stopped callback will be triggered instead.
+        if (__set_state(TRANSPORT_DISCONNECTING, TRANSPORT_STOPPING)) {
+            return;
+        }
+    }
+
+    int32_t rudp_transport::read_for_once() {
+        while (__is_state(TRANSPORT_STARTED)) {
+            int32_t current_state = __change_read_state(READ_ONCE);
+            if (current_state == READ_INVALID) {
+                continue;
+            }
+            // Received data may be waiting for reading.
+            if (current_state == READ_NONE) {
+                __post_channel_event(shared_from_this(), 0);
+            }
+            return ERROR_OK;
+        }
+        return ERROR_UNSTART;
+    }
+
+    int32_t rudp_transport::read_for_loop() {
+        while (__is_state(TRANSPORT_STARTED)) {
+            int32_t current_state = __change_read_state(READ_LOOP);
+            if (current_state == READ_INVALID) {
+                continue;
+            }
+            // Received data may be waiting for reading.
+            if (current_state == READ_NONE) {
+                __post_channel_event(shared_from_this(), 0);
+            }
+            return ERROR_OK;
+        }
+        return ERROR_UNSTART;
+    }
+
+    int32_t rudp_transport::send(const block_t *b, int32_t size) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
+        if (!b || size == 0) {
+            PUMP_WARN_LOG("rudp_transport: send failed with invalid buffer");
+            return ERROR_INVALID;
+        }
+
+        if (PUMP_UNLIKELY(!__is_state(TRANSPORT_STARTED))) {
+            PUMP_WARN_LOG("rudp_transport: send failed for transport not started");
+            return ERROR_UNSTART;
+        }
+
+        // Create all segments before queuing, so data is never queued partially.
+        std::vector<segment*> segs;
+        segs.reserve((size + mss_ - 1) / mss_);
+        for (int32_t offset = 0; offset < size; offset += mss_) {
+            int32_t len = size - offset < mss_ ? size - offset : mss_;
+            segment *seg = __create_segment(b + offset, len);
+            if (PUMP_UNLIKELY(seg == nullptr)) {
+                PUMP_WARN_LOG("rudp_transport: send failed for creating segment failed");
+                for (auto created : segs) {
+                    __destroy_segment(created);
+                }
+                return ERROR_FAULT;
+            }
+            segs.push_back(seg);
+        }
+
+        bool alive = true;
+        {
+            std::lock_guard<std::mutex> lock(mx_);
+            snd_queue_.insert(snd_queue_.end(), segs.begin(), segs.end());
+            pending_send_size_.fetch_add(size, std::memory_order_relaxed);
+            alive = __flush(now_milliseconds());
+        }
+
+        if (!alive) {
+            __try_doing_disconnected_process();
+        }
+
+        return ERROR_OK;
+    }
+
+    int32_t rudp_transport::send(toolkit::io_buffer_ptr iob) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
+        if (!iob || iob->data_size() == 0) {
+            PUMP_WARN_LOG("rudp_transport: send failed with invalid io buffer");
+            return ERROR_INVALID;
+        }
+
+        int32_t ec = send(iob->data(), iob->data_size());
+        if (ec == ERROR_OK) {
+            iob->sub_ref();
+        }
+
+        return ec;
+    }
+
+    void rudp_transport::on_channel_event(int32_t ev) {
+        __deliver();
+    }
+
+    void rudp_transport::on_datagram(rudp_transport_wptr wptr, 
+                                     const block_t *b, 
+                                     int32_t size) {
+        PUMP_LOCK_WPOINTER(transport, wptr);
+        if (transport == nullptr || !transport->is_started()) {
+            return;
+        }
+
+        bool alive = true;
+        {
+            std::lock_guard<std::mutex> lock(transport->mx_);
+            uint32_t now = now_milliseconds();
+            if (!transport->__input(b, size, now)) {
+                PUMP_DEBUG_LOG("rudp_transport: handle datagram failed for invalid segment");
+            }
+            // Acks are sent as soon as possible to keep retransmit timely.
+            alive = transport->__flush(now);
+        }
+
+        if (!alive) {
+            transport->__try_doing_disconnected_process();
+            return;
+        }
+
+        transport->__deliver();
+    }
+
+    void rudp_transport::on_datagram_disconnected(rudp_transport_wptr wptr) {
+        PUMP_LOCK_WPOINTER(transport, wptr);
+        if (transport == nullptr) {
+            return;
+        }
+
+        transport->__set_state(TRANSPORT_STARTED, TRANSPORT_DISCONNECTING);
+        transport->__interrupt_and_trigger_callbacks();
+    }
+
+    void rudp_transport::on_datagram_stopped(rudp_transport_wptr wptr) {
+        PUMP_LOCK_WPOINTER(transport, wptr);
+        if (transport == nullptr) {
+            return;
+        }
+
+        transport->__interrupt_and_trigger_callbacks();
+    }
+
+    void rudp_transport::on_update(rudp_transport_wptr wptr) {
+        PUMP_LOCK_WPOINTER(transport, wptr);
+        if (transport == nullptr || !transport->is_started()) {
+            return;
+        }
+
+        bool alive = true;
+        {
+            std::lock_guard<std::mutex> lock(transport->mx_);
+            // Start a new pacing interval.
+            transport->pacing_budget_ = transport->opts_.pacing;
+            alive = transport->__flush(now_milliseconds());
+        }
+
+        if (!alive) {
+            PUMP_DEBUG_LOG("rudp_transport: handle update failed for dead link");
+            transport->__try_doing_disconnected_process();
+        }
+    }
+
+    void rudp_transport::__close_transport_flow() {
+        if (update_timer_) {
+            update_timer_->stop();
+        }
+    }
+
+    bool rudp_transport::__input(const block_t *b, int32_t size, uint32_t now) {
+        bool has_ack = false;
+        uint32_t max_ack = 0;
+        uint32_t max_ack_ts = 0;
+
+        while (size >= RUDP_HEADER_SIZE) {
+            uint8_t cmd = (uint8_t)b[0];
+            uint16_t wnd = 0, len = 0;
+            uint32_t ts = 0, sn = 0, una = 0;
+            const block_t *p = decode16(b + 1, &wnd);
+            p = decode32(p, &ts);
+            p = decode32(p, &sn);
+            p = decode32(p, &una);
+            p = decode16(p, &len);
+            size -= RUDP_HEADER_SIZE;
+            b = p;
+
+            if (size < len || cmd < RUDP_CMD_PUSH || cmd > RUDP_CMD_WINS) {
+                return false;
+            }
+
+            rmt_wnd_ = wnd;
+
+            // Remove segments acknowledged by una.
+            while (!snd_buf_.empty() && seq_diff(snd_buf_.front()->sn, una) < 0) {
+                pending_send_size_.fetch_sub(snd_buf_.front()->len, std::memory_order_relaxed);
+                __destroy_segment(snd_buf_.front());
+                snd_buf_.pop_front();
+            }
+
+            if (cmd == RUDP_CMD_ACK) {
+                if (seq_diff(now, ts) >= 0) {
+                    __update_rtt(seq_diff(now, ts));
+                }
+                for (auto it = snd_buf_.begin(); it != snd_buf_.end(); ++it) {
+                    if ((*it)->sn == sn) {
+                        pending_send_size_.fetch_sub((*it)->len, std::memory_order_relaxed);
+                        __destroy_segment(*it);
+                        snd_buf_.erase(it);
+                        break;
+                    } else if (seq_diff(sn, (*it)->sn) < 0) {
+                        break;
+                    }
+                }
+                if (!has_ack || seq_diff(sn, max_ack) > 0) {
+                    has_ack = true;
+                    max_ack = sn;
+                    max_ack_ts = ts;
+                }
+            } else if (cmd == RUDP_CMD_PUSH) {
+                if (seq_diff(sn, rcv_nxt_ + opts_.recv_window) < 0) {
+                    acks_.push_back(std::make_pair(sn, ts));
+                    if (seq_diff(sn, rcv_nxt_) >= 0 && rcv_buf_.count(sn) == 0) {
+                        segment *seg = __create_segment(b, len);
+                        if (PUMP_LIKELY(seg != nullptr)) {
+                            seg->sn = sn;
+                            rcv_buf_[sn] = seg;
+                        }
+                    }
+                }
+            } else if (cmd == RUDP_CMD_WASK) {
+                tell_wnd_ = true;
+            }
+
+            b += len;
+            size -= len;
+        }
+
+        // Segments before the max acked one are skipped by the remote peer, but only
+        // if their last transmission is not later than the acked one.
+        if (has_ack) {
+            for (auto seg : snd_buf_) {
+                if (seq_diff(seg->sn, max_ack) >= 0) {
+                    break;
+                }
+                if (seq_diff(max_ack_ts, seg->ts) >= 0) {
+                    seg->fastack++;
+                }
+            }
+        }
+
+        snd_una_ = snd_buf_.empty() ? snd_nxt_ : snd_buf_.front()->sn;
+
+        // Move continuous segments to receive queue.
+        while ((int32_t)rcv_queue_.size() < opts_.recv_window) {
+            auto it = rcv_buf_.find(rcv_nxt_);
+            if (it == rcv_buf_.end()) {
+                break;
+            }
+            rcv_queue_.push_back(it->second);
+            rcv_buf_.erase(it);
+            rcv_nxt_++;
+        }
+
+        return size == 0;
+    }
+
+    bool rudp_transport::__flush(uint32_t now) {
+        // Send acks.
+        for (auto &ack : acks_) {
+            __output_segment(RUDP_CMD_ACK, ack.first, ack.second, nullptr, 0);
+        }
+        acks_.clear();
+
+        // Probe remote window if it is zero.
+        if (rmt_wnd_ == 0) {
+            if (probe_ts_ == 0) {
+                probe_ts_ = now + RUDP_PROBE_INTERVAL;
+            } else if (seq_diff(now, probe_ts_) >= 0) {
+                probe_ts_ = now + RUDP_PROBE_INTERVAL;
+                ask_wnd_ = true;
+            }
+        } else {
+            probe_ts_ = 0;
+        }
+        if (ask_wnd_) {
+            __output_segment(RUDP_CMD_WASK, 0, now, nullptr, 0);
+            ask_wnd_ = false;
+        }
+        if (tell_wnd_) {
+            __output_segment(RUDP_CMD_WINS, 0, now, nullptr, 0);
+            tell_wnd_ = false;
+        }
+
+        // Move segments from send queue to send buffer in window.
+        int32_t cwnd = opts_.send_window < rmt_wnd_ ? opts_.send_window : rmt_wnd_;
+        while (!snd_queue_.empty() && seq_diff(snd_nxt_, snd_una_ + cwnd) < 0) {
+            segment *seg = snd_queue_.front();
+            snd_queue_.pop_front();
+            seg->sn = snd_nxt_++;
+            seg->xmit = 0;
+            seg->fastack = 0;
+            snd_buf_.push_back(seg);
+        }
+
+        // Transmit new, timeouted and fast retransmitting segments.
+        // Segments sent by sending and input in an update interval share the pacing
+        // budget, which is reset only by update timer.
+        bool alive = true;
+        bool pacing = opts_.pacing > 0;
+        for (auto seg : snd_buf_) {
+            bool first = seg->xmit == 0;
+            bool timeout = !first && seq_diff(now, seg->resendts) >= 0;
+            bool fast = !first && opts_.fast_resend > 0 && seg->fastack >= opts_.fast_resend;
+            if (!first && !timeout && !fast) {
+                continue;
+            }
+            if (pacing && pacing_budget_ <= 0) {
+                break;
+            }
+
+            if (first) {
+                seg->rto = rto_;
+            } else if (timeout) {
+                seg->rto += (seg->rto > (uint32_t)rto_ ? seg->rto : rto_) / 2;
+                if (seg->rto > (uint32_t)RUDP_MAX_RTO) {
+                    seg->rto = RUDP_MAX_RTO;
+                }
+            }
+            seg->resendts = now + seg->rto;
+            seg->fastack = 0;
+            seg->ts = now;
+            seg->xmit++;
+
+            __output_segment(RUDP_CMD_PUSH, seg->sn, seg->ts, seg->data(), seg->len);
+
+            if (pacing) {
+                pacing_budget_--;
+            }
+            if (opts_.dead_link > 0 && seg->xmit >= opts_.dead_link) {
+                alive = false;
+            }
+        }
+
+        __output_flush();
+
+        return alive;
+    }
+
+    void rudp_transport::__output_segment(uint8_t cmd, 
+                                          uint32_t sn, 
+                                          uint32_t ts,
+                                          const block_t *data, 
+                                          int32_t len) {
+        if (output_size_ + RUDP_HEADER_SIZE + len > opts_.mtu) {
+            __output_flush();
+        }
+
+        block_t *p = output_ + output_size_;
+        *(p++) = (block_t)cmd;
+        p = encode16(p, (uint16_t)__recv_window_unused());
+        p = encode32(p, ts);
+        p = encode32(p, sn);
+        p = encode32(p, rcv_nxt_);
+        p = encode16(p, (uint16_t)len);
+        if (len > 0) {
+            memcpy(p, data, len);
+        }
+        output_size_ += RUDP_HEADER_SIZE + len;
+    }
+
+    void rudp_transport::__output_flush() {
+        if (output_size_ > 0) {
+            if (datagram_transport_->send(output_, output_size_) != ERROR_OK) {
+                PUMP_DEBUG_LOG("rudp_transport: output flush failed for datagram send failed");
+            }
+            output_size_ = 0;
+        }
+    }
+
+    void rudp_transport::__update_rtt(int32_t rtt) {
+        if (srtt_ == 0) {
+            srtt_ = rtt > 0 ? rtt : 1;
+            rttval_ = rtt / 2;
+        } else {
+            int32_t delta = rtt > srtt_ ? rtt - srtt_ : srtt_ - rtt;
+            rttval_ = (3 * rttval_ + delta) / 4;
+            srtt_ = (7 * srtt_ + rtt) / 8;
+            if (srtt_ < 1) {
+                srtt_ = 1;
+            }
+        }
+
+        int32_t rto = srtt_ + (opts_.interval > 4 * rttval_ ? opts_.interval : 4 * rttval_);
+        if (rto < opts_.min_rto) {
+            rto = opts_.min_rto;
+        } else if (rto > RUDP_MAX_RTO) {
+            rto = RUDP_MAX_RTO;
+        }
+        rto_ = rto;
+    }
+
+    void rudp_transport::__deliver() {
+        std::lock_guard<std::mutex> deliver_lock(deliver_mx_);
+        while (__is_state(TRANSPORT_STARTED)) {
+            segment *seg = nullptr;
+            int32_t last_state = READ_ONCE;
+            {
+                std::lock_guard<std::mutex> lock(mx_);
+                if (rcv_queue_.empty()) {
+                    break;
+                }
+
+                // If read state is READ_ONCE, change it to READ_PENDING.
+                // If read state is READ_LOOP, last state will be seted to READ_LOOP.
+                // Otherwise transport is not reading and data is kept in the queue.
+                if (!read_state_.compare_exchange_strong(last_state, READ_PENDING) &&
+                    last_state != READ_LOOP) {
+                    break;
+                }
+
+                // Tell remote peer when receive window is reopened.
+                if ((int32_t)rcv_queue_.size() >= opts_.recv_window) {
+                    tell_wnd_ = true;
+                }
+
+                seg = rcv_queue_.front();
+                rcv_queue_.pop_front();
+
+                // Move continuous segments to receive queue.
+                auto it = rcv_buf_.find(rcv_nxt_);
+                if (it != rcv_buf_.end()) {
+                    rcv_queue_.push_back(it->second);
+                    rcv_buf_.erase(it);
+                    rcv_nxt_++;
+                }
+            }
+
+            cbs_.read_cb(seg->data(), seg->len);
+            __destroy_segment(seg);
+
+            // If last read state is READ_ONCE, try to change read state to READ_NONE.
+            if (last_state == READ_ONCE) {
+                last_state = READ_PENDING;
+                read_state_.compare_exchange_strong(last_state, READ_NONE);
+                break;
+            }
+        }
+    }
+
+    void rudp_transport::__try_doing_disconnected_process() {
+        // Disconnected callback will be triggered when datagram transport stopped.
+        if (__set_state(TRANSPORT_STARTED, TRANSPORT_DISCONNECTING)) {
+            update_timer_->stop();
+            datagram_transport_->stop();
+        }
+    }
+
+    rudp_transport::segment* rudp_transport::__create_segment(const block_t *b, 
+                                                              int32_t size) {
+        segment *seg = (segment*)pump_malloc(sizeof(segment) + size);
+        if (PUMP_UNLIKELY(seg == nullptr)) {
+            return nullptr;
+        }
+        memset(seg, 0, sizeof(segment));
+        seg->len = size;
+        if (size > 0) {
+            memcpy(seg->data(), b, size);
+        }
+        return seg;
+    }
+
+    void rudp_transport::__destroy_segment(segment *seg) {
+        pump_free(seg);
+    }
+
+    void rudp_transport::__clear_segments() {
+        for (auto seg : snd_queue_) {
+            __destroy_segment(seg);
+        }
+        snd_queue_.clear();
+        for (auto seg : snd_buf_) {
+            __destroy_segment(seg);
+        }
+        snd_buf_.clear();
+        for (auto &item : rcv_buf_) {
+            __destroy_segment(item.second);
+        }
+        rcv_buf_.clear();
+        for (auto seg : rcv_queue_) {
+            __destroy_segment(seg);
+        }
+        rcv_queue_.clear();
+    }
+
+}  // namespace transport
+}  // namespace pump
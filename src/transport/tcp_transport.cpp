@@ -24,7 +24,7 @@ namespace transport {
         last_send_iob_size_(0),
         last_send_iob_(nullptr),
         pending_send_cnt_(0),
-        sendlist_(32) {
+        sendlist_(8) {
     }
 
     tcp_transport::~tcp_transport() {
@@ -44,7 +44,9 @@ namespace transport {
     }
 
     int32_t tcp_transport::start(service_ptr sv, const transport_callbacks &cbs) {
-        if (flow_) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
+        if (flow_.is_valid()) {
             PUMP_ERR_LOG("tcp_transport: start failed for started");
             return ERROR_INVALID;
         }
@@ -149,6 +151,8 @@ namespace transport {
     }
 
     int32_t tcp_transport::send(const block_t *b, int32_t size) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
         if (!b || size == 0) {
             PUMP_WARN_LOG("tcp_transport: send failed with invalid buffer");
             return ERROR_INVALID;
@@ -190,6 +194,8 @@ namespace transport {
     }
 
     int32_t tcp_transport::send(toolkit::io_buffer_ptr iob) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
         if (!iob || iob->data_size() == 0) {
             PUMP_WARN_LOG("tcp_transport: send failed with invalid io buffer");
             return ERROR_INVALID;
@@ -222,8 +228,10 @@ namespace transport {
     }
 
     void tcp_transport::on_read_event() {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
         block_t b[MAX_TCP_BUFFER_SIZE];
-        int32_t size = flow_->read(b, sizeof(b));
+        int32_t size = flow_.read(b, sizeof(b));
         if (PUMP_LIKELY(size != 0)) {
             // If read state is READ_ONCE, change it to READ_PENDING.
             // If read state is READ_LOOP, last state will be seted to READ_LOOP.
@@ -252,11 +260,13 @@ namespace transport {
     }
 
     void tcp_transport::on_send_event() {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
         int32_t ret;
 
         // Continue to send last buffer.
         if (PUMP_LIKELY(last_send_iob_ != nullptr)) {
-            ret = flow_->send();
+            ret = flow_.send();
             if (ret == flow::FLOW_ERR_NO) {
                 // Reset last sent buffer.
                 __reset_last_sent_iobuffer();
@@ -297,9 +307,8 @@ namespace transport {
 
     bool tcp_transport::__open_transport_flow() {
         // Init tcp transport flow.
-        PUMP_ASSERT(!flow_);
-        flow_.reset(object_create<flow::flow_tcp>(), object_delete<flow::flow_tcp>);
-        if (flow_->init(shared_from_this(), get_fd()) != flow::FLOW_ERR_NO) {
+        PUMP_ASSERT(!flow_.is_valid());
+        if (flow_.init(shared_from_this(), get_fd()) != flow::FLOW_ERR_NO) {
             PUMP_ERR_LOG("tcp_transport: open transport flow failed for flow init failed");
             return false;
         }
@@ -360,7 +369,7 @@ namespace transport {
         last_send_iob_size_ = last_send_iob_->data_size();
 
         // Try to send the buffer.
-        auto ret = flow_->want_to_send(last_send_iob_);
+        auto ret = flow_.want_to_send(last_send_iob_);
         if (PUMP_LIKELY(ret == flow::FLOW_ERR_NO)) {
             // Reset last sent buffer.
             __reset_last_sent_iobuffer();
@@ -27,7 +27,8 @@ namespace transport {
       : base_acceptor(TLS_ACCEPTOR, listen_address), 
         xcred_(xcred), 
         xcred_owner_(xcred_owner) ,
-        handshake_timeout_(handshake_timeout) {
+        handshake_timeout_(handshake_timeout),
+        memory_io_(false) {
     }
 
     tls_acceptor::~tls_acceptor() {
@@ -109,7 +110,7 @@ namespace transport {
                 // If handshaker is started error, handshaked callback will be
                 // triggered. So we do nothing at here when started error. But if
                 // acceptor stopped befere here, we shuold stop handshaking.
-                handshaker->init(fd, false, xcred_, local_address, remote_address);
+                handshaker->init(fd, false, xcred_, local_address, remote_address, memory_io_);
                 if (handshaker->start(get_service(), handshake_timeout_, handshaker_cbs)) {
                     if (!__is_state(TRANSPORT_STARTING) &&
                         !__is_state(TRANSPORT_STARTED)) {
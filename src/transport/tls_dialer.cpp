@@ -28,7 +28,9 @@ namespace transport {
       : base_dialer(TLS_DIALER, local_address, remote_address, dial_timeout),
         xcred_(xcred),
         xcred_owner_(false),
-        handshake_timeout_(handshake_timeout) {
+        session_cache_(),
+        handshake_timeout_(handshake_timeout),
+        memory_io_(false) {
         if (!xcred_) {
             xcred_owner_ = true;
             xcred_ = ssl::create_tls_client_certificate();
@@ -148,7 +150,12 @@ namespace transport {
             // here, we shuold stop handshaking.
             handshaker_.reset(object_create<tls_handshaker>(),
                               object_delete<tls_handshaker>);
-            handshaker_->init(flow->unbind(), true, xcred_, local_address, remote_address);
+            handshaker_->init(
+                flow->unbind(), true, xcred_, local_address, remote_address, memory_io_);
+            if (session_cache_) {
+                handshaker_->set_session_cache(session_cache_, 
+                                               __get_session_key(remote_address));
+            }
 
             tls_handshaker::tls_handshaker_callbacks tls_cbs;
             tls_cbs.handshaked_cb =
@@ -248,6 +255,16 @@ namespace transport {
         return true;
     }
 
+    std::string tls_dialer::__get_session_key(const address &remote_address) const {
+        // Credentials created by dialer are all the same default client credentials,
+        // other credentials are identified by their address.
+        char cred_id[32] = "default";
+        if (!xcred_owner_) {
+            snprintf(cred_id, sizeof(cred_id), "%p", xcred_);
+        }
+        return std::string(cred_id) + "/" + server_name_ + "/" + remote_address.to_string();
+    }
+
     base_transport_sptr tls_sync_dialer::dial(service_ptr sv,
                                               const address &local_address,
                                               const address &remote_address,
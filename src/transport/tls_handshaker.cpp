@@ -24,23 +24,28 @@ namespace transport {
     const int32_t TLS_HANDSHAKE_ERROR = 2;
 
     tls_handshaker::tls_handshaker() noexcept
-      : base_channel(TLS_HANDSHAKER, nullptr, -1) {
+      : base_channel(TLS_HANDSHAKER, nullptr, -1),
+        handshaking_(false) {
+        flag_.clear();
     }
 
     void tls_handshaker::init(pump_socket fd,
                               bool client,
                               void_ptr xcred,
                               const address &local_address,
-                              const address &remote_address) {
+                              const address &remote_address,
+                              bool memory_io) {
         local_address_ = local_address;
         remote_address_ = remote_address;
 
-        PUMP_DEBUG_CHECK(__open_flow(fd, xcred, client));
+        PUMP_DEBUG_CHECK(__open_flow(fd, xcred, client, memory_io));
     }
 
     bool tls_handshaker::start(service_ptr sv,
                                int64_t timeout,
                                const tls_handshaker_callbacks &cbs) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TLS);
+
         if (!flow_) {
             PUMP_ERR_LOG("tls_handshaker: start failed with invalid flow");
             return false;
@@ -93,7 +98,9 @@ namespace transport {
 
         // If this is server side, we will start to read handshake data.
         // If this is client side, there is handshake data to send at first time.
-        if (ret == ssl::TLS_HANDSHAKE_SEND) {
+        // If handshake is finished at once, send event will be triggered at once
+        // and finish handshaking.
+        if (ret == ssl::TLS_HANDSHAKE_SEND || ret == ssl::TLS_HANDSHAKE_OK) {
             //if (flow_->want_to_send() != flow::FLOW_ERR_NO) {
             //    PUMP_WARN_LOG("tls_handshaker: start failed for flow want to send failed");
             //    return false;
@@ -102,13 +109,17 @@ namespace transport {
         } else {
             tracker_->set_expected_event(poll::TRACK_READ);
         }
+
+        // Tracker event maybe triggered before adding tracker returns, so handshaker
+        // must be started before adding tracker.
+        __set_state(TRANSPORT_STARTING, TRANSPORT_STARTED);
+
         if (!get_service()->add_channel_tracker(tracker_, SEND_POLLER)) {
             PUMP_WARN_LOG("tls_handshaker: start failed for adding tracker failed");
+            __set_state(TRANSPORT_STARTED, TRANSPORT_STARTING);
             return false;
         }
 
-        __set_state(TRANSPORT_STARTING, TRANSPORT_STARTED);
-
         cleanup.clear();
 
         return true;
@@ -116,7 +127,11 @@ namespace transport {
 
     void tls_handshaker::stop() {
         if (__set_state(TRANSPORT_STARTED, TRANSPORT_STOPPING)) {
-            __close_flow();
+            // Flow is in use by crypto worker, it will be closed on the poller when
+            // handshake step result is handled.
+            if (!handshaking_.load()) {
+                __close_flow();
+            }
             return;
         }
 
@@ -127,29 +142,67 @@ namespace transport {
     }
 
     void tls_handshaker::on_read_event() {
-        __process_handshake();
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TLS);
+        __handshake_step();
     }
 
     void tls_handshaker::on_send_event() {
-        __process_handshake();
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TLS);
+        __handshake_step();
+    }
+
+    void tls_handshaker::on_channel_event(int32_t ev) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TLS);
+
+        handshaking_.store(false);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // Handshaker is stopped or timeout while handshake step is running on crypto
+        // worker, so finish it and close the flow now.
+        if (!__is_state(TRANSPORT_STARTED)) {
+            __handshake_finished();
+            return;
+        }
+
+        __process_handshake(ev);
+    }
+
+    void tls_handshaker::on_handshake_task(tls_handshaker_wptr wptr) {
+        PUMP_LOCK_WPOINTER(handshaker, wptr);
+        if (handshaker) {
+            PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TLS);
+            // Only tls handshake step runs on crypto worker, the result is handled on
+            // the poller.
+            int32_t ret = handshaker->flow_->handshake();
+            if (!handshaker->get_service()->post_channel_event(
+                    poll::channel_sptr(handshaker_locker), ret)) {
+                PUMP_WARN_LOG("tls_handshaker: post handshake step result failed");
+            }
+        }
     }
 
     void tls_handshaker::on_timeout(tls_handshaker_wptr wptr) {
         PUMP_LOCK_WPOINTER(handshaker, wptr);
         if (handshaker) {
-            if (handshaker->__set_state(TRANSPORT_STARTED, TRANSPORT_TIMEOUTING)) {
+            // Timer runs on the same poller with handshake step result, so flow in use
+            // by crypto worker is closed when the result is handled.
+            if (handshaker->__set_state(TRANSPORT_STARTED, TRANSPORT_TIMEOUTING) &&
+                !handshaker->handshaking_.load()) {
                 handshaker->__close_flow();
             }
         }
     }
 
-    bool tls_handshaker::__open_flow(pump_socket fd, void_ptr xcred, bool is_client) {
+    bool tls_handshaker::__open_flow(pump_socket fd,
+                                     void_ptr xcred,
+                                     bool is_client,
+                                     bool memory_io) {
         // Setup flow
         PUMP_ASSERT(!flow_);
         flow_.reset(object_create<flow::flow_tls>(), object_delete<flow::flow_tls>);
 
         poll::channel_sptr ch = shared_from_this();
-        if (flow_->init(ch, fd, xcred, is_client) != flow::FLOW_ERR_NO) {
+        if (flow_->init(ch, fd, xcred, is_client, memory_io) != flow::FLOW_ERR_NO) {
             PUMP_WARN_LOG("tls_handshaker: open flow failed for flow init failed");
             return false;
         }
@@ -160,8 +213,15 @@ namespace transport {
         return true;
     }
 
-    void tls_handshaker::__process_handshake() {
-        switch (flow_->handshake()) {
+    void tls_handshaker::__handshake_step() {
+        if (!__post_handshake_task()) {
+            // Handshake maybe finished when starting, flow handshake returns ok again.
+            __process_handshake(flow_->handshake());
+        }
+    }
+
+    void tls_handshaker::__process_handshake(int32_t ret) {
+        switch (ret) {
         case ssl::TLS_HANDSHAKE_OK:
             if (__set_state(TRANSPORT_STARTED, TRANSPORT_FINISHED)) {
                 __handshake_finished();
@@ -183,6 +243,37 @@ namespace transport {
         }
     }
 
+    bool tls_handshaker::__post_handshake_task() {
+        // Handshake step runs on crypto workers if service has, and its result is
+        // posted back to the poller, where tracker is resumed and callbacks are
+        // triggered. Tracker is one shot so no more event will be triggered before
+        // resuming.
+        auto sv = get_service();
+        if (!sv->has_crypto_worker()) {
+            return false;
+        }
+
+        // Handshaking flag is set before checking state, and stopping checks it after
+        // changing state, so flow is never closed while crypto worker uses it.
+        handshaking_.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!__is_state(TRANSPORT_STARTED)) {
+            handshaking_.store(false);
+            if (__is_state(TRANSPORT_STOPPING)) {
+                __handshake_finished();
+                return true;
+            }
+            return false;
+        }
+
+        tls_handshaker_wptr wptr = shared_from_this();
+        if (!sv->post_crypto_task(pump_bind(&tls_handshaker::on_handshake_task, wptr))) {
+            handshaking_.store(false);
+            return false;
+        }
+        return true;
+    }
+
     bool tls_handshaker::__start_handshake_timer(int64_t timeout) {
         if (timeout <= 0) {
             return true;
@@ -192,7 +283,7 @@ namespace transport {
         time::timer_callback cb = pump_bind(&tls_handshaker::on_timeout, shared_from_this());
         timer_ = time::timer::create(timeout, cb);
 
-        return get_service()->start_timer(timer_);
+        return get_service()->start_timer(timer_, SEND_POLLER);
     }
 
     void tls_handshaker::__stop_handshake_timer() {
@@ -23,8 +23,10 @@ namespace transport {
       : base_transport(TLS_TRANSPORT, nullptr, -1),
         last_send_iob_size_(0),
         last_send_iob_(nullptr),
+        next_send_iob_(nullptr),
+        record_iob_(nullptr),
         pending_send_cnt_(0),
-        sendlist_(32) {
+        sendlist_(8) {
     }
 
     tls_transport::~tls_transport() {
@@ -46,6 +48,8 @@ namespace transport {
     }
 
     int32_t tls_transport::start(service_ptr sv, const transport_callbacks &cbs) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TLS);
+
         if (!flow_) {
             PUMP_ERR_LOG("tls_transport: start failed with invalid flow");
             return ERROR_INVALID;
@@ -146,6 +150,8 @@ namespace transport {
     }
 
     int32_t tls_transport::send(const block_t *b, int32_t size) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TLS);
+
         if (!b || size == 0) {
             PUMP_ERR_LOG("tls_transport: send failed with invalid buffer");
             return ERROR_INVALID;
@@ -187,6 +193,8 @@ namespace transport {
     }
 
     int32_t tls_transport::send(toolkit::io_buffer_ptr iob) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TLS);
+
         if (!iob || iob->data_size() == 0) {
             PUMP_ERR_LOG("tls_transport: send failed with invalid io buffer");
             return ERROR_INVALID;
@@ -227,7 +235,7 @@ namespace transport {
 
         block_t data[MAX_TCP_BUFFER_SIZE];
         int32_t size = flow_->read(data, sizeof(data));
-        if (PUMP_LIKELY(size != 0)) {
+        if (PUMP_LIKELY(size > 0)) {
             // If read state is READ_ONCE, change it to READ_PENDING.
             // If read state is READ_LOOP, last state will be seted to READ_LOOP.
             int32_t last_state = READ_ONCE;
@@ -248,6 +256,12 @@ namespace transport {
             return;
         }
 
+        // Decrypted data maybe left in tls session, socket will not be readable for it.
+        if (flow_->has_unread_data()) {
+            __post_channel_event(shared_from_this(), 0);
+            return;
+        }
+
         if (!__start_read_tracker()) {
             PUMP_WARN_LOG("tls_transport: handle channel event failed for starting read tracker failed");
             __try_doing_disconnected_process();
@@ -255,6 +269,8 @@ namespace transport {
     }
 
     void tls_transport::on_read_event() {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TLS);
+
         block_t data[MAX_TCP_BUFFER_SIZE];
         int32_t size = flow_->read(data, sizeof(data));
         if (PUMP_LIKELY(size > 0)) {
@@ -278,6 +294,12 @@ namespace transport {
             return;
         }
 
+        // Decrypted data maybe left in tls session, socket will not be readable for it.
+        if (flow_->has_unread_data()) {
+            __post_channel_event(shared_from_this(), 0);
+            return;
+        }
+
         if (!__resume_read_tracker()) {
             PUMP_DEBUG_LOG("tcp_transport: handle read event failed for resuming read tracker failed");
             __try_doing_disconnected_process();
@@ -285,6 +307,8 @@ namespace transport {
     }
 
     void tls_transport::on_send_event() {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TLS);
+
         int32_t ret;
 
         auto flow = flow_.get();
@@ -382,10 +406,25 @@ namespace transport {
 
     int32_t tls_transport::__send_once(flow::flow_tls_ptr flow) {
         PUMP_ASSERT(!last_send_iob_);
-        // Pop next buffer from sendlist.
-        PUMP_DEBUG_CHECK(sendlist_.pop(last_send_iob_));
+        // Take the buffer left by last coalescing at first, then pop next buffer
+        // from sendlist.
+        toolkit::io_buffer_ptr iob = next_send_iob_;
+        if (iob != nullptr) {
+            next_send_iob_ = nullptr;
+        } else if (!sendlist_.pop(iob)) {
+            // Buffers counted late were sent by last sender already.
+            return ERROR_OK;
+        }
+        last_send_iob_ = iob;
         // Save last send buffer data size.
-        last_send_iob_size_ = last_send_iob_->data_size();
+        last_send_iob_size_ = iob->data_size();
+
+        // Coalesce following small buffers into one record.
+        if (last_send_iob_size_ < flow->get_record_size() &&
+            !__coalesce_send_buffers(flow->get_record_size())) {
+            PUMP_ERR_LOG("tls_transport: send once failed for coalescing buffers failed");
+            return ERROR_FAULT;
+        }
 
         auto ret = flow->want_to_send(last_send_iob_);
         if (PUMP_LIKELY(ret == flow::FLOW_ERR_NO)) {
@@ -405,6 +444,72 @@ namespace transport {
         return ERROR_FAULT;
     }
 
+    bool tls_transport::__coalesce_send_buffers(int32_t record_size) {
+        PUMP_ASSERT(record_size <= TLS_MAX_RECORD_SIZE);
+        // Buffers are inserted to sendlist before counted in pending send size, so
+        // only buffers covered by pending send size can be coalesced.
+        int32_t counted_size = pending_send_size_.load() - last_send_iob_size_;
+
+        toolkit::io_buffer_ptr iob = nullptr;
+        if (!__pop_coalescing_buffer(record_size - last_send_iob_size_, counted_size, iob)) {
+            return true;
+        }
+
+        if (PUMP_UNLIKELY(!record_iob_)) {
+            record_iob_ = toolkit::io_buffer::create();
+            if (!record_iob_ || !record_iob_->init_with_size(TLS_MAX_RECORD_SIZE)) {
+                next_send_iob_ = iob;
+                return false;
+            }
+        }
+        record_iob_->reset();
+
+        // Move last send buffer to record buffer.
+        toolkit::io_buffer_ptr last_iob = last_send_iob_;
+        bool ok = record_iob_->append(last_iob->data(), last_iob->data_size());
+        last_iob->sub_ref();
+        last_send_iob_ = nullptr;
+
+        // Append following buffers until record buffer is full, record buffer never
+        // grows over the record size.
+        do {
+            counted_size -= (int32_t)iob->data_size();
+            ok = ok && record_iob_->append(iob->data(), iob->data_size());
+            iob->sub_ref();
+        } while (ok && 
+                 __pop_coalescing_buffer(record_size - (int32_t)record_iob_->data_size(), 
+                                         counted_size, 
+                                         iob));
+        if (!ok) {
+            return false;
+        }
+
+        // Record buffer is kept by transport, so add a reference for sending.
+        record_iob_->add_ref();
+        last_send_iob_ = record_iob_;
+        last_send_iob_size_ = record_iob_->data_size();
+
+        return true;
+    }
+
+    bool tls_transport::__pop_coalescing_buffer(int32_t space, 
+                                                int32_t counted_size,
+                                                toolkit::io_buffer_ptr &iob) {
+        if (space <= 0 || counted_size <= 0) {
+            return false;
+        }
+        if (!sendlist_.pop(iob)) {
+            return false;
+        }
+        // Buffer not fitting the record or not counted yet is sent next time.
+        int32_t size = (int32_t)iob->data_size();
+        if (size > space || size > counted_size) {
+            next_send_iob_ = iob;
+            return false;
+        }
+        return true;
+    }
+
     void tls_transport::__try_doing_disconnected_process() {
         // Change transport state from TRANSPORT_STARTED to TRANSPORT_DISCONNECTING.
         __set_state(TRANSPORT_STARTED, TRANSPORT_DISCONNECTING);
@@ -416,6 +521,12 @@ namespace transport {
         if (last_send_iob_) {
             last_send_iob_->sub_ref();
         }
+        if (next_send_iob_) {
+            next_send_iob_->sub_ref();
+        }
+        if (record_iob_) {
+            record_iob_->sub_ref();
+        }
 
         toolkit::io_buffer_ptr iob;
         while (sendlist_.pop(iob)) {
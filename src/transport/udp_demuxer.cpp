@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pump/transport/udp_demuxer.h"
+
+namespace pump {
+namespace transport {
+
+    udp_demuxer::udp_demuxer(const address &bind_address,
+                             int64_t idle_timeout,
+                             int32_t max_send_queue_len,
+                             int32_t max_sessions) noexcept
+      : sv_(nullptr),
+        state_(TRANSPORT_INITED),
+        bind_address_(bind_address),
+        idle_timeout_(idle_timeout),
+        max_send_queue_len_(max_send_queue_len),
+        max_sessions_(max_sessions) {
+    }
+
+    udp_demuxer::~udp_demuxer() {
+        if (idle_timer_) {
+            idle_timer_->stop();
+        }
+        __disconnect_all_sessions();
+    }
+
+    int32_t udp_demuxer::start(service_ptr sv, const acceptor_callbacks &cbs) {
+        if (!sv) {
+            PUMP_ERR_LOG("udp_demuxer: start failed with invalid service");
+            return ERROR_INVALID;
+        }
+
+        if (!cbs.accepted_cb || !cbs.stopped_cb) {
+            PUMP_ERR_LOG("udp_demuxer: start failed with invalid callbacks");
+            return ERROR_INVALID;
+        }
+
+        int32_t expected = TRANSPORT_INITED;
+        if (!state_.compare_exchange_strong(expected, TRANSPORT_STARTING)) {
+            PUMP_ERR_LOG("udp_demuxer: start failed with wrong status");
+            return ERROR_INVALID;
+        }
+
+        // Callbacks
+        cbs_ = cbs;
+
+        // Service
+        sv_ = sv;
+
+        toolkit::defer cleanup([&]() {
+            if (transport_) {
+                transport_->stop();
+            }
+            state_.store(TRANSPORT_ERROR);
+        });
+
+        transport_ = udp_transport::create(bind_address_, max_send_queue_len_);
+
+        transport_callbacks tcbs;
+        udp_demuxer_wptr wptr = shared_from_this();
+        tcbs.read_from_cb = pump_bind(&udp_demuxer::on_read_from, wptr, _1, _2, _3);
+        tcbs.stopped_cb = pump_bind(&udp_demuxer::on_stopped, wptr);
+        if (transport_->start(sv, tcbs) != ERROR_OK) {
+            PUMP_ERR_LOG("udp_demuxer: start failed for starting udp transport failed");
+            return ERROR_FAULT;
+        }
+
+        if (transport_->read_for_loop() != ERROR_OK) {
+            PUMP_ERR_LOG("udp_demuxer: start failed for reading udp transport failed");
+            return ERROR_FAULT;
+        }
+
+        if (idle_timeout_ > 0) {
+            // Idle sessions are checked four times in idle timeout duration.
+            int64_t interval = idle_timeout_ / 4 > 0 ? idle_timeout_ / 4 : 1;
+            time::timer_callback cb = pump_bind(&udp_demuxer::on_idle_timeout, wptr);
+            idle_timer_ = time::timer::create(interval, cb, true);
+            if (!sv->start_timer(idle_timer_, READ_POLLER)) {
+                PUMP_ERR_LOG("udp_demuxer: start failed for starting idle timer failed");
+                return ERROR_FAULT;
+            }
+        }
+
+        state_.store(TRANSPORT_STARTED);
+
+        cleanup.clear();
+
+        return ERROR_OK;
+    }
+
+    void udp_demuxer::stop() {
+        // When udp transport stopped, all sessions will be disconnected and stopped
+        // callback will be triggered.
+        int32_t expected = TRANSPORT_STARTED;
+        if (state_.compare_exchange_strong(expected, TRANSPORT_STOPPING)) {
+            if (idle_timer_) {
+                idle_timer_->stop();
+            }
+            transport_->stop();
+        }
+    }
+
+    udp_session_sptr udp_demuxer::open_session(const address &remote_address) {
+        if (state_.load() != TRANSPORT_STARTED) {
+            PUMP_WARN_LOG("udp_demuxer: open session failed for demuxer not started");
+            return udp_session_sptr();
+        }
+
+        std::lock_guard<std::mutex> lock(session_mx_);
+        auto it = sessions_.find(remote_address);
+        if (it != sessions_.end()) {
+            return it->second;
+        }
+        return __create_session(remote_address);
+    }
+
+    int32_t udp_demuxer::get_session_count() {
+        std::lock_guard<std::mutex> lock(session_mx_);
+        return (int32_t)sessions_.size();
+    }
+
+    void udp_demuxer::on_read_from(udp_demuxer_wptr wptr,
+                                   const block_t *b,
+                                   int32_t size,
+                                   const address &from_address) {
+        PUMP_LOCK_WPOINTER(demuxer, wptr);
+        if (demuxer == nullptr) {
+            return;
+        }
+
+        bool accepted = false;
+        udp_session_sptr session;
+        {
+            std::lock_guard<std::mutex> lock(demuxer->session_mx_);
+            auto it = demuxer->sessions_.find(from_address);
+            if (PUMP_LIKELY(it != demuxer->sessions_.end())) {
+                session = it->second;
+            } else if (demuxer->state_.load() == TRANSPORT_STARTED) {
+                if ((int32_t)demuxer->sessions_.size() >= demuxer->max_sessions_) {
+                    PUMP_DEBUG_LOG("udp_demuxer: drop datagram from %s for sessions full",
+                        from_address.to_string().c_str());
+                    return;
+                }
+                session = demuxer->__create_session(from_address);
+                accepted = !!session;
+            }
+        }
+
+        if (PUMP_UNLIKELY(!session)) {
+            return;
+        }
+
+        if (accepted) {
+            base_transport_sptr transport = session;
+            demuxer->cbs_.accepted_cb(transport);
+            // Session not started in accepted callback would never be removed.
+            if (!session->is_started()) {
+                demuxer->__remove_session(session.get());
+                return;
+            }
+        }
+
+        session->__handle_datagram(b, size);
+    }
+
+    void udp_demuxer::on_stopped(udp_demuxer_wptr wptr) {
+        PUMP_LOCK_WPOINTER(demuxer, wptr);
+        if (demuxer == nullptr) {
+            return;
+        }
+
+        demuxer->__disconnect_all_sessions();
+
+        int32_t expected = TRANSPORT_STOPPING;
+        if (demuxer->state_.compare_exchange_strong(expected, TRANSPORT_STOPPED)) {
+            demuxer->cbs_.stopped_cb();
+        }
+    }
+
+    void udp_demuxer::on_idle_timeout(udp_demuxer_wptr wptr) {
+        PUMP_LOCK_WPOINTER(demuxer, wptr);
+        if (demuxer == nullptr) {
+            return;
+        }
+
+        std::vector<udp_session_sptr> idle_sessions;
+        uint64_t now = time::get_cached_clock_milliseconds();
+        {
+            std::lock_guard<std::mutex> lock(demuxer->session_mx_);
+            auto beg = demuxer->sessions_.begin();
+            while (beg != demuxer->sessions_.end()) {
+                uint64_t active_time = beg->second->get_last_active_time();
+                if (now > active_time && 
+                    int64_t(now - active_time) >= demuxer->idle_timeout_) {
+                    idle_sessions.push_back(beg->second);
+                    beg = demuxer->sessions_.erase(beg);
+                } else {
+                    ++beg;
+                }
+            }
+        }
+
+        for (auto &session : idle_sessions) {
+            PUMP_DEBUG_LOG("udp_demuxer: disconnect idle session %s", 
+                session->get_remote_address().to_string().c_str());
+            session->__disconnect();
+        }
+    }
+
+    udp_session_sptr udp_demuxer::__create_session(const address &remote_address) {
+        INLINE_OBJECT_CREATE(
+            obj, udp_session, (shared_from_this(), transport_, remote_address));
+        if (PUMP_UNLIKELY(obj == nullptr)) {
+            PUMP_WARN_LOG("udp_demuxer: create session failed for allocating failed");
+            return udp_session_sptr();
+        }
+
+        udp_session_sptr session(obj, object_delete<udp_session>);
+        sessions_[remote_address] = session;
+
+        return session;
+    }
+
+    void udp_demuxer::__remove_session(udp_session_ptr session) {
+        std::lock_guard<std::mutex> lock(session_mx_);
+        auto it = sessions_.find(session->get_remote_address());
+        if (it != sessions_.end() && it->second.get() == session) {
+            sessions_.erase(it);
+        }
+    }
+
+    void udp_demuxer::__disconnect_all_sessions() {
+        std::unordered_map<address, udp_session_sptr> sessions;
+        {
+            std::lock_guard<std::mutex> lock(session_mx_);
+            sessions.swap(sessions_);
+        }
+
+        for (auto &item : sessions) {
+            item.second->__disconnect();
+        }
+    }
+
+}  // namespace transport
+}  // namespace pump
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pump/transport/udp_demuxer.h"
+
+namespace pump {
+namespace transport {
+
+    udp_session::udp_session(udp_demuxer_wptr &&demuxer,
+                             udp_transport_sptr &transport,
+                             const address &remote_address) noexcept
+      : base_transport(UDP_SESSION, nullptr, -1),
+        demuxer_(demuxer),
+        transport_(transport),
+        last_active_time_(time::get_clock_milliseconds()) {
+        local_address_ = transport->get_local_address();
+        remote_address_ = remote_address;
+    }
+
+    int32_t udp_session::start(service_ptr sv, const transport_callbacks &cbs) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
+        if (!sv) {
+            PUMP_ERR_LOG("udp_session: start failed with invalid service");
+            return ERROR_INVALID;
+        }
+
+        if (!cbs.read_cb || !cbs.disconnected_cb || !cbs.stopped_cb) {
+            PUMP_ERR_LOG("udp_session: start failed with invalid callbacks");
+            return ERROR_INVALID;
+        }
+
+        if (!__set_state(TRANSPORT_INITED, TRANSPORT_STARTING)) {
+            PUMP_ERR_LOG("udp_session: start failed with wrong status");
+            return ERROR_INVALID;
+        }
+
+        // Set callbacks
+        cbs_ = cbs;
+
+        // Set service
+        __set_service(sv);
+
+        __update_active_time();
+
+        __set_state(TRANSPORT_STARTING, TRANSPORT_STARTED);
+
+        return ERROR_OK;
+    }
+
+    void udp_session::stop() {
+        while (__is_state(TRANSPORT_STARTED)) {
+            if (__set_state(TRANSPORT_STARTED, TRANSPORT_STOPPING)) {
+                PUMP_LOCK_WPOINTER(demuxer, demuxer_);
+                if (demuxer != nullptr) {
+                    demuxer->__remove_session(this);
+                }
+                __post_channel_event(shared_from_this(), 0);
+                return;
+            }
+        }
+
+        // If in disconnecting status at the moment, disconnected callback is not
+        // triggered yet, so we just set stopping status and stopped callback will be
+        // triggered instead.
+        if (__set_state(TRANSPORT_DISCONNECTING, TRANSPORT_STOPPING)) {
+            return;
+        }
+    }
+
+    int32_t udp_session::read_for_once() {
+        while (__is_state(TRANSPORT_STARTED)) {
+            if (__change_read_state(READ_ONCE) != READ_INVALID) {
+                return ERROR_OK;
+            }
+        }
+        return ERROR_UNSTART;
+    }
+
+    int32_t udp_session::read_for_loop() {
+        while (__is_state(TRANSPORT_STARTED)) {
+            if (__change_read_state(READ_LOOP) != READ_INVALID) {
+                return ERROR_OK;
+            }
+        }
+        return ERROR_UNSTART;
+    }
+
+    int32_t udp_session::send(const block_t *b, int32_t size) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
+        if (PUMP_UNLIKELY(!__is_state(TRANSPORT_STARTED))) {
+            PUMP_WARN_LOG("udp_session: send failed for session not started");
+            return ERROR_UNSTART;
+        }
+
+        __update_active_time();
+
+        return transport_->send(b, size, remote_address_);
+    }
+
+    int32_t udp_session::send(toolkit::io_buffer_ptr iob) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
+        if (!iob || iob->data_size() == 0) {
+            PUMP_WARN_LOG("udp_session: send failed with invalid io buffer");
+            return ERROR_INVALID;
+        }
+
+        int32_t ec = send(iob->data(), iob->data_size());
+        if (ec == ERROR_OK) {
+            iob->sub_ref();
+        }
+
+        return ec;
+    }
+
+    void udp_session::__handle_datagram(const block_t *b, int32_t size) {
+        if (PUMP_UNLIKELY(!__is_state(TRANSPORT_STARTED))) {
+            return;
+        }
+
+        __update_active_time();
+
+        // If read state is READ_ONCE, change it to READ_PENDING.
+        // If read state is READ_LOOP, last state will be seted to READ_LOOP.
+        // Otherwise session is not reading, and the datagram is dropped.
+        int32_t last_state = READ_ONCE;
+        if (!read_state_.compare_exchange_strong(last_state, READ_PENDING) &&
+            last_state != READ_LOOP) {
+            return;
+        }
+
+        // Do read callback.
+        cbs_.read_cb(b, size);
+
+        // If last read state is READ_ONCE, try to change read state to READ_NONE.
+        if (last_state == READ_ONCE) {
+            last_state = READ_PENDING;
+            read_state_.compare_exchange_strong(last_state, READ_NONE);
+        }
+    }
+
+    void udp_session::__disconnect() {
+        if (__set_state(TRANSPORT_STARTED, TRANSPORT_DISCONNECTING)) {
+            __post_channel_event(shared_from_this(), 0);
+        }
+    }
+
+}  // namespace transport
+}  // namespace pump
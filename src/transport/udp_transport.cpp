@@ -19,17 +19,35 @@
 namespace pump {
 namespace transport {
 
-    udp_transport::udp_transport(const address &bind_address) noexcept
-      : base_transport(UDP_TRANSPORT, nullptr, -1) {
+    udp_transport::udp_transport(
+        const address &bind_address,
+        int32_t max_send_queue_len,
+        int32_t drop_policy) noexcept
+      : base_transport(UDP_TRANSPORT, nullptr, -1),
+        max_send_queue_len_(max_send_queue_len),
+        drop_policy_(drop_policy),
+        dropped_cnt_(0),
+        send_queue_len_(0),
+        uncounted_drop_cnt_(0),
+        sendlist_(nullptr),
+        send_batch_pos_(0),
+        send_batch_cnt_(0) {
         local_address_ = bind_address;
+        if (max_send_queue_len_ > 0) {
+            sendlist_ = object_create<toolkit::freelock_multi_queue<datagram*, 8>>(
+                MAX_UDP_SEND_BATCH);
+        }
     }
 
     udp_transport::~udp_transport() {
         __stop_read_tracker();
         __stop_send_tracker();
+        __clear_sendlist();
     }
 
     int32_t udp_transport::start(service_ptr sv, const transport_callbacks &cbs) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
         if (!sv) {
             PUMP_ERR_LOG("udp_transport: start failed with invalid service");
             return ERROR_INVALID;
@@ -101,6 +119,8 @@ namespace transport {
     int32_t udp_transport::send(const block_t *b,
                                 int32_t size,
                                 const address &address) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
         if (!b || size == 0) {
             PUMP_ERR_LOG("udp_transport: send failed with invalid buffer");
             return ERROR_INVALID;
@@ -111,6 +131,10 @@ namespace transport {
             return ERROR_UNSTART;
         }
 
+        if (sendlist_ != nullptr) {
+            return __async_send(b, size, address);
+        }
+
         if (PUMP_LIKELY(flow_->send(b, size, address) > 0)) {
             return ERROR_OK;
         }
@@ -119,6 +143,8 @@ namespace transport {
     }
 
     void udp_transport::on_read_event() {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
         auto flow = flow_.get();
 
         address from_addr;
@@ -151,6 +177,18 @@ namespace transport {
         PUMP_DEBUG_CHECK(__resume_read_tracker());
     }
 
+    void udp_transport::on_send_event() {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_TRANSPORT);
+
+        if (PUMP_UNLIKELY(!__is_state(TRANSPORT_STARTED))) {
+            return;
+        }
+
+        if (__send_queued() == ERROR_AGAIN) {
+            PUMP_DEBUG_CHECK(__resume_send_tracker());
+        }
+    }
+
     bool udp_transport::__open_transport_flow() {
         // Init udp transport flow.
         PUMP_ASSERT(!flow_);
@@ -182,5 +220,139 @@ namespace transport {
         return ERROR_OK;
     }
 
+    int32_t udp_transport::__async_send(const block_t *b,
+                                        int32_t size,
+                                        const address &address) {
+        if (drop_policy_ == UDP_DROP_NEWEST &&
+            send_queue_len_.load(std::memory_order_relaxed) >= max_send_queue_len_) {
+            dropped_cnt_.fetch_add(1, std::memory_order_relaxed);
+            return ERROR_AGAIN;
+        }
+
+        datagram *dg = __create_datagram(b, size, address);
+        if (PUMP_UNLIKELY(dg == nullptr)) {
+            PUMP_WARN_LOG("udp_transport: async send failed for creating datagram failed");
+            return ERROR_FAULT;
+        }
+        PUMP_DEBUG_CHECK(sendlist_->push(dg));
+
+        // If there are queued datagrams, the sending owner will send the datagram.
+        int32_t queue_len = send_queue_len_.fetch_add(1);
+        if (queue_len > 0) {
+            // Only when the datagram really overflows the send queue, drop the oldest
+            // datagram. It keeps counted until the sending owner finds the queue
+            // empty, so the owner never waits for a datagram which is dropped. If
+            // nothing can be popped, all datagrams are taken by the sending owner.
+            if (queue_len >= max_send_queue_len_ && drop_policy_ == UDP_DROP_OLDEST) {
+                datagram *oldest = nullptr;
+                if (sendlist_->pop(oldest)) {
+                    __destroy_datagram(oldest);
+                    dropped_cnt_.fetch_add(1, std::memory_order_relaxed);
+                    uncounted_drop_cnt_.fetch_add(1, std::memory_order_release);
+                }
+            }
+            return ERROR_OK;
+        }
+
+        auto ret = __send_queued();
+        if (PUMP_LIKELY(ret == ERROR_OK)) {
+            return ERROR_OK;
+        }
+
+        if (!__start_send_tracker()) {
+            PUMP_WARN_LOG("udp_transport: async send failed for starting send tracker failed");
+            return ERROR_FAULT;
+        }
+
+        return ERROR_OK;
+    }
+
+    int32_t udp_transport::__send_queued() {
+        net::datagram dgs[MAX_UDP_SEND_BATCH];
+        while (true) {
+            // Refill sending batch from send queue.
+            if (send_batch_pos_ == send_batch_cnt_) {
+                send_batch_pos_ = send_batch_cnt_ = 0;
+                while (send_batch_cnt_ < MAX_UDP_SEND_BATCH &&
+                       sendlist_->pop(send_batch_[send_batch_cnt_])) {
+                    ++send_batch_cnt_;
+                }
+                // Queued datagrams are dropped as oldest, so uncount them. Dropping
+                // sender may not have added its uncounted drop yet, then try again.
+                if (send_batch_cnt_ == 0) {
+                    int32_t dropped = uncounted_drop_cnt_.exchange(0, std::memory_order_acquire);
+                    if (dropped > 0 && send_queue_len_.fetch_sub(dropped) == dropped) {
+                        return ERROR_OK;
+                    }
+                    continue;
+                }
+            }
+
+            int32_t count = send_batch_cnt_ - send_batch_pos_;
+            for (int32_t i = 0; i < count; i++) {
+                datagram *dg = send_batch_[send_batch_pos_ + i];
+                dgs[i].b = dg->data();
+                dgs[i].size = dg->size;
+                dgs[i].addr = dg->to.get();
+                dgs[i].addrlen = dg->to.len();
+            }
+
+            int32_t sent = flow_->send_batch(dgs, count);
+            if (sent < 0) {
+                return ERROR_AGAIN;
+            } else if (sent == 0) {
+                // Datagram errors such as unreachable destination should not stop
+                // the transport, so drop the failed datagram and continue.
+                PUMP_DEBUG_LOG("udp_transport: send queued failed for flow send failed");
+                dropped_cnt_.fetch_add(1, std::memory_order_relaxed);
+                sent = 1;
+            }
+
+            for (int32_t i = 0; i < sent; i++) {
+                __destroy_datagram(send_batch_[send_batch_pos_++]);
+            }
+
+            if (send_queue_len_.fetch_sub(sent) == sent) {
+                return ERROR_OK;
+            }
+        }
+    }
+
+    udp_transport::datagram* udp_transport::__create_datagram(const block_t *b,
+                                                             int32_t size,
+                                                             const address &address) {
+        datagram *dg = (datagram*)pump_malloc(sizeof(datagram) + size);
+        if (PUMP_UNLIKELY(dg == nullptr)) {
+            return nullptr;
+        }
+        new (dg) datagram;
+        dg->to = address;
+        dg->size = size;
+        memcpy(dg->data(), b, size);
+        return dg;
+    }
+
+    void udp_transport::__destroy_datagram(datagram *dg) {
+        INLINE_OBJECT_DELETE(dg, datagram);
+    }
+
+    void udp_transport::__clear_sendlist() {
+        if (sendlist_ == nullptr) {
+            return;
+        }
+
+        for (; send_batch_pos_ < send_batch_cnt_; send_batch_pos_++) {
+            __destroy_datagram(send_batch_[send_batch_pos_]);
+        }
+
+        datagram *dg = nullptr;
+        while (sendlist_->pop(dg)) {
+            __destroy_datagram(dg);
+        }
+
+        object_delete(sendlist_);
+        sendlist_ = nullptr;
+    }
+
 }  // namespace transport
 }  // namespace pump
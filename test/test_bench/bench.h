@@ -0,0 +1,201 @@
+#ifndef bench_h
+#define bench_h
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/*********************************************************************************
+ * Get steady clock nanoseconds
+ ********************************************************************************/
+inline uint64_t bench_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*********************************************************************************
+ * Latency histogram
+ * Values below 16 have exact buckets, larger values have 16 sub buckets for each
+ * power of two, so recorded values keep about 6% precision. Histograms recorded by
+ * different threads can be merged.
+ ********************************************************************************/
+class latency_histogram {
+  public:
+    latency_histogram()
+      : count_(0),
+        max_(0),
+        buckets_(BUCKET_COUNT, 0) {
+    }
+
+    void record(uint64_t value) {
+        buckets_[__index(value)]++;
+        if (value > max_) {
+            max_ = value;
+        }
+        count_++;
+    }
+
+    void merge(const latency_histogram &other) {
+        for (int32_t i = 0; i < BUCKET_COUNT; i++) {
+            buckets_[i] += other.buckets_[i];
+        }
+        if (other.max_ > max_) {
+            max_ = other.max_;
+        }
+        count_ += other.count_;
+    }
+
+    uint64_t percentile(double p) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        uint64_t rank = uint64_t(p / 100.0 * (count_ - 1)) + 1;
+        uint64_t seen = 0;
+        for (int32_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += buckets_[i];
+            if (seen >= rank) {
+                uint64_t value = __value(i);
+                return value < max_ ? value : max_;
+            }
+        }
+        return max_;
+    }
+
+    uint64_t count() const {
+        return count_;
+    }
+
+    uint64_t max() const {
+        return max_;
+    }
+
+  private:
+    constexpr static int32_t SUB_BITS = 4;
+    constexpr static int32_t SUB_COUNT = 1 << SUB_BITS;
+    constexpr static int32_t BUCKET_COUNT = SUB_COUNT + (64 - SUB_BITS) * SUB_COUNT;
+
+    static int32_t __index(uint64_t value) {
+        if (value < SUB_COUNT) {
+            return int32_t(value);
+        }
+        int32_t exp = 63 - __builtin_clzll(value);
+        int32_t sub = int32_t(value >> (exp - SUB_BITS)) & (SUB_COUNT - 1);
+        return SUB_COUNT + (exp - SUB_BITS) * SUB_COUNT + sub;
+    }
+
+    static uint64_t __value(int32_t index) {
+        if (index < SUB_COUNT) {
+            return uint64_t(index);
+        }
+        int32_t exp = (index - SUB_COUNT) / SUB_COUNT + SUB_BITS;
+        int32_t sub = (index - SUB_COUNT) % SUB_COUNT;
+        return uint64_t(SUB_COUNT + sub) << (exp - SUB_BITS);
+    }
+
+  private:
+    uint64_t count_;
+    uint64_t max_;
+    std::vector<uint64_t> buckets_;
+};
+
+/*********************************************************************************
+ * Benchmark options
+ ********************************************************************************/
+struct bench_options {
+    // Operation count of each run
+    int64_t items;
+    // Producer or thread counts to sweep
+    std::vector<int32_t> producers;
+    // Consumer counts to sweep
+    std::vector<int32_t> consumers;
+    // Element sizes to sweep
+    std::vector<int32_t> sizes;
+    // Batch sizes to sweep
+    std::vector<int32_t> batches;
+    // Target names to run, empty means all
+    std::vector<std::string> targets;
+
+    bool has_target(const std::string &name) const {
+        if (targets.empty()) {
+            return true;
+        }
+        for (auto &t : targets) {
+            if (t == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/*********************************************************************************
+ * Benchmark result
+ * Latency of queues is from enqueuing to dequeuing, latency of locks is waiting
+ * time of acquiring, latency of semaphores is half round trip of ping pong.
+ * Resident bytes is growth of process resident memory, only connection benches
+ * measure it.
+ ********************************************************************************/
+struct bench_result {
+    std::string bench;
+    std::string target;
+    int32_t producers;
+    int32_t consumers;
+    int32_t element_size;
+    int32_t batch_size;
+    int64_t items;
+    uint64_t elapsed_ns;
+    uint64_t resident_bytes = 0;
+    latency_histogram latency;
+};
+
+typedef std::vector<bench_result> bench_results;
+
+/*********************************************************************************
+ * Write benchmark results as json
+ ********************************************************************************/
+inline void write_bench_json(FILE *fp, const bench_results &results) {
+    fprintf(fp, "{\n  \"results\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        const bench_result &r = results[i];
+        double secs = r.elapsed_ns / 1000000000.0;
+        fprintf(fp,
+                "%s\n    {\"bench\": \"%s\", \"target\": \"%s\", \"producers\": %d, "
+                "\"consumers\": %d, \"element_size\": %d, \"batch_size\": %d, "
+                "\"items\": %lld, \"elapsed_ns\": %llu, \"ops_per_sec\": %.0f, "
+                "\"resident_bytes\": %llu, \"bytes_per_item\": %.1f, "
+                "\"bytes_per_1m_items\": %.0f, "
+                "\"latency_ns\": {\"count\": %llu, \"p50\": %llu, \"p90\": %llu, "
+                "\"p99\": %llu, \"p999\": %llu, \"max\": %llu}}",
+                i == 0 ? "" : ",",
+                r.bench.c_str(),
+                r.target.c_str(),
+                r.producers,
+                r.consumers,
+                r.element_size,
+                r.batch_size,
+                (long long)r.items,
+                (unsigned long long)r.elapsed_ns,
+                secs > 0 ? r.items / secs : 0.0,
+                (unsigned long long)r.resident_bytes,
+                r.items > 0 ? double(r.resident_bytes) / r.items : 0.0,
+                r.items > 0 ? double(r.resident_bytes) / r.items * 1000000 : 0.0,
+                (unsigned long long)r.latency.count(),
+                (unsigned long long)r.latency.percentile(50),
+                (unsigned long long)r.latency.percentile(90),
+                (unsigned long long)r.latency.percentile(99),
+                (unsigned long long)r.latency.percentile(99.9),
+                (unsigned long long)r.latency.max());
+    }
+    fprintf(fp, "\n  ]\n}\n");
+}
+
+extern void run_queue_bench(const bench_options &opts, bench_results &results);
+
+extern void run_sync_bench(const bench_options &opts, bench_results &results);
+
+extern void run_conn_bench(const bench_options &opts, bench_results &results);
+
+#endif
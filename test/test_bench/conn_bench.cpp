@@ -0,0 +1,294 @@
+#include <pump/init.h>
+#include <pump/service.h>
+#include <pump/transport/tcp_transport.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(OS_LINUX)
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#endif
+
+#include <atomic>
+#include <thread>
+
+#include "bench.h"
+
+using namespace pump;
+using namespace pump::transport;
+
+/*********************************************************************************
+ * Get resident bytes of current process
+ * Return 0 if it is unsupported.
+ ********************************************************************************/
+static uint64_t get_resident_bytes() {
+#if defined(OS_LINUX)
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (!fp) {
+        return 0;
+    }
+    unsigned long long size = 0, resident = 0;
+    int32_t n = fscanf(fp, "%llu %llu", &size, &resident);
+    fclose(fp);
+    if (n != 2) {
+        return 0;
+    }
+    return resident * (uint64_t)sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+static void on_read(const block_t *b, int32_t size) {
+}
+
+static void on_disconnected() {
+}
+
+static std::atomic<int64_t> stopped_count(0);
+
+static void on_stopped() {
+    stopped_count.fetch_add(1);
+}
+
+static void add_result(const char *name,
+                       int64_t items,
+                       uint64_t elapsed_ns,
+                       uint64_t resident_bytes,
+                       bench_results &results) {
+    bench_result result;
+    result.bench = "conn";
+    result.target = name;
+    result.producers = 1;
+    result.consumers = 0;
+    result.element_size = int32_t(sizeof(tcp_transport));
+    result.batch_size = 1;
+    result.items = items;
+    result.elapsed_ns = elapsed_ns;
+    result.resident_bytes = resident_bytes;
+    results.push_back(result);
+}
+
+/*********************************************************************************
+ * Created transports
+ * Transports are created and inited with an invalid fd, so the run measures memory
+ * of transport objects only.
+ ********************************************************************************/
+static void run_created(int64_t items, bench_results &results) {
+    address addr("127.0.0.1", 8888);
+    std::vector<tcp_transport_sptr> transports;
+    transports.reserve(size_t(items));
+
+    uint64_t rss = get_resident_bytes();
+    uint64_t beg = bench_now_ns();
+    for (int64_t i = 0; i < items; i++) {
+        tcp_transport_sptr transport = tcp_transport::create();
+        transport->init(-1, addr, addr);
+        transports.push_back(std::move(transport));
+    }
+    uint64_t end = bench_now_ns();
+    uint64_t grown = get_resident_bytes() - rss;
+
+    add_result("tcp_transport_created", items, end - beg, grown, results);
+}
+
+/*********************************************************************************
+ * Idle started transports
+ * Transports are started on unix socket pairs and keep idle, so the run measures
+ * memory of transports, flows and trackers in the poller. Pair count is limited by
+ * fd limit of the process.
+ ********************************************************************************/
+static void run_idle(int64_t items, bench_results &results) {
+#if defined(OS_LINUX)
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) {
+        return;
+    }
+    // Keep some fds for service and poller.
+    int64_t max_items = (int64_t(rl.rlim_cur) - 64) / 2 * 2;
+    if (items > max_items) {
+        fprintf(stderr, "limit idle connections to %lld by fd limit\n", (long long)max_items);
+        items = max_items;
+    }
+    if (items < 2) {
+        return;
+    }
+
+    service *sv = new service;
+    sv->start();
+
+    transport_callbacks cbs;
+    cbs.read_cb = on_read;
+    cbs.disconnected_cb = on_disconnected;
+    cbs.stopped_cb = on_stopped;
+
+    address addr("127.0.0.1", 8888);
+    std::vector<tcp_transport_sptr> transports;
+    transports.reserve(size_t(items));
+
+    uint64_t rss = get_resident_bytes();
+    uint64_t beg = bench_now_ns();
+    for (int64_t i = 0; i < items; i += 2) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            fprintf(stderr, "socketpair failed at %lld\n", (long long)i);
+            break;
+        }
+        for (int32_t k = 0; k < 2; k++) {
+            tcp_transport_sptr transport = tcp_transport::create();
+            transport->init(fds[k], addr, addr);
+            if (transport->start(sv, cbs) != ERROR_OK ||
+                transport->read_for_loop() != ERROR_OK) {
+                fprintf(stderr, "start transport failed at %lld\n", (long long)i);
+            }
+            transports.push_back(std::move(transport));
+        }
+    }
+    uint64_t end = bench_now_ns();
+    uint64_t grown = get_resident_bytes() - rss;
+
+    add_result("tcp_transport_idle", int64_t(transports.size()), end - beg, grown, results);
+
+    int64_t started = int64_t(transports.size());
+    stopped_count.store(0);
+    for (auto &transport : transports) {
+        transport->force_stop();
+    }
+    for (int32_t i = 0; i < 1000 && stopped_count.load() < started; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    transports.clear();
+
+    sv->stop();
+    sv->wait_stopped();
+    delete sv;
+#endif
+}
+
+/*********************************************************************************
+ * Transport events
+ * Sender transport sends stamped messages to receiver transport on a unix socket
+ * pair, so the run measures cost of read and send events through the transport
+ * and flow stack. Latency is from sending to reading of every message.
+ ********************************************************************************/
+static void run_events(int64_t items, bench_results &results) {
+#if defined(OS_LINUX)
+    const static int32_t MESSAGE_SIZE = 16;
+
+    service *sv = new service;
+    sv->start();
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        fprintf(stderr, "socketpair failed\n");
+        delete sv;
+        return;
+    }
+
+    std::atomic<int64_t> received(0);
+    latency_histogram latency;
+    block_t partial[MESSAGE_SIZE];
+    int32_t partial_size = 0;
+
+    transport_callbacks rcbs;
+    rcbs.read_cb = [&](const block_t *b, int32_t size) {
+        uint64_t now = bench_now_ns();
+        int64_t count = 0;
+        while (size > 0) {
+            int32_t n = MESSAGE_SIZE - partial_size;
+            n = n < size ? n : size;
+            memcpy(partial + partial_size, b, n);
+            partial_size += n;
+            b += n;
+            size -= n;
+            if (partial_size == MESSAGE_SIZE) {
+                uint64_t stamp;
+                memcpy(&stamp, partial, sizeof(stamp));
+                latency.record(now - stamp);
+                partial_size = 0;
+                count++;
+            }
+        }
+        received.fetch_add(count, std::memory_order_release);
+    };
+    rcbs.disconnected_cb = on_disconnected;
+    rcbs.stopped_cb = on_stopped;
+
+    transport_callbacks scbs;
+    scbs.read_cb = on_read;
+    scbs.disconnected_cb = on_disconnected;
+    scbs.stopped_cb = on_stopped;
+
+    address addr("127.0.0.1", 8888);
+    tcp_transport_sptr receiver = tcp_transport::create();
+    receiver->init(fds[0], addr, addr);
+    tcp_transport_sptr sender = tcp_transport::create();
+    sender->init(fds[1], addr, addr);
+    if (receiver->start(sv, rcbs) != ERROR_OK ||
+        receiver->read_for_loop() != ERROR_OK ||
+        sender->start(sv, scbs) != ERROR_OK) {
+        fprintf(stderr, "start transports failed\n");
+    }
+
+    block_t msg[MESSAGE_SIZE] = {0};
+    uint64_t beg = bench_now_ns();
+    for (int64_t i = 0; i < items; i++) {
+        // Keep pending send buffer bounded.
+        while (sender->get_pending_send_size() > 65536) {
+            std::this_thread::yield();
+        }
+        uint64_t stamp = bench_now_ns();
+        memcpy(msg, &stamp, sizeof(stamp));
+        if (sender->send(msg, MESSAGE_SIZE) != ERROR_OK) {
+            fprintf(stderr, "send failed at %lld\n", (long long)i);
+            break;
+        }
+    }
+    for (int32_t i = 0; i < 1000 && received.load(std::memory_order_acquire) < items; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    uint64_t end = bench_now_ns();
+
+    bench_result result;
+    result.bench = "conn";
+    result.target = "tcp_transport_events";
+    result.producers = 1;
+    result.consumers = 1;
+    result.element_size = MESSAGE_SIZE;
+    result.batch_size = 1;
+    result.items = received.load();
+    result.elapsed_ns = end - beg;
+    result.latency = latency;
+    results.push_back(result);
+
+    stopped_count.store(0);
+    sender->force_stop();
+    receiver->force_stop();
+    for (int32_t i = 0; i < 100 && stopped_count.load() < 2; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    sender.reset();
+    receiver.reset();
+
+    sv->stop();
+    sv->wait_stopped();
+    delete sv;
+#endif
+}
+
+void run_conn_bench(const bench_options &opts, bench_results &results) {
+    pump::init();
+
+    // Freed memory of a run is reused by later runs, so the smaller run goes first.
+    if (opts.has_target("tcp_transport_idle")) {
+        run_idle(opts.items, results);
+    }
+    if (opts.has_target("tcp_transport_created")) {
+        run_created(opts.items, results);
+    }
+    if (opts.has_target("tcp_transport_events")) {
+        run_events(opts.items, results);
+    }
+}
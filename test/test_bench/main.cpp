@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+static std::vector<int32_t> parse_ints(const char *s) {
+    std::vector<int32_t> vals;
+    while (*s) {
+        char *end = nullptr;
+        long val = strtol(s, &end, 10);
+        if (end == s) {
+            break;
+        }
+        vals.push_back(int32_t(val));
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return vals;
+}
+
+static std::vector<std::string> parse_names(const char *s) {
+    std::vector<std::string> names;
+    std::string name;
+    for (; *s; s++) {
+        if (*s == ',') {
+            if (!name.empty()) {
+                names.push_back(name);
+            }
+            name.clear();
+        } else {
+            name.push_back(*s);
+        }
+    }
+    if (!name.empty()) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+static void usage(const char *prog) {
+    printf("usage: %s [queue|sync|conn|all] [options]\n"
+           "  --items=N           operations of each run, or connections of conn bench,\n"
+           "                      default 200000\n"
+           "  --producers=1,2,4   producer counts, or thread counts of sync bench, up to 64\n"
+           "  --consumers=1,2,4   consumer counts\n"
+           "  --sizes=8,64,256    element sizes in bytes, 8, 64 or 256\n"
+           "  --batches=1,32      batch sizes, 1 to 256\n"
+           "  --targets=a,b       queue or sync targets, default all\n"
+           "  --output=FILE       write json to file, default stdout\n",
+           prog);
+}
+
+int main(int argc, const char **argv) {
+    std::string mode = "all";
+    std::string output;
+
+    bench_options opts;
+    opts.items = 200000;
+    opts.producers = {1, 2, 4};
+    opts.consumers = {1, 2, 4};
+    opts.sizes = {8, 64, 256};
+    opts.batches = {1, 32};
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *eq = strchr(arg, '=');
+        const char *val = eq ? eq + 1 : "";
+        if (strcmp(arg, "queue") == 0 || strcmp(arg, "sync") == 0 ||
+            strcmp(arg, "conn") == 0 || strcmp(arg, "all") == 0) {
+            mode = arg;
+        } else if (strncmp(arg, "--items=", 8) == 0) {
+            opts.items = atoll(val);
+        } else if (strncmp(arg, "--producers=", 12) == 0) {
+            opts.producers = parse_ints(val);
+        } else if (strncmp(arg, "--consumers=", 12) == 0) {
+            opts.consumers = parse_ints(val);
+        } else if (strncmp(arg, "--sizes=", 8) == 0) {
+            opts.sizes = parse_ints(val);
+        } else if (strncmp(arg, "--batches=", 10) == 0) {
+            opts.batches = parse_ints(val);
+        } else if (strncmp(arg, "--targets=", 10) == 0) {
+            opts.targets = parse_names(val);
+        } else if (strncmp(arg, "--output=", 9) == 0) {
+            output = val;
+        } else {
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (opts.items <= 0) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    bench_results results;
+    if (mode == "queue" || mode == "all") {
+        run_queue_bench(opts, results);
+    }
+    if (mode == "sync" || mode == "all") {
+        run_sync_bench(opts, results);
+    }
+    if (mode == "conn" || mode == "all") {
+        run_conn_bench(opts, results);
+    }
+
+    FILE *fp = stdout;
+    if (!output.empty()) {
+        fp = fopen(output.c_str(), "w");
+        if (!fp) {
+            fprintf(stderr, "open %s failed\n", output.c_str());
+            return -1;
+        }
+    }
+    write_bench_json(fp, results);
+    if (fp != stdout) {
+        fclose(fp);
+    }
+
+    return 0;
+}
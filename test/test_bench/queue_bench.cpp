@@ -0,0 +1,261 @@
+#include <pump/toolkit/freelock_single_queue.h>
+#include <pump/toolkit/freelock_multi_queue.h>
+#include <pump/toolkit/freelock_array_queue.h>
+#include <pump/toolkit/freelock_ring_queue.h>
+#include <pump/toolkit/freelock_block_queue.h>
+
+#include <stdio.h>
+
+#include <atomic>
+#include <thread>
+
+#include "bench.h"
+
+using namespace pump;
+
+// Capacity of bounded queues and initial size of unbounded queues
+const static int32_t QUEUE_CAPACITY = 4096;
+
+// Max batch size
+const static int32_t MAX_BATCH_SIZE = 256;
+
+/*********************************************************************************
+ * Bench element
+ * Producer stamps the element when enqueuing, and payload makes element size.
+ ********************************************************************************/
+template <int32_t Size>
+struct bench_element {
+    uint64_t stamp;
+    char payload[Size - sizeof(uint64_t)];
+};
+
+template <>
+struct bench_element<8> {
+    uint64_t stamp;
+};
+
+/*********************************************************************************
+ * Queue adapter
+ * Adapter gives every queue the same batch interface.
+ ********************************************************************************/
+template <typename Q>
+struct queue_adapter {
+    typedef typename Q::element_type element_type;
+
+    queue_adapter()
+      : q(QUEUE_CAPACITY) {
+    }
+
+    uint32_t push(element_type *items, uint32_t count) {
+        uint32_t pushed = 0;
+        while (pushed < count && q.push(items[pushed])) {
+            pushed++;
+        }
+        return pushed;
+    }
+
+    uint32_t pop(element_type *items, uint32_t max_count) {
+        uint32_t popped = 0;
+        while (popped < max_count && q.pop(items[popped])) {
+            popped++;
+        }
+        return popped;
+    }
+
+    Q q;
+};
+
+template <typename T>
+struct queue_adapter<toolkit::freelock_ring_queue<T>> {
+    typedef T element_type;
+
+    queue_adapter()
+      : q(QUEUE_CAPACITY) {
+    }
+
+    uint32_t push(element_type *items, uint32_t count) {
+        return q.push_bulk(items, count);
+    }
+
+    uint32_t pop(element_type *items, uint32_t max_count) {
+        return q.pop_bulk(items, max_count);
+    }
+
+    toolkit::freelock_ring_queue<T> q;
+};
+
+template <typename Q>
+struct queue_adapter<toolkit::freelock_block_queue<Q>> {
+    typedef typename Q::element_type element_type;
+
+    queue_adapter()
+      : q(QUEUE_CAPACITY) {
+    }
+
+    uint32_t push(element_type *items, uint32_t count) {
+        uint32_t pushed = 0;
+        while (pushed < count && q.enqueue(items[pushed])) {
+            pushed++;
+        }
+        return pushed;
+    }
+
+    uint32_t pop(element_type *items, uint32_t max_count) {
+        // Wait shortly, so that consumers can see all items are consumed.
+        return q.dequeue_bulk(items, max_count, 1000);
+    }
+
+    toolkit::freelock_block_queue<Q> q;
+};
+
+template <typename Q>
+static void run_queue(const char *name,
+                      int32_t producers,
+                      int32_t consumers,
+                      int32_t batch,
+                      int64_t items,
+                      bench_results &results) {
+    typedef typename queue_adapter<Q>::element_type element_type;
+
+    queue_adapter<Q> adapter;
+
+    std::atomic<int32_t> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<int64_t> consumed(0);
+    std::vector<latency_histogram> latencies(consumers);
+    std::vector<std::thread> threads;
+
+    auto wait_go = [&]() {
+        ready.fetch_add(1);
+        while (!go.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    };
+
+    for (int32_t i = 0; i < producers; i++) {
+        int64_t count = items / producers + (i < items % producers ? 1 : 0);
+        threads.emplace_back([&, count]() {
+            element_type elems[MAX_BATCH_SIZE];
+            wait_go();
+            for (int64_t done = 0; done < count;) {
+                uint32_t n = uint32_t(count - done < batch ? count - done : batch);
+                uint64_t stamp = bench_now_ns();
+                for (uint32_t k = 0; k < n; k++) {
+                    elems[k].stamp = stamp;
+                }
+                for (uint32_t pushed = 0; pushed < n;) {
+                    uint32_t cnt = adapter.push(elems + pushed, n - pushed);
+                    if (cnt == 0) {
+                        std::this_thread::yield();
+                    }
+                    pushed += cnt;
+                }
+                done += n;
+            }
+        });
+    }
+
+    for (int32_t i = 0; i < consumers; i++) {
+        threads.emplace_back([&, i]() {
+            element_type elems[MAX_BATCH_SIZE];
+            latency_histogram &latency = latencies[i];
+            wait_go();
+            while (consumed.load(std::memory_order_relaxed) < items) {
+                uint32_t n = adapter.pop(elems, uint32_t(batch));
+                if (n == 0) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                uint64_t now = bench_now_ns();
+                for (uint32_t k = 0; k < n; k++) {
+                    latency.record(now - elems[k].stamp);
+                }
+                consumed.fetch_add(n, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    while (ready.load() < producers + consumers) {
+        std::this_thread::yield();
+    }
+    uint64_t beg = bench_now_ns();
+    go.store(true, std::memory_order_release);
+    for (auto &t : threads) {
+        t.join();
+    }
+    uint64_t end = bench_now_ns();
+
+    bench_result result;
+    result.bench = "queue";
+    result.target = name;
+    result.producers = producers;
+    result.consumers = consumers;
+    result.element_size = int32_t(sizeof(element_type));
+    result.batch_size = batch;
+    result.items = items;
+    result.elapsed_ns = end - beg;
+    for (auto &l : latencies) {
+        result.latency.merge(l);
+    }
+    results.push_back(result);
+}
+
+template <int32_t Size>
+static void run_queues_with_size(const bench_options &opts, bench_results &results) {
+    typedef bench_element<Size> element_type;
+
+    for (int32_t batch : opts.batches) {
+        if (batch < 1 || batch > MAX_BATCH_SIZE) {
+            fprintf(stderr, "skip invalid batch size %d\n", batch);
+            continue;
+        }
+        for (int32_t p : opts.producers) {
+            for (int32_t c : opts.consumers) {
+                if (p < 1 || c < 1) {
+                    continue;
+                }
+                // Single queue only supports one producer and one consumer.
+                if (p == 1 && c == 1 && opts.has_target("freelock_single_queue")) {
+                    run_queue<toolkit::freelock_single_queue<element_type>>(
+                        "freelock_single_queue", p, c, batch, opts.items, results);
+                }
+                if (opts.has_target("freelock_multi_queue")) {
+                    run_queue<toolkit::freelock_multi_queue<element_type>>(
+                        "freelock_multi_queue", p, c, batch, opts.items, results);
+                }
+                if (opts.has_target("freelock_array_queue")) {
+                    run_queue<toolkit::freelock_array_queue<element_type>>(
+                        "freelock_array_queue", p, c, batch, opts.items, results);
+                }
+                if (opts.has_target("freelock_ring_queue")) {
+                    run_queue<toolkit::freelock_ring_queue<element_type>>(
+                        "freelock_ring_queue", p, c, batch, opts.items, results);
+                }
+                if (opts.has_target("freelock_block_queue")) {
+                    typedef toolkit::freelock_multi_queue<element_type> inner_queue;
+                    run_queue<toolkit::freelock_block_queue<inner_queue>>(
+                        "freelock_block_queue", p, c, batch, opts.items, results);
+                }
+            }
+        }
+    }
+}
+
+void run_queue_bench(const bench_options &opts, bench_results &results) {
+    for (int32_t size : opts.sizes) {
+        switch (size) {
+        case 8:
+            run_queues_with_size<8>(opts, results);
+            break;
+        case 64:
+            run_queues_with_size<64>(opts, results);
+            break;
+        case 256:
+            run_queues_with_size<256>(opts, results);
+            break;
+        default:
+            fprintf(stderr, "skip unsupported element size %d, use 8, 64 or 256\n", size);
+            break;
+        }
+    }
+}
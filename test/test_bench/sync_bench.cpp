@@ -0,0 +1,166 @@
+#include <pump/toolkit/spin_mutex.h>
+#include <pump/toolkit/semaphore.h>
+
+#include <stdio.h>
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "bench.h"
+
+using namespace pump;
+
+template <typename Mutex>
+static void run_lock(const char *name, int32_t threads, int64_t items, bench_results &results) {
+    Mutex mx;
+    // Lock holder does a little work, so that waiters really contend.
+    volatile int64_t counter = 0;
+
+    std::atomic<int32_t> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<latency_histogram> latencies(threads);
+    std::vector<std::thread> workers;
+
+    for (int32_t i = 0; i < threads; i++) {
+        int64_t count = items / threads + (i < items % threads ? 1 : 0);
+        workers.emplace_back([&, i, count]() {
+            latency_histogram &latency = latencies[i];
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (int64_t k = 0; k < count; k++) {
+                uint64_t beg = bench_now_ns();
+                mx.lock();
+                uint64_t end = bench_now_ns();
+                counter = counter + 1;
+                mx.unlock();
+                latency.record(end - beg);
+            }
+        });
+    }
+
+    while (ready.load() < threads) {
+        std::this_thread::yield();
+    }
+    uint64_t beg = bench_now_ns();
+    go.store(true, std::memory_order_release);
+    for (auto &t : workers) {
+        t.join();
+    }
+    uint64_t end = bench_now_ns();
+
+    if (counter != items) {
+        fprintf(stderr, "%s lost updates %lld/%lld\n", name, (long long)counter, (long long)items);
+    }
+
+    bench_result result;
+    result.bench = "lock";
+    result.target = name;
+    result.producers = threads;
+    result.consumers = 0;
+    result.element_size = 0;
+    result.batch_size = 1;
+    result.items = items;
+    result.elapsed_ns = end - beg;
+    for (auto &l : latencies) {
+        result.latency.merge(l);
+    }
+    results.push_back(result);
+}
+
+static void run_semaphore(const char *name, int32_t pairs, int64_t items, bench_results &results) {
+    struct ping_pong {
+        toolkit::light_semaphore ping;
+        toolkit::light_semaphore pong;
+    };
+    std::vector<std::unique_ptr<ping_pong>> pps;
+    for (int32_t i = 0; i < pairs; i++) {
+        pps.emplace_back(new ping_pong);
+    }
+
+    std::atomic<int32_t> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<latency_histogram> latencies(pairs);
+    std::vector<std::thread> workers;
+
+    auto wait_go = [&]() {
+        ready.fetch_add(1);
+        while (!go.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    };
+
+    for (int32_t i = 0; i < pairs; i++) {
+        int64_t count = items / pairs + (i < items % pairs ? 1 : 0);
+        ping_pong *pp = pps[i].get();
+        workers.emplace_back([&, i, pp, count]() {
+            latency_histogram &latency = latencies[i];
+            wait_go();
+            for (int64_t k = 0; k < count; k++) {
+                uint64_t beg = bench_now_ns();
+                pp->ping.signal();
+                pp->pong.wait();
+                latency.record((bench_now_ns() - beg) / 2);
+            }
+        });
+        workers.emplace_back([&, pp, count]() {
+            wait_go();
+            for (int64_t k = 0; k < count; k++) {
+                pp->ping.wait();
+                pp->pong.signal();
+            }
+        });
+    }
+
+    while (ready.load() < pairs * 2) {
+        std::this_thread::yield();
+    }
+    uint64_t beg = bench_now_ns();
+    go.store(true, std::memory_order_release);
+    for (auto &t : workers) {
+        t.join();
+    }
+    uint64_t end = bench_now_ns();
+
+    bench_result result;
+    result.bench = "semaphore";
+    result.target = name;
+    result.producers = pairs;
+    result.consumers = pairs;
+    result.element_size = 0;
+    result.batch_size = 1;
+    result.items = items;
+    result.elapsed_ns = end - beg;
+    for (auto &l : latencies) {
+        result.latency.merge(l);
+    }
+    results.push_back(result);
+}
+
+void run_sync_bench(const bench_options &opts, bench_results &results) {
+    for (int32_t threads : opts.producers) {
+        if (threads < 1) {
+            continue;
+        }
+        if (opts.has_target("spin_mutex")) {
+            run_lock<toolkit::spin_mutex>("spin_mutex", threads, opts.items, results);
+        }
+        if (opts.has_target("ticket_mutex")) {
+            run_lock<toolkit::ticket_mutex>("ticket_mutex", threads, opts.items, results);
+        }
+        if (opts.has_target("mcs_mutex")) {
+            run_lock<toolkit::mcs_mutex>("mcs_mutex", threads, opts.items, results);
+        }
+        if (opts.has_target("std_mutex")) {
+            run_lock<std::mutex>("std_mutex", threads, opts.items, results);
+        }
+        // Ping pong switches thread every time, so it runs fewer round trips.
+        if (opts.has_target("light_semaphore")) {
+            int64_t items = opts.items / 10 > 0 ? opts.items / 10 : 1;
+            run_semaphore("light_semaphore", threads, items, results);
+        }
+    }
+}
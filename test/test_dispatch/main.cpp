@@ -0,0 +1,215 @@
+#include <pump/init.h>
+#include <pump/service.h>
+#include <pump/transport/tcp_transport.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(OS_LINUX)
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#endif
+
+#include <atomic>
+#include <thread>
+
+#include "../test_bench/bench.h"
+
+using namespace pump;
+using namespace pump::transport;
+
+/*********************************************************************************
+ * Dispatch bench
+ * It interposes libc socket io and epoll control for the whole executable, so it is
+ * kept out of test_bench, whose benches must run on unmodified libc paths.
+ ********************************************************************************/
+
+#if defined(OS_LINUX)
+// Glibc declares epoll_ctl with exception specification, other libcs don't.
+#if defined(__THROW)
+#define FAKE_EPOLL_CTL_THROW __THROW
+#else
+#define FAKE_EPOLL_CTL_THROW
+#endif
+
+/*********************************************************************************
+ * Fake fd
+ * Socket io and epoll control of the fake fd are served in memory, so runs drive
+ * transport events without the kernel. Other fds go to the kernel as usual.
+ ********************************************************************************/
+static std::atomic<int> fake_fd(-1);
+// Sending to fake fd would block or not
+static std::atomic<bool> fake_send_blocked(false);
+// Read and send trackers of fake fd, captured from epoll control
+static poll::channel_tracker_ptr fake_trackers[2] = {nullptr, nullptr};
+
+extern "C" ssize_t recv(int fd, void *b, size_t size, int flags) {
+    if (fd != fake_fd.load(std::memory_order_relaxed)) {
+        return recvfrom(fd, b, size, flags, nullptr, nullptr);
+    }
+    return size < 16 ? size : 16;
+}
+
+extern "C" ssize_t send(int fd, const void *b, size_t size, int flags) {
+    if (fd != fake_fd.load(std::memory_order_relaxed)) {
+        return sendto(fd, b, size, flags, nullptr, 0);
+    }
+    if (fake_send_blocked.load(std::memory_order_relaxed)) {
+        errno = EAGAIN;
+        return -1;
+    }
+    return size;
+}
+
+extern "C" int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+    FAKE_EPOLL_CTL_THROW {
+    if (fd != fake_fd.load(std::memory_order_relaxed)) {
+        return (int)syscall(SYS_epoll_ctl, epfd, op, fd, event);
+    }
+    if (op != EPOLL_CTL_DEL && event != nullptr) {
+        fake_trackers[(event->events & EPOLLOUT) ? 1 : 0] =
+            (poll::channel_tracker_ptr)event->data.ptr;
+    }
+    return 0;
+}
+#endif
+
+static std::atomic<int64_t> dispatched_reads(0);
+
+static void on_read(const block_t *b, int32_t size) {
+    dispatched_reads.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void on_disconnected() {
+}
+
+static std::atomic<int64_t> stopped_count(0);
+
+static void on_stopped() {
+    stopped_count.fetch_add(1);
+}
+
+static void add_result(const char *name,
+                       int64_t items,
+                       uint64_t elapsed_ns,
+                       bench_results &results) {
+    bench_result result;
+    result.bench = "dispatch";
+    result.target = name;
+    result.producers = 1;
+    result.consumers = 0;
+    result.element_size = int32_t(sizeof(tcp_transport));
+    result.batch_size = 1;
+    result.items = items;
+    result.elapsed_ns = elapsed_ns;
+    results.push_back(result);
+}
+
+/*********************************************************************************
+ * Transport dispatch
+ * A transport is started on the fake fd, and io events are dispatched to it like
+ * the poller does, so the run measures read and send event handlers of the
+ * concrete transport and its embedded flow only. Every send event run also sends
+ * the buffer which blocks at first.
+ ********************************************************************************/
+static void run_dispatch(int64_t items, bench_results &results) {
+#if defined(OS_LINUX)
+    service *sv = new service;
+    sv->start();
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        fprintf(stderr, "socketpair failed\n");
+        delete sv;
+        return;
+    }
+    fake_fd.store(fds[0]);
+
+    transport_callbacks cbs;
+    cbs.read_cb = on_read;
+    cbs.disconnected_cb = on_disconnected;
+    cbs.stopped_cb = on_stopped;
+
+    address addr("127.0.0.1", 8888);
+    tcp_transport_sptr transport = tcp_transport::create();
+    transport->init(fds[0], addr, addr);
+    if (transport->start(sv, cbs) != ERROR_OK ||
+        transport->read_for_loop() != ERROR_OK ||
+        fake_trackers[0] == nullptr) {
+        fprintf(stderr, "start transport failed\n");
+    }
+
+    // Read events
+    poll::channel_tracker_ptr tracker = fake_trackers[0];
+    poll::channel_sptr ch = tracker ? tracker->get_channel() : poll::channel_sptr();
+    dispatched_reads.store(0);
+    uint64_t beg = bench_now_ns();
+    for (int64_t i = 0; ch && i < items; i++) {
+        if (tracker->untrack()) {
+            ch->handle_io_event(tracker->get_expected_event());
+        }
+    }
+    uint64_t end = bench_now_ns();
+    add_result("tcp_transport_read_dispatch", dispatched_reads.load(), end - beg, results);
+
+    // Send events
+    block_t msg[16] = {0};
+    int64_t sent = 0;
+    poll::channel_sptr sch;
+    beg = bench_now_ns();
+    for (int64_t i = 0; i < items; i++) {
+        fake_send_blocked.store(true, std::memory_order_relaxed);
+        if (transport->send(msg, sizeof(msg)) != ERROR_OK) {
+            break;
+        }
+        fake_send_blocked.store(false, std::memory_order_relaxed);
+        tracker = fake_trackers[1];
+        if (tracker && !sch) {
+            sch = tracker->get_channel();
+        }
+        if (tracker && tracker->untrack()) {
+            sch->handle_io_event(tracker->get_expected_event());
+            sent++;
+        }
+    }
+    end = bench_now_ns();
+    fake_send_blocked.store(false);
+    add_result("tcp_transport_send_dispatch", sent, end - beg, results);
+
+    ch.reset();
+    sch.reset();
+    stopped_count.store(0);
+    transport->force_stop();
+    for (int32_t i = 0; i < 100 && stopped_count.load() < 1; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    transport.reset();
+    fake_fd.store(-1);
+    fake_trackers[0] = fake_trackers[1] = nullptr;
+    close(fds[1]);
+
+    sv->stop();
+    sv->wait_stopped();
+    delete sv;
+#endif
+}
+
+int main(int argc, const char **argv) {
+    int64_t items = argc > 1 ? atoll(argv[1]) : 1000000;
+    if (items <= 0) {
+        printf("usage: %s [events]\n", argv[0]);
+        return -1;
+    }
+
+    pump::init();
+
+    bench_results results;
+    run_dispatch(items, results);
+    write_bench_json(stdout, results);
+
+    return 0;
+}
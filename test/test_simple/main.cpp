@@ -3,10 +3,19 @@
 #include <thread>
 #include <queue>
 #include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <memory>
 
+#include <pump/memory.h>
+#include <pump/delegate.h>
 #include <pump/time/timestamp.h>
 #include <pump/toolkit/freelock_multi_queue.h>
 #include <pump/toolkit/freelock_single_queue.h>
+#include <pump/toolkit/freelock_ring_queue.h>
+#include <pump/toolkit/freelock_block_queue.h>
+#include <pump/toolkit/freelock_overflow_queue.h>
+#include <pump/toolkit/handle_table.h>
 
 #include "concurrentqueue.h"
 #include "readerwriterqueue.h"
@@ -253,6 +262,612 @@ int test2(int loop) {
     return 0;
 }
 
+int test3(int loop) {
+
+    const int bulk = 32;
+
+    // Ring queue is bounded, so failed operations yield to others.
+    toolkit::freelock_ring_queue<int> rq(65536);
+
+    std::thread t1([&]() {
+        int loop2 = loop / 2;
+        auto beg = time::get_clock_milliseconds();
+        for (int i = 0; i < loop2;) {
+            if (rq.push(i)) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        auto end = time::get_clock_milliseconds();
+        printf("freelock_ring_queue push use %dms category %d\n", int(end - beg), rq.capacity());
+    });
+
+    std::thread t2([&]() {
+        auto beg = time::get_clock_milliseconds();
+        for (int i = loop / 2; i < loop;) {
+            if (rq.push(i)) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        auto end = time::get_clock_milliseconds();
+        printf("freelock_ring_queue push use %dms category %d\n", int(end - beg), rq.capacity());
+    });
+
+    int val;
+    auto beg = time::get_clock_milliseconds();
+    for (int i = 0; i < loop;) {
+        if (rq.pop(val)) {
+            i++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    auto end = time::get_clock_milliseconds();
+    printf("freelock_ring_queue pop use %dms\n", int(end - beg));
+
+    t1.join();
+    t2.join();
+
+    // Bulk operations move 32 elements with one claiming.
+    std::thread t3([&]() {
+        int vals[bulk];
+        int loop2 = loop / 2;
+        auto beg = time::get_clock_milliseconds();
+        for (int i = 0; i < loop2;) {
+            int n = loop2 - i < bulk ? loop2 - i : bulk;
+            for (int j = 0; j < n; j++) {
+                vals[j] = i + j;
+            }
+            int pushed = rq.push_bulk(vals, n);
+            if (pushed == 0) {
+                std::this_thread::yield();
+            }
+            i += pushed;
+        }
+        auto end = time::get_clock_milliseconds();
+        printf("freelock_ring_queue push bulk use %dms\n", int(end - beg));
+    });
+
+    std::thread t4([&]() {
+        int vals[bulk];
+        auto beg = time::get_clock_milliseconds();
+        for (int i = loop / 2; i < loop;) {
+            int n = loop - i < bulk ? loop - i : bulk;
+            for (int j = 0; j < n; j++) {
+                vals[j] = i + j;
+            }
+            int pushed = rq.push_bulk(vals, n);
+            if (pushed == 0) {
+                std::this_thread::yield();
+            }
+            i += pushed;
+        }
+        auto end = time::get_clock_milliseconds();
+        printf("freelock_ring_queue push bulk use %dms\n", int(end - beg));
+    });
+
+    int vals[bulk];
+    beg = time::get_clock_milliseconds();
+    for (int i = 0; i < loop;) {
+        int popped = rq.pop_bulk(vals, bulk);
+        if (popped == 0) {
+            std::this_thread::yield();
+        }
+        i += popped;
+    }
+    end = time::get_clock_milliseconds();
+    printf("freelock_ring_queue pop bulk use %dms\n", int(end - beg));
+
+    t3.join();
+    t4.join();
+
+    moodycamel::ConcurrentQueue<int> cq;
+
+    std::thread t5([&]() {
+        int vals[bulk];
+        int loop2 = loop / 2;
+        auto beg = time::get_clock_milliseconds();
+        for (int i = 0; i < loop2;) {
+            int n = loop2 - i < bulk ? loop2 - i : bulk;
+            for (int j = 0; j < n; j++) {
+                vals[j] = i + j;
+            }
+            if (cq.enqueue_bulk(vals, n)) {
+                i += n;
+            }
+        }
+        auto end = time::get_clock_milliseconds();
+        printf("moodycamel::ConcurrentQueue push bulk use %dms\n", int(end - beg));
+    });
+
+    std::thread t6([&]() {
+        int vals[bulk];
+        auto beg = time::get_clock_milliseconds();
+        for (int i = loop / 2; i < loop;) {
+            int n = loop - i < bulk ? loop - i : bulk;
+            for (int j = 0; j < n; j++) {
+                vals[j] = i + j;
+            }
+            if (cq.enqueue_bulk(vals, n)) {
+                i += n;
+            }
+        }
+        auto end = time::get_clock_milliseconds();
+        printf("moodycamel::ConcurrentQueue push bulk use %dms\n", int(end - beg));
+    });
+
+    beg = time::get_clock_milliseconds();
+    for (int i = 0; i < loop;) {
+        int popped = (int)cq.try_dequeue_bulk(vals, bulk);
+        if (popped == 0) {
+            std::this_thread::yield();
+        }
+        i += popped;
+    }
+    end = time::get_clock_milliseconds();
+    printf("moodycamel::ConcurrentQueue pop bulk use %dms\n", int(end - beg));
+
+    t5.join();
+    t6.join();
+
+    return 0;
+}
+
+int test4(int loop) {
+
+    const int bulk = 32;
+
+    typedef toolkit::freelock_ring_queue<int> ring_queue;
+
+    for (int b = 1; b <= bulk; b += bulk - 1) {
+        toolkit::freelock_block_queue<ring_queue> bq(65536);
+
+        std::thread t1([&]() {
+            for (int i = 0; i < loop;) {
+                if (bq.enqueue(i)) {
+                    i++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+        int vals[bulk];
+        int wakeups = 0;
+        auto beg = time::get_clock_milliseconds();
+        for (int i = 0; i < loop;) {
+            i += bq.dequeue_bulk(vals, b, std::chrono::seconds(1));
+            wakeups++;
+        }
+        auto end = time::get_clock_milliseconds();
+        printf("freelock_block_queue dequeue bulk %d use %dms dequeue calls %d\n", b, int(end - beg), wakeups);
+
+        t1.join();
+    }
+
+    return 0;
+}
+
+int test5(int loop) {
+
+    toolkit::handle_table<int> table;
+    std::vector<uint64_t> handles(loop);
+    std::vector<std::weak_ptr<int>> objs(loop);
+    std::unordered_map<uint64_t, std::shared_ptr<int>> map;
+
+    auto beg = time::get_clock_milliseconds();
+    for (int i = 0; i < loop; i++) {
+        auto obj = std::make_shared<int>(i);
+        objs[i] = obj;
+        handles[i] = table.insert(obj);
+    }
+    auto end = time::get_clock_milliseconds();
+    printf("handle_table insert use %dms\n", int(end - beg));
+
+    for (int i = 0; i < loop; i++) {
+        map[handles[i]] = objs[i].lock();
+    }
+
+    int64_t sum = 0;
+    beg = time::get_clock_milliseconds();
+    for (int i = 0; i < loop; i++) {
+        int *p = table.pin(handles[i]);
+        sum += *p;
+        table.unpin(handles[i]);
+    }
+    end = time::get_clock_milliseconds();
+    printf("handle_table pin and unpin use %dms\n", int(end - beg));
+
+    beg = time::get_clock_milliseconds();
+    for (int i = 0; i < loop; i++) {
+        auto p = map.find(handles[i])->second;
+        sum -= *p;
+    }
+    end = time::get_clock_milliseconds();
+    printf("unordered_map find shared_ptr use %dms\n", int(end - beg));
+    map.clear();
+
+    // Remove objects while they are pinned by another thread.
+    std::thread t1([&]() {
+        for (int i = 0; i < loop; i++) {
+            if (!table.remove(handles[i])) {
+                printf("handle_table remove %d failed\n", i);
+            }
+        }
+    });
+    for (int k = 0; k < 4; k++) {
+        for (int i = 0; i < loop; i++) {
+            int *p = table.pin(handles[i]);
+            if (p) {
+                sum += *p - i;
+                table.unpin(handles[i]);
+            }
+        }
+    }
+    t1.join();
+
+    int alive = 0;
+    for (int i = 0; i < loop; i++) {
+        if (!objs[i].expired() || table.pin(handles[i]) != nullptr) {
+            alive++;
+        }
+    }
+    uint64_t h = table.insert(std::make_shared<int>(0));
+    printf("handle_table sum %lld alive %d size %u reused stale handle %d\n",
+           (long long)sum, alive, table.size(), h == handles[loop - 1]);
+
+    return 0;
+}
+
+int test6(int loop) {
+
+    // Small ring overflows often, pushing must never fail.
+    toolkit::freelock_block_queue<toolkit::freelock_overflow_queue<int>> bq(1024);
+
+    int failed = 0;
+    std::thread t1([&]() {
+        auto beg = time::get_clock_milliseconds();
+        for (int i = 0; i < loop; i++) {
+            if (!bq.enqueue(i)) {
+                failed++;
+            }
+        }
+        auto end = time::get_clock_milliseconds();
+        printf("freelock_overflow_queue enqueue use %dms\n", int(end - beg));
+    });
+
+    int vals[32];
+    int got = 0;
+    int64_t sum = 0;
+    auto beg = time::get_clock_milliseconds();
+    while (got < loop - failed) {
+        uint32_t count = bq.dequeue_bulk(vals, 32, 1000000);
+        if (count == 0) {
+            break;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            sum += vals[i];
+        }
+        got += count;
+    }
+    auto end = time::get_clock_milliseconds();
+    t1.join();
+
+    printf("freelock_overflow_queue dequeue use %dms got %d failed %d sum %s\n",
+           int(end - beg), got, failed,
+           sum == int64_t(loop) * (loop - 1) / 2 ? "ok" : "wrong");
+
+    return 0;
+}
+
+static int functor_alive = 0;
+
+template <int Size>
+struct counted_functor {
+    counted_functor(int v) : val(v) { functor_alive++; }
+    counted_functor(const counted_functor &o) : val(o.val) { functor_alive++; }
+    counted_functor(counted_functor &&o) noexcept : val(o.val) { functor_alive++; }
+    ~counted_functor() { functor_alive--; }
+    int operator()(int a) const { return a + val; }
+    int val;
+    char pad[Size];
+};
+
+int test7(int loop) {
+
+    typedef pump::delegate<int(int)> delegate_type;
+    int failed = 0;
+
+    // Inline functor
+    {
+        delegate_type d1 = counted_functor<8>(1);
+        delegate_type d2 = d1;
+        delegate_type d3 = std::move(d1);
+        if (d1 || d2(1) != 2 || d3(2) != 3 || functor_alive != 2) {
+            printf("delegate inline failed\n");
+            failed++;
+        }
+    }
+
+    // Heap functor
+    {
+        delegate_type d1 = counted_functor<256>(2);
+        delegate_type d2 = d1;
+        delegate_type d3 = std::move(d1);
+        if (d1 || d2(1) != 3 || d3(2) != 4 || functor_alive != 2) {
+            printf("delegate heap failed\n");
+            failed++;
+        }
+    }
+
+    // Self assign keeps functor.
+    {
+        delegate_type d1 = counted_functor<8>(4);
+        delegate_type d2 = counted_functor<256>(5);
+        delegate_type &r1 = d1;
+        delegate_type &r2 = d2;
+        d1 = r1;
+        d2 = std::move(r2);
+        if (!d1 || !d2 || d1(1) != 5 || d2(1) != 6 || functor_alive != 2) {
+            printf("delegate self assign failed\n");
+            failed++;
+        }
+    }
+
+    if (functor_alive != 0) {
+        printf("delegate leaked %d functors\n", functor_alive);
+        failed++;
+    }
+
+    delegate_type d = counted_functor<8>(1);
+    int64_t sum = 0;
+    auto beg = time::get_clock_milliseconds();
+    for (int i = 0; i < loop; i++) {
+        delegate_type c = d;
+        sum += c(i);
+    }
+    auto end = time::get_clock_milliseconds();
+    printf("delegate copy and invoke use %dms sum %lld, tests %s\n",
+           int(end - beg), (long long)sum, failed == 0 ? "ok" : "failed");
+
+    return 0;
+}
+
+struct accounted_object {
+    accounted_object(int v) : val(v) {}
+    int val;
+    char pad[60];
+};
+
+static bool memory_stats_delta(memory_tag tag,
+                               const memory_stats &before,
+                               uint64_t alloc_count,
+                               uint64_t free_count) {
+    memory_stats after;
+    if (!get_memory_stats(tag, after)) {
+        return false;
+    }
+    uint64_t allocs = after.alloc_count - before.alloc_count;
+    uint64_t frees = after.free_count - before.free_count;
+    uint64_t alloc_bytes = after.alloc_bytes - before.alloc_bytes;
+    uint64_t free_bytes = after.free_bytes - before.free_bytes;
+    if (allocs != alloc_count || frees != free_count) {
+        printf("memory %s counts %llu/%llu, expected %llu/%llu\n",
+               get_memory_tag_name(tag),
+               (unsigned long long)allocs,
+               (unsigned long long)frees,
+               (unsigned long long)alloc_count,
+               (unsigned long long)free_count);
+        return false;
+    }
+    if (alloc_count == free_count && alloc_bytes != free_bytes) {
+        printf("memory %s bytes %llu/%llu not balanced\n",
+               get_memory_tag_name(tag),
+               (unsigned long long)alloc_bytes,
+               (unsigned long long)free_bytes);
+        return false;
+    }
+    return true;
+}
+
+int test8(int loop) {
+
+    memory_stats before;
+    if (!get_memory_stats(MEMORY_TAG_WEBSOCKET, before)) {
+        // Without memory accounting statistics are always empty.
+        bool empty = before.alloc_count == 0 && before.free_count == 0 &&
+                     before.alloc_bytes == 0 && before.free_bytes == 0;
+        printf("memory accounting disabled, tests %s\n", empty ? "ok" : "failed");
+        return 0;
+    }
+
+    int failed = 0;
+    const int count = 1024;
+    std::vector<void*> blocks(count);
+
+    // Allocations are accounted to the tag of current scope.
+    {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_WEBSOCKET);
+        for (int i = 0; i < count; i++) {
+            blocks[i] = pump_malloc(i + 1);
+        }
+    }
+    if (!memory_stats_delta(MEMORY_TAG_WEBSOCKET, before, count, 0)) {
+        failed++;
+    }
+
+    // Reallocated memory keeps its tag even out of the scope.
+    for (int i = 0; i < count; i++) {
+        blocks[i] = pump_realloc(blocks[i], i + 64);
+    }
+    if (!memory_stats_delta(MEMORY_TAG_WEBSOCKET, before, count * 2, count)) {
+        failed++;
+    }
+
+    // Memory freed by another thread is accounted to the tag of the allocation, and
+    // counters of the exited thread are still collected.
+    std::thread t([&]() {
+        for (int i = 0; i < count; i++) {
+            pump_free(blocks[i]);
+        }
+    });
+    t.join();
+    if (!memory_stats_delta(MEMORY_TAG_WEBSOCKET, before, count * 2, count * 2)) {
+        failed++;
+    }
+
+    // Objects created by object_create must be deleted by object_delete.
+    get_memory_stats(MEMORY_TAG_WEBSOCKET, before);
+    auto beg = time::get_clock_milliseconds();
+    for (int i = 0; i < loop; i++) {
+        PUMP_MEMORY_TAG_SCOPE(MEMORY_TAG_WEBSOCKET);
+        accounted_object *obj = object_create<accounted_object>(i);
+        object_delete(obj);
+    }
+    auto end = time::get_clock_milliseconds();
+    if (!memory_stats_delta(MEMORY_TAG_WEBSOCKET, before, loop, loop)) {
+        failed++;
+    }
+
+    printf("memory accounted create and delete use %dms, tests %s\n",
+           int(end - beg), failed == 0 ? "ok" : "failed");
+
+    return 0;
+}
+
+struct pooled_object {
+    PUMP_ENABLE_OBJECT_POOL(pooled_object);
+    pooled_object(int64_t v) : val(v) {}
+    int64_t val;
+    char pad[56];
+};
+
+typedef object_pool<pooled_object> pooled_object_pool;
+
+static bool object_pool_delta(const char *name,
+                              const object_pool_stats &before,
+                              uint64_t alloc_count,
+                              uint64_t system_alloc_count,
+                              uint64_t system_free_count,
+                              uint64_t transfer_count) {
+    object_pool_stats after = pooled_object_pool::get_stats();
+    uint64_t allocs = after.alloc_count - before.alloc_count;
+    uint64_t frees = after.free_count - before.free_count;
+    uint64_t system_allocs = after.system_alloc_count - before.system_alloc_count;
+    uint64_t system_frees = after.system_free_count - before.system_free_count;
+    uint64_t transfers = after.transfer_count - before.transfer_count;
+    if (allocs != alloc_count || frees != alloc_count ||
+        system_allocs != system_alloc_count || system_frees != system_free_count ||
+        transfers != transfer_count) {
+        printf("object pool %s stats %llu/%llu/%llu/%llu/%llu, expected %llu/%llu/%llu/%llu/%llu\n",
+               name,
+               (unsigned long long)allocs,
+               (unsigned long long)frees,
+               (unsigned long long)system_allocs,
+               (unsigned long long)system_frees,
+               (unsigned long long)transfers,
+               (unsigned long long)alloc_count,
+               (unsigned long long)alloc_count,
+               (unsigned long long)system_alloc_count,
+               (unsigned long long)system_free_count,
+               (unsigned long long)transfer_count);
+        return false;
+    }
+    return true;
+}
+
+int test9(int loop) {
+
+    if (!object_pool_enabled<pooled_object>::value) {
+        printf("object pool disabled, tests skipped\n");
+        return 0;
+    }
+
+    int failed = 0;
+    const int batch = pooled_object_pool::BATCH_SIZE;
+    const int count = batch * 8;
+    std::vector<pooled_object*> objs(count);
+
+    // Objects allocated by one thread are freed by another thread. The freeing thread
+    // moves a batch to the central list when its local list is too long, and all
+    // batches are moved to the central list when it exits.
+    object_pool_stats before = pooled_object_pool::get_stats();
+    std::thread t1([&]() {
+        for (int i = 0; i < count; i++) {
+            objs[i] = object_create<pooled_object>(i);
+        }
+    });
+    t1.join();
+    std::thread t2([&]() {
+        for (int i = 0; i < count; i++) {
+            if (objs[i]->val != i) {
+                failed++;
+            }
+            object_delete(objs[i]);
+        }
+    });
+    t2.join();
+    if (!object_pool_delta("cross thread free", before, count, count, 0, count / batch)) {
+        failed++;
+    }
+
+    // Another thread takes batches from the central list, so no object is allocated
+    // from system.
+    before = pooled_object_pool::get_stats();
+    std::thread t3([&]() {
+        std::vector<pooled_object*> reused(count);
+        for (int i = 0; i < count; i++) {
+            reused[i] = object_create<pooled_object>(i);
+        }
+        for (int i = 0; i < count; i++) {
+            object_delete(reused[i]);
+        }
+    });
+    t3.join();
+    if (!object_pool_delta("central reuse", before, count, 0, 0, count / batch * 2)) {
+        failed++;
+    }
+
+    // Central list caches limited batches, more objects are freed to system. The
+    // thread takes cached batches first, then allocates others from system.
+    const int max_count = batch * pooled_object_pool::MAX_CENTRAL_BATCHES;
+    before = pooled_object_pool::get_stats();
+    std::thread t4([&]() {
+        std::vector<pooled_object*> many(max_count + count);
+        for (int i = 0; i < max_count + count; i++) {
+            many[i] = object_create<pooled_object>(i);
+        }
+        for (int i = 0; i < max_count + count; i++) {
+            object_delete(many[i]);
+        }
+    });
+    t4.join();
+    if (!object_pool_delta("central limit",
+                           before,
+                           max_count + count,
+                           max_count,
+                           count,
+                           count / batch + pooled_object_pool::MAX_CENTRAL_BATCHES)) {
+        failed++;
+    }
+
+    int64_t sum = 0;
+    auto beg = time::get_clock_milliseconds();
+    for (int i = 0; i < loop; i++) {
+        pooled_object *obj = object_create<pooled_object>(i);
+        sum += obj->val;
+        object_delete(obj);
+    }
+    auto end = time::get_clock_milliseconds();
+    printf("object pool create and delete use %dms sum %lld, tests %s\n",
+           int(end - beg), (long long)sum, failed == 0 ? "ok" : "failed");
+
+    return 0;
+}
+
 int main(int argc, const char **argv) {
     if (argc < 2) {
         return -1;
@@ -262,5 +877,19 @@ int main(int argc, const char **argv) {
 
     test2(loop);
 
+    test3(loop);
+
+    test4(loop);
+
+    test5(loop);
+
+    test6(loop);
+
+    test7(loop);
+
+    test8(loop);
+
+    test9(loop);
+
     return 0;
 }
\ No newline at end of file
@@ -2,6 +2,10 @@
 #include <pump/service.h>
 #include <pump/time/timer.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "timer_bench.h"
 
 class Timeout : public std::enable_shared_from_this<Timeout> {
   public:
@@ -54,6 +58,36 @@ int main(int argc, const char **argv) {
     
     pump::init();
 
+    // Benchmark starts and cancels timers, default count is 10M.
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        start_timer_bench(argc > 2 ? atoll(argv[2]) : 10000000);
+        return 0;
+    }
+
+    // Accuracy measures timer expired latency, default count is 10K.
+    if (argc > 1 && strcmp(argv[1], "accuracy") == 0) {
+        start_timer_accuracy(argc > 2 ? atoll(argv[2]) : 10000);
+        return 0;
+    }
+
+    // Dispatch measures timer dispatch lag of slow timers, default worker count is 1.
+    if (argc > 1 && strcmp(argv[1], "dispatch") == 0) {
+        start_timer_dispatch(argc > 2 ? atoi(argv[2]) : 1);
+        return 0;
+    }
+
+    // Clock benchmark compares clock variants, default count is 10M.
+    if (argc > 1 && strcmp(argv[1], "clock") == 0) {
+        start_clock_bench(argc > 2 ? atoll(argv[2]) : 10000000);
+        return 0;
+    }
+
+    // Lifetime stops and destroys timers after their service is deleted.
+    if (argc > 1 && strcmp(argv[1], "lifetime") == 0) {
+        start_timer_lifetime();
+        return 0;
+    }
+
     pump::service *sv = new pump::service;
     sv->start();
 
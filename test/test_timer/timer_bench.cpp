@@ -0,0 +1,273 @@
+#include <pump/init.h>
+#include <pump/service.h>
+#include <pump/time/timer.h>
+#include <pump/time/timer_wheel.h>
+#include <stdio.h>
+
+#include <map>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include "timer_bench.h"
+
+using namespace pump;
+
+static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void report(const char *name, int64_t count, uint64_t beg, uint64_t end) {
+    double ms = (end - beg) / 1000000.0;
+    printf("%-28s %10lld ops %10.1f ms %8.1f ns/op\n",
+           name, (long long)count, ms, (end - beg) / (double)count);
+}
+
+static void bench_timer_wheel(int64_t count, const std::vector<uint64_t> &expires) {
+    time::timer_sptr t = time::timer::create(0, time::timer_callback());
+
+    time::timer_wheel wheel(0);
+    std::vector<time::timer_wheel_node_ptr> nodes(count);
+
+    uint64_t beg = now_ns();
+    for (int64_t i = 0; i < count; i++) {
+        nodes[i] = wheel.add(t, expires[i]);
+    }
+    uint64_t mid = now_ns();
+    for (int64_t i = 0; i < count; i++) {
+        wheel.remove(nodes[i]);
+    }
+    uint64_t end = now_ns();
+
+    report("timer wheel start", count, beg, mid);
+    report("timer wheel cancel", count, mid, end);
+}
+
+static void bench_multimap(int64_t count, const std::vector<uint64_t> &expires) {
+    time::timer_sptr t = time::timer::create(0, time::timer_callback());
+    time::timer_wptr wt = t;
+
+    typedef std::multimap<uint64_t, time::timer_wptr> timer_map;
+    timer_map timers;
+    std::vector<timer_map::iterator> its(count);
+
+    uint64_t beg = now_ns();
+    for (int64_t i = 0; i < count; i++) {
+        its[i] = timers.insert(std::make_pair(expires[i], wt));
+    }
+    uint64_t mid = now_ns();
+    for (int64_t i = 0; i < count; i++) {
+        timers.erase(its[i]);
+    }
+    uint64_t end = now_ns();
+
+    report("multimap start", count, beg, mid);
+    report("multimap cancel", count, mid, end);
+}
+
+static void bench_service(int64_t count) {
+    service *sv = new service(false);
+    sv->start();
+
+    time::timer_callback cb = []() {};
+
+    uint64_t beg = now_ns();
+    for (int64_t i = 0; i < count; i++) {
+        auto t = time::timer::create(60000 + i % 60000, cb);
+        sv->start_timer(t);
+        t->stop();
+    }
+    uint64_t end = now_ns();
+
+    report("service start and stop", count, beg, end);
+
+    sv->stop();
+    sv->wait_stopped();
+}
+
+void start_timer_bench(int64_t count) {
+    // Timeouts are spread in one hour.
+    std::vector<uint64_t> expires(count);
+    uint64_t seed = 88172645463325252ULL;
+    for (int64_t i = 0; i < count; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        expires[i] = 1 + seed % 3600000;
+    }
+
+    bench_timer_wheel(count, expires);
+    bench_multimap(count, expires);
+    bench_service(count / 10);
+}
+
+static void on_accuracy_timeout(std::vector<uint64_t> *lates,
+                                std::atomic<int64_t> *fired,
+                                int64_t index,
+                                uint64_t deadline) {
+    uint64_t now = time::get_clock_microseconds();
+    (*lates)[index] = now > deadline ? now - deadline : 0;
+    fired->fetch_add(1);
+}
+
+static void bench_accuracy(service *sv, int64_t count, bool high_resolution) {
+    std::vector<uint64_t> lates(count);
+    std::atomic<int64_t> fired(0);
+    std::vector<time::timer_sptr> timers(count);
+
+    // Timeouts are spread in 20ms.
+    uint64_t beg = time::get_clock_microseconds();
+    for (int64_t i = 0; i < count; i++) {
+        uint64_t timeout_us = 1000 + (i * 7919) % 19000;
+        if (!high_resolution) {
+            timeout_us = timeout_us / 1000 * 1000;
+        }
+        time::timer_callback cb = pump_bind(&on_accuracy_timeout,
+                                            &lates,
+                                            &fired,
+                                            i,
+                                            time::get_clock_microseconds() + timeout_us);
+        if (high_resolution) {
+            timers[i] = time::timer::create_high_resolution(timeout_us, cb);
+        } else {
+            timers[i] = time::timer::create(timeout_us / 1000, cb);
+        }
+        sv->start_timer(timers[i]);
+    }
+    while (fired.load() < count) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    uint64_t end = time::get_clock_microseconds();
+
+    std::sort(lates.begin(), lates.end());
+    printf("%-28s %10lld timers %8.1f ms p50 %6lld us p99 %6lld us max %6lld us\n",
+           high_resolution ? "high resolution timer" : "timer",
+           (long long)count,
+           (end - beg) / 1000.0,
+           (long long)lates[count / 2],
+           (long long)lates[count * 99 / 100],
+           (long long)lates[count - 1]);
+}
+
+void start_timer_accuracy(int64_t count) {
+    service *sv = new service(false);
+    sv->start();
+
+    bench_accuracy(sv, count, false);
+    bench_accuracy(sv, count, true);
+
+    sv->stop();
+    sv->wait_stopped();
+}
+
+static void on_slow_timeout(std::atomic<int64_t> *fired) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    fired->fetch_add(1);
+}
+
+void start_timer_dispatch(int32_t workers) {
+    service *sv = new service(false);
+    sv->set_timer_worker_count(workers);
+    sv->start();
+
+    // Slow timers expire at the same time.
+    const int64_t count = 200;
+    std::atomic<int64_t> fired(0);
+    std::vector<time::timer_sptr> timers(count);
+    time::timer_callback cb = pump_bind(&on_slow_timeout, &fired);
+    for (int64_t i = 0; i < count; i++) {
+        timers[i] = time::timer::create(10, cb);
+        sv->start_timer(timers[i]);
+    }
+    while (fired.load() < count) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    timer_dispatch_stats stats = sv->get_timer_dispatch_stats();
+    printf("%d timer workers %10lld timers avg lag %8lld us max lag %8lld us\n",
+           workers,
+           (long long)stats.count,
+           (long long)(stats.total_lag / stats.count),
+           (long long)stats.max_lag);
+
+    sv->stop();
+    sv->wait_stopped();
+}
+
+template <typename Clock>
+static void bench_clock(const char *name, int64_t count, Clock clock) {
+    // Sum clock values, so calls are not optimized out.
+    uint64_t sum = 0;
+    uint64_t beg = now_ns();
+    for (int64_t i = 0; i < count; i++) {
+        sum += clock();
+    }
+    uint64_t end = now_ns();
+    report(name, count, beg, end);
+    if (sum == 0) {
+        printf("clock sum is zero\n");
+    }
+}
+
+void start_clock_bench(int64_t count) {
+    printf("tsc clock supported: %s\n", time::is_tsc_clock_supported() ? "yes" : "no");
+
+    bench_clock("clock milliseconds", count, time::get_clock_milliseconds);
+    bench_clock("clock microseconds", count, time::get_clock_microseconds);
+    bench_clock("timestamp now time", count, time::timestamp::now_time);
+    bench_clock("tsc clock nanoseconds", count, time::get_tsc_clock_nanoseconds);
+    time::update_cached_clock_milliseconds();
+    bench_clock("cached clock milliseconds", count, time::get_cached_clock_milliseconds);
+
+    // Tsc clock should go with steady clock.
+    uint64_t tsc_beg = time::get_tsc_clock_nanoseconds();
+    uint64_t ns_beg = now_ns();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    uint64_t tsc_end = time::get_tsc_clock_nanoseconds();
+    uint64_t ns_end = now_ns();
+    printf("tsc clock elapsed %lld ns, steady clock elapsed %lld ns\n",
+           (long long)(tsc_end - tsc_beg),
+           (long long)(ns_end - ns_beg));
+}
+
+static void on_lifetime_timeout() {
+}
+
+void start_timer_lifetime() {
+    service *sv = new service;
+    sv->start();
+
+    // Timers are in service queue, poller queue and high resolution queue, some of them
+    // are repeated so they are still in queues when service is deleted.
+    std::vector<time::timer_sptr> timers;
+    for (int32_t i = 0; i < 6; i++) {
+        bool repeated = i % 2 == 0;
+        time::timer_sptr t;
+        if (i < 4) {
+            t = time::timer::create(1000 * (i + 1), on_lifetime_timeout, repeated);
+        } else {
+            t = time::timer::create_high_resolution(1000000, on_lifetime_timeout, repeated);
+        }
+        bool started = (i == 2 || i == 3) ? sv->start_timer(t, READ_POLLER) : sv->start_timer(t);
+        if (!started) {
+            printf("timer lifetime: start timer %d failed\n", i);
+        }
+        timers.push_back(t);
+    }
+
+    sv->stop();
+    sv->wait_stopped();
+    delete sv;
+
+    // Timer queues are released with service, stopping and destroying timers must not
+    // touch them.
+    for (size_t i = 0; i < timers.size(); i += 2) {
+        timers[i]->stop();
+    }
+    timers.clear();
+
+    printf("timer lifetime ok\n");
+}
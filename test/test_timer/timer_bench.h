@@ -0,0 +1,16 @@
+#ifndef timer_bench_h
+#define timer_bench_h
+
+#include <stdint.h>
+
+extern void start_timer_bench(int64_t count);
+
+extern void start_timer_accuracy(int64_t count);
+
+extern void start_timer_dispatch(int32_t workers);
+
+extern void start_clock_bench(int64_t count);
+
+extern void start_timer_lifetime();
+
+#endif
@@ -1,5 +1,6 @@
 #include <pump/init.h>
 
+#include "rudp_transport_test.h"
 #include "tcp_transport_test.h"
 #include "tls_transport_test.h"
 #include "udp_transport_test.h"
@@ -49,6 +50,37 @@ int main(int argc, const char **argv) {
         client.join();
     }
 
+    if (tag == "tlshs") {
+        printf("start tls handshake test\n");
+
+        // Server side takes crypto worker count from the argument after conn count
+        int32_t crypto_workers = argc > 6 ? atoi(argv[6]) : 0;
+
+        std::thread server([=]() {
+            if (tp == "s") start_tls_handshake_server(ip, port, "cert.pem", "key.pem", crypto_workers);
+        });
+
+        std::thread client([=]() {
+            if (tp == "c") start_tls_handshake_client(ip, port, conn_count);
+        });
+
+        server.join();
+        client.join();
+    }
+
+    if (tag == "rudplossy") {
+        printf("start rudp lossy test\n");
+
+        // Last argument is sent data size in KB
+        start_rudp_lossy_test(argc > 5 ? conn_count : 1024);
+    }
+
+    if (tag == "udpdemux") {
+        printf("start udp demuxer test\n");
+
+        start_udp_demuxer_test(ip, port, conn_count);
+    }
+
     if (tag == "udp") {
         printf("start udp test\n");
 
@@ -0,0 +1,253 @@
+#include "rudp_transport_test.h"
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <thread>
+
+#include <pump/time/timestamp.h>
+
+static service *sv;
+
+/*********************************************************************************
+ * Lossy link
+ * Lossy link is an in-process datagram transport, it drops and reorders datagrams
+ * sent to the peer link. Datagrams are delivered by a delivery thread.
+ ********************************************************************************/
+class lossy_link : public base_transport {
+  public:
+    lossy_link(int32_t loss_percent, int32_t reorder_percent, uint32_t seed)
+      : base_transport(UDP_SESSION, nullptr, -1),
+        peer_(nullptr),
+        loss_percent_(loss_percent),
+        reorder_percent_(reorder_percent),
+        seed_(seed),
+        sent_(0),
+        dropped_(0),
+        reordered_(0) {
+    }
+
+    void connect(lossy_link *peer) {
+        peer_ = peer;
+    }
+
+    virtual int32_t start(service_ptr sv, const transport_callbacks &cbs) override {
+        cbs_ = cbs;
+        __set_service(sv);
+        __set_state(TRANSPORT_INITED, TRANSPORT_STARTED);
+        return ERROR_OK;
+    }
+
+    virtual void stop() override {
+        if (__set_state(TRANSPORT_STARTED, TRANSPORT_STOPPED)) {
+            cbs_.stopped_cb();
+        }
+    }
+
+    virtual void force_stop() override {
+        stop();
+    }
+
+    virtual int32_t read_for_loop() override {
+        return ERROR_OK;
+    }
+
+    virtual int32_t send(const block_t *b, int32_t size) override {
+        if (!is_started()) {
+            return ERROR_UNSTART;
+        }
+
+        sent_++;
+        if (int32_t(__random() % 100) < loss_percent_) {
+            dropped_++;
+            return ERROR_OK;
+        }
+
+        std::lock_guard<std::mutex> lock(mx_);
+        queue_.push_back(std::string(b, size));
+        if (queue_.size() > 1 && int32_t(__random() % 100) < reorder_percent_) {
+            std::swap(queue_[queue_.size() - 1], queue_[queue_.size() - 2]);
+            reordered_++;
+        }
+
+        return ERROR_OK;
+    }
+
+    void deliver() {
+        std::deque<std::string> datagrams;
+        {
+            std::lock_guard<std::mutex> lock(mx_);
+            datagrams.swap(queue_);
+        }
+        for (auto &datagram : datagrams) {
+            if (peer_->is_started()) {
+                peer_->cbs_.read_cb(datagram.data(), (int32_t)datagram.size());
+            }
+        }
+    }
+
+    int32_t get_sent() const {
+        return sent_;
+    }
+
+    int32_t get_dropped() const {
+        return dropped_;
+    }
+
+    int32_t get_reordered() const {
+        return reordered_;
+    }
+
+  protected:
+    virtual void __close_transport_flow() override {
+    }
+
+  private:
+    uint32_t __random() {
+        seed_ = seed_ * 1103515245 + 12345;
+        return seed_ >> 8;
+    }
+
+  private:
+    lossy_link *peer_;
+    int32_t loss_percent_;
+    int32_t reorder_percent_;
+    uint32_t seed_;
+    int32_t sent_;
+    int32_t dropped_;
+    int32_t reordered_;
+    std::mutex mx_;
+    std::deque<std::string> queue_;
+};
+
+static std::atomic_int32_t received(0);
+static std::atomic_int32_t corrupted(0);
+
+static void on_received(const block_t *b, int32_t size) {
+    int32_t offset = received.load();
+    for (int32_t i = 0; i < size; i++) {
+        if ((uint8_t)b[i] != (uint8_t)((offset + i) % 251)) {
+            corrupted.fetch_add(1);
+            break;
+        }
+    }
+    received.fetch_add(size);
+}
+
+static void on_ignored(const block_t *b, int32_t size) {
+}
+
+static void on_closed() {
+}
+
+static bool run_rudp_lossy(const char *name,
+                           int32_t loss_percent,
+                           int32_t reorder_percent,
+                           int32_t pacing,
+                           int32_t total) {
+    received.store(0);
+    corrupted.store(0);
+
+    std::shared_ptr<lossy_link> link_a(new lossy_link(loss_percent, reorder_percent, 1));
+    std::shared_ptr<lossy_link> link_b(new lossy_link(loss_percent, reorder_percent, 2));
+    link_a->connect(link_b.get());
+    link_b->connect(link_a.get());
+
+    rudp_options opts;
+    opts.interval = 5;
+    opts.min_rto = 20;
+    opts.pacing = pacing;
+
+    rudp_transport_sptr sender = rudp_transport::create(link_a, opts);
+    rudp_transport_sptr receiver = rudp_transport::create(link_b, opts);
+
+    pump::transport_callbacks cbs;
+    cbs.disconnected_cb = pump_bind(&on_closed);
+    cbs.stopped_cb = pump_bind(&on_closed);
+    cbs.read_cb = pump_bind(&on_ignored, _1, _2);
+    if (sender->start(sv, cbs) != ERROR_OK) {
+        printf("rudp sender start error\n");
+        return false;
+    }
+    cbs.read_cb = pump_bind(&on_received, _1, _2);
+    if (receiver->start(sv, cbs) != ERROR_OK) {
+        printf("rudp receiver start error\n");
+        return false;
+    }
+    receiver->read_for_loop();
+
+    std::atomic_bool delivering(true);
+    std::thread delivery([&]() {
+        while (delivering.load()) {
+            link_a->deliver();
+            link_b->deliver();
+#if defined(WIN32)
+            Sleep(1);
+#else
+            usleep(1000);
+#endif
+        }
+    });
+
+    uint64_t beg = time::get_clock_milliseconds();
+
+    char buf[5000];
+    for (int32_t sent = 0; sent < total; sent += sizeof(buf)) {
+        for (int32_t i = 0; i < (int32_t)sizeof(buf); i++) {
+            buf[i] = (char)((sent + i) % 251);
+        }
+        sender->send(buf, sizeof(buf));
+    }
+    total = (total + sizeof(buf) - 1) / sizeof(buf) * sizeof(buf);
+
+    for (int32_t i = 0; i < 3000 && received.load() < total; i++) {
+#if defined(WIN32)
+        Sleep(10);
+#else
+        usleep(10000);
+#endif
+    }
+
+    uint64_t end = time::get_clock_milliseconds();
+
+    delivering.store(false);
+    delivery.join();
+
+    bool ok = received.load() == total && corrupted.load() == 0;
+    printf("rudp %s: %d/%d bytes in %dms, %d datagrams %d dropped %d reordered, %s\n",
+           name,
+           received.load(),
+           total,
+           int32_t(end - beg),
+           link_a->get_sent(),
+           link_a->get_dropped(),
+           link_a->get_reordered(),
+           ok ? "ok" : "failed");
+
+    sender->stop();
+    receiver->stop();
+
+    return ok;
+}
+
+void start_rudp_lossy_test(int32_t kbytes) {
+    sv = new service;
+    sv->start();
+
+    int32_t total = kbytes * 1024;
+
+    bool ok = run_rudp_lossy("lossless", 0, 0, 0, total);
+    // Lost segments are retransmitted by timeout and fast retransmit.
+    ok = run_rudp_lossy("loss", 10, 0, 0, total) && ok;
+    // Reordered segments are buffered until continuous.
+    ok = run_rudp_lossy("reorder", 0, 30, 0, total) && ok;
+    // Most segments are retransmitted several times.
+    ok = run_rudp_lossy("retransmit", 40, 20, 0, total) && ok;
+    // Paced sending shares the budget of every update interval.
+    ok = run_rudp_lossy("pacing", 5, 5, 16, total) && ok;
+
+    printf("rudp lossy test %s\n", ok ? "ok" : "failed");
+
+    sv->stop();
+    sv->wait_stopped();
+}
@@ -0,0 +1,17 @@
+#ifndef rudp_transport_test_h
+#define rudp_transport_test_h
+
+#include <pump/service.h>
+#include <pump/time/timer.h>
+#include <pump/transport/rudp_transport.h>
+#include <stdio.h>
+
+namespace pump {
+using namespace transport;
+}
+
+using namespace pump;
+
+extern void start_rudp_lossy_test(int32_t kbytes);
+
+#endif
@@ -0,0 +1,217 @@
+#include "tls_transport_test.h"
+
+#include <map>
+#include <future>
+
+#include <pump/time/timestamp.h>
+
+static service *sv;
+
+class my_tls_handshake_acceptor {
+  public:
+    /*********************************************************************************
+     * Tls accepted event callback
+     ********************************************************************************/
+    void on_accepted_callback(base_transport_sptr &transp) {
+        pump::transport_callbacks cbs;
+        cbs.read_cb = pump_bind(&my_tls_handshake_acceptor::on_read_callback, this, _1, _2);
+        cbs.stopped_cb =
+            pump_bind(&my_tls_handshake_acceptor::on_closed_callback, this, transp.get());
+        cbs.disconnected_cb =
+            pump_bind(&my_tls_handshake_acceptor::on_closed_callback, this, transp.get());
+
+        if (transp->start(sv, cbs) != 0) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mx_);
+            transports_[transp.get()] = transp;
+        }
+
+        transp->read_for_loop();
+
+        // Send one byte, then client will receive tls 1.3 session ticket when reading.
+        transp->send("x", 1);
+    }
+
+    /*********************************************************************************
+     * Stopped accepting event callback
+     ********************************************************************************/
+    void on_stopped_accepting_callback() {
+    }
+
+    /*********************************************************************************
+     * Tls read event callback
+     ********************************************************************************/
+    void on_read_callback(const block_t *b, int32_t size) {
+    }
+
+    /*********************************************************************************
+     * Tls disconnected or stopped event callback
+     ********************************************************************************/
+    void on_closed_callback(base_transport_ptr transp) {
+        std::lock_guard<std::mutex> lock(mx_);
+        transports_.erase(transp);
+    }
+
+  private:
+    std::mutex mx_;
+    std::map<void_ptr, base_transport_sptr> transports_;
+};
+
+void start_tls_handshake_server(const std::string &ip, uint16_t port,
+                                const std::string &cert_file,
+                                const std::string &key_file,
+                                int32_t crypto_workers) {
+    sv = new service;
+    sv->set_crypto_worker_count(crypto_workers);
+    sv->start();
+
+    address listen_address(ip, port);
+    tls_acceptor_sptr acceptor =
+        tls_acceptor::create_with_file(cert_file, key_file, listen_address, 1000);
+    if (!acceptor->set_session_cache(ssl::tls_session_cache::create()) ||
+        !acceptor->enable_session_ticket(3600 * 1000)) {
+        printf("tls session resumption not supported\n");
+    }
+
+    my_tls_handshake_acceptor *my_acceptor = new my_tls_handshake_acceptor;
+
+    pump::acceptor_callbacks cbs;
+    cbs.accepted_cb =
+        pump_bind(&my_tls_handshake_acceptor::on_accepted_callback, my_acceptor, _1);
+    cbs.stopped_cb =
+        pump_bind(&my_tls_handshake_acceptor::on_stopped_accepting_callback, my_acceptor);
+
+    if (acceptor->start(sv, cbs) != 0) {
+        printf("tls acceptor start error\n");
+    }
+
+    sv->wait_stopped();
+}
+
+class my_tls_handshake_dialer
+  : public std::enable_shared_from_this<my_tls_handshake_dialer> {
+  public:
+    my_tls_handshake_dialer() {
+        resumed_ = false;
+        done_flag_.clear();
+    }
+
+    /*********************************************************************************
+     * Dial and wait until the first byte read
+     ********************************************************************************/
+    bool dial(void_ptr xcred,
+              const address &remote_address,
+              ssl::tls_session_cache_sptr &cache) {
+        address bind_address("0.0.0.0", 0);
+        tls_dialer_sptr dialer =
+            tls_dialer::create_with_cred(xcred, bind_address, remote_address, 1000, 1000);
+        dialer->set_session_cache(cache);
+
+        auto self = shared_from_this();
+        pump::dialer_callbacks cbs;
+        cbs.dialed_cb = pump_bind(&my_tls_handshake_dialer::on_dialed_callback, self, _1, _2);
+        cbs.stopped_cb = pump_bind(&my_tls_handshake_dialer::on_done, self, false);
+        cbs.timeouted_cb = pump_bind(&my_tls_handshake_dialer::on_done, self, false);
+
+        if (dialer->start(sv, cbs) != 0) {
+            return false;
+        }
+
+        bool succ = done_.get_future().get();
+        if (transport_) {
+            transport_->force_stop();
+        }
+        return succ;
+    }
+
+    /*********************************************************************************
+     * Tls dialed event callback
+     ********************************************************************************/
+    void on_dialed_callback(base_transport_sptr &transp, bool succ) {
+        if (!succ) {
+            on_done(false);
+            return;
+        }
+
+        transport_ = std::static_pointer_cast<tls_transport>(transp);
+
+        auto self = shared_from_this();
+        pump::transport_callbacks cbs;
+        cbs.read_cb = pump_bind(&my_tls_handshake_dialer::on_read_callback, self, _1, _2);
+        cbs.stopped_cb = pump_bind(&my_tls_handshake_dialer::on_done, self, false);
+        cbs.disconnected_cb = pump_bind(&my_tls_handshake_dialer::on_done, self, false);
+
+        if (transport_->start(sv, cbs) != 0 || transport_->read_for_once() != 0) {
+            on_done(false);
+        }
+    }
+
+    /*********************************************************************************
+     * Tls read event callback
+     ********************************************************************************/
+    void on_read_callback(const block_t *b, int32_t size) {
+        resumed_ = transport_->is_session_resumed();
+        on_done(true);
+    }
+
+    /*********************************************************************************
+     * Dial done
+     ********************************************************************************/
+    void on_done(bool succ) {
+        if (!done_flag_.test_and_set()) {
+            done_.set_value(succ);
+        }
+    }
+
+  public:
+    bool resumed_;
+
+  private:
+    tls_transport_sptr transport_;
+    std::promise<bool> done_;
+    std::atomic_flag done_flag_;
+};
+
+static void run_tls_handshake(void_ptr xcred,
+                              const address &remote_address,
+                              ssl::tls_session_cache_sptr cache,
+                              int32_t conn_count) {
+    int32_t succ_count = 0;
+    int32_t resumed_count = 0;
+    uint64_t beg = time::get_clock_milliseconds();
+    for (int32_t i = 0; i < conn_count; i++) {
+        std::shared_ptr<my_tls_handshake_dialer> dialer(new my_tls_handshake_dialer);
+        if (dialer->dial(xcred, remote_address, cache)) {
+            succ_count++;
+            if (dialer->resumed_) {
+                resumed_count++;
+            }
+        }
+    }
+    uint64_t cost = time::get_clock_milliseconds() - beg;
+
+    printf("tls handshake %s resumption: %d/%d succeeded, %d resumed, %.1f handshakes/s\n",
+           cache ? "with" : "without",
+           succ_count,
+           conn_count,
+           resumed_count,
+           cost > 0 ? succ_count * 1000.0 / cost : 0.0);
+}
+
+void start_tls_handshake_client(const std::string &ip, uint16_t port, int32_t conn_count) {
+    sv = new service;
+    sv->start();
+
+    void_ptr xcred = ssl::create_tls_client_certificate();
+
+    address remote_address(ip, port);
+    run_tls_handshake(xcred, remote_address, ssl::tls_session_cache_sptr(), conn_count);
+    run_tls_handshake(xcred, remote_address, ssl::tls_session_cache::create(), conn_count);
+
+    ssl::destory_tls_certificate(xcred);
+
+    sv->stop();
+}
@@ -20,4 +20,11 @@ extern void start_tls_server(const std::string &ip, uint16_t port,
 
 extern void start_tls_client(const std::string &ip, uint16_t port, int32_t conn_count);
 
+extern void start_tls_handshake_server(const std::string &ip, uint16_t port,
+                                       const std::string &cert_file,
+                                       const std::string &key_file,
+                                       int32_t crypto_workers);
+
+extern void start_tls_handshake_client(const std::string &ip, uint16_t port, int32_t conn_count);
+
 #endif
\ No newline at end of file
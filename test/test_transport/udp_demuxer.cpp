@@ -0,0 +1,126 @@
+#include "udp_transport_test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+static service *sv;
+
+static std::atomic_int32_t accepted_count(0);
+
+static void on_demuxer_stopped() {
+}
+
+static void on_session_read(const block_t *b, int32_t size) {
+}
+
+static void on_session_disconnected() {
+}
+
+static void on_session_stopped() {
+}
+
+static void on_source_read(const block_t *b, int32_t size, const address &from_address) {
+}
+
+static void on_source_stopped() {
+}
+
+static void on_accepted(bool start_session, base_transport_sptr &transp) {
+    accepted_count.fetch_add(1);
+    if (start_session) {
+        pump::transport_callbacks cbs;
+        cbs.read_cb = pump_bind(&on_session_read, _1, _2);
+        cbs.disconnected_cb = pump_bind(&on_session_disconnected);
+        cbs.stopped_cb = pump_bind(&on_session_stopped);
+        transp->start(sv, cbs);
+    }
+}
+
+static int32_t send_from_sources(const std::string &ip, 
+                                 uint16_t port, 
+                                 int32_t source_count) {
+    pump::transport_callbacks cbs;
+    cbs.read_from_cb = pump_bind(&on_source_read, _1, _2, _3);
+    cbs.stopped_cb = pump_bind(&on_source_stopped);
+
+    std::vector<udp_transport_sptr> sources;
+    for (int32_t i = 0; i < source_count; i++) {
+        udp_transport_sptr transport = udp_transport::create(address(ip, 0));
+        if (transport->start(sv, cbs) != 0) {
+            printf("udp source start error\n");
+            break;
+        }
+        sources.push_back(transport);
+    }
+
+    char buf[64] = {0};
+    address addr(ip, port);
+    for (auto &transport : sources) {
+        transport->send(buf, sizeof(buf), addr);
+    }
+
+    // Wait datagrams arriving.
+    for (int32_t i = 0; i < 200 && accepted_count.load() < (int32_t)sources.size(); i++) {
+#if defined(WIN32)
+        Sleep(10);
+#else
+        usleep(10000);
+#endif
+    }
+
+    for (auto &transport : sources) {
+        transport->stop();
+    }
+
+    return (int32_t)sources.size();
+}
+
+static bool run_udp_demuxer(const std::string &ip, 
+                            uint16_t port, 
+                            int32_t source_count,
+                            int32_t max_sessions,
+                            bool start_session) {
+    accepted_count.store(0);
+
+    udp_demuxer_sptr demuxer = udp_demuxer::create(address(ip, port), 0, 0, max_sessions);
+
+    pump::acceptor_callbacks cbs;
+    cbs.accepted_cb = pump_bind(&on_accepted, start_session, _1);
+    cbs.stopped_cb = pump_bind(&on_demuxer_stopped);
+    if (demuxer->start(sv, cbs) != 0) {
+        printf("udp demuxer start error\n");
+        return false;
+    }
+
+    int32_t sent = send_from_sources(ip, port, source_count);
+
+    int32_t expected = start_session ? std::min(sent, max_sessions) : 0;
+    int32_t session_count = demuxer->get_session_count();
+    printf("udp demuxer %s sessions: %d sources %d accepted %d sessions, expected %d\n",
+           start_session ? "started" : "unstarted",
+           sent,
+           accepted_count.load(),
+           session_count,
+           expected);
+
+    demuxer->stop();
+
+    return session_count == expected;
+}
+
+void start_udp_demuxer_test(const std::string &ip, uint16_t port, int32_t source_count) {
+    sv = new service;
+    sv->start();
+
+    // Sessions not started in accepted callback must not be kept.
+    bool ok = run_udp_demuxer(ip, port, source_count, UDP_DEMUXER_MAX_SESSIONS, false);
+
+    // Started sessions are capped by max sessions.
+    ok = run_udp_demuxer(ip, port + 1, source_count, source_count / 2, true) && ok;
+
+    printf("udp demuxer test %s\n", ok ? "ok" : "failed");
+
+    sv->stop();
+    sv->wait_stopped();
+}
@@ -3,6 +3,7 @@
 
 #include <pump/service.h>
 #include <pump/time/timer.h>
+#include <pump/transport/udp_demuxer.h>
 #include <pump/transport/udp_transport.h>
 #include <stdio.h>
 
@@ -16,4 +17,6 @@ extern void start_udp_server(const std::string &ip, uint16_t port);
 
 extern void start_udp_client(const std::string &ip, uint16_t port);
 
+extern void start_udp_demuxer_test(const std::string &ip, uint16_t port, int32_t source_count);
+
 #endif
\ No newline at end of file